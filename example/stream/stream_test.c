@@ -10,7 +10,7 @@ int main(void)
   zStreamOpenFile( &stream1, __FILE__, "r" );
   printf( ">> done.\n" );
   printf( ">> assign a memory space to stream 2..." );
-  zStreamOpenMem( &stream2, 1000 );
+  zStreamOpenGrowMem( &stream2, 0 );
   printf( ">> done.\n" );
 
   printf( ">> reading stream 1, and copying them to stream 2...\n" );
@@ -8,6 +8,8 @@
  ZEDA is a collection of frequently used structures and
  functions including:
  - bit operations
+ - LZ-style block compression
+ - compression of time series
  - array operation
  - list operation
  - tree operation
@@ -25,6 +27,8 @@
 #define __ZEDA_H__
 
 #include <zeda/zeda_binfile.h>
+#include <zeda/zeda_lz.h>
+#include <zeda/zeda_tscodec.h>
 
 #include <zeda/zeda_option.h>
 
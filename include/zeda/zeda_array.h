@@ -22,12 +22,14 @@ __BEGIN_DECLS
  * \brief generate array class.
  *
  * A macro zArrayClass() can generate a new array class, which
- * consists of the size of the array and the pointer to the array
- * buffer.
+ * consists of the size of the array, the capacity of the array
+ * buffer and the pointer to the array buffer.
  * \a array_t is the class name to be defined.
  * \a cell_t is the class name of the data to be arrayed.
  *
  * The size of the array is acquired by zArraySize().
+ * The number of cells allocated for the array buffer, which is no
+ * less than the size, is acquired by zArrayCapacity().
  * The array head can be accessed by zArrayBuf().
  * Each element can be accessed by zArrayElem().
  * For a faster access to each element, zArrayElemNC() is also
@@ -47,17 +49,20 @@ __BEGIN_DECLS
 #define zArrayClass(array_t,cell_t) \
 struct array_t{\
   uint size;\
+  uint capacity;\
   cell_t *buf;\
 }
 #else
 #define zArrayClass(array_t,cell_t) \
 typedef struct{\
   uint size;\
+  uint capacity;\
   cell_t *buf;\
 } array_t
 #endif /* __cplusplus */
 
 #define zArraySize(a)          (a)->size
+#define zArrayCapacity(a)      (a)->capacity
 #define zArrayBuf(a)           (a)->buf
 
 #define zArrayPosIsValid(a,p)  ( (p) < zArraySize(a) && (p) >= 0 )
@@ -75,7 +80,7 @@ typedef struct{\
 #define zArrayTail(a)          zArrayElemNC( a, 0 )
 
 #define zArrayInit(arr) do{\
-  zArraySize(arr) = 0;\
+  zArraySize(arr) = zArrayCapacity(arr) = 0;\
   zArrayBuf(arr) = NULL;\
 } while(0)
 /*! \brief allocate an array.
@@ -88,9 +93,9 @@ typedef struct{\
   else{\
     if( !( zArrayBuf(arr) = zAlloc( type, n ) ) ){\
       ZALLOCERROR();\
-      zArraySize(arr) = 0;\
+      zArraySize(arr) = zArrayCapacity(arr) = 0;\
     } else\
-      zArraySize(arr) = (n);\
+      zArraySize(arr) = zArrayCapacity(arr) = (n);\
   }\
 } while(0)
 
@@ -113,6 +118,84 @@ typedef struct{\
  * the following methods are only available in user space.
  */
 
+/*! \brief reserve and shrink the buffer of an array.
+ *
+ * zArrayReserve() enlarges the buffer of an array \a arr so that it
+ * can store \a n cells without reallocation. It does nothing if the
+ * capacity of \a arr is already no less than \a n.
+ * zArrayShrinkToFit() shrinks the buffer of \a arr to its size.
+ * \a type is the data type of the cell.
+ *
+ * Note that zArrayAdd(), zArrayInsert(), zArrayInsertRange() and
+ * zArrayAppend() enlarge the buffer geometrically, namely, at least
+ * twice as large as the current capacity, so that building an array
+ * of N cells costs only O(log N) reallocations. zArrayDelete() and
+ * zArrayEraseRange() do not shrink the buffer.
+ */
+#define zArrayReserve(arr,type,n) do{\
+  type *__zarray_ap;\
+  if( (n) > zArrayCapacity(arr) ){\
+    if( !( __zarray_ap = zRealloc( zArrayBuf(arr), type, n ) ) )\
+      ZALLOCERROR();\
+    else{\
+      zArrayBuf(arr) = __zarray_ap;\
+      zArrayCapacity(arr) = (n);\
+    }\
+  }\
+} while(0)
+
+#define zArrayShrinkToFit(arr,type) do{\
+  type *__zarray_ap;\
+  if( zArraySize(arr) == 0 ){\
+    zArrayFree( arr );\
+  } else if( zArrayCapacity(arr) > zArraySize(arr) ){\
+    if( ( __zarray_ap = zRealloc( zArrayBuf(arr), type, zArraySize(arr) ) ) ){\
+      zArrayBuf(arr) = __zarray_ap;\
+      zArrayCapacity(arr) = zArraySize(arr);\
+    }\
+  }\
+} while(0)
+
+/* enlarge the buffer of an array geometrically. */
+#define _zArrayGrow(arr,type,n) do{\
+  if( (n) > zArrayCapacity(arr) )\
+    zArrayReserve( arr, type, zMax( zArrayCapacity(arr)*2, (n) ) );\
+} while(0)
+
+/*! \brief insert and erase a range of cells of an array.
+ *
+ * zArrayInsertRange() inserts \a n cells pointed by \a dat into an array
+ * \a arr at the location specified by \a pos, which can be the size of
+ * \a arr to add cells at the last.
+ * zArrayEraseRange() erases \a n cells from the location specified by
+ * \a pos in \a arr.
+ * The cells after \a pos are moved at once.
+ * \a type is the data type of the cell.
+ */
+#define zArrayInsertRange(arr,type,pos,dat,n) do{\
+  if( (pos) < 0 || (pos) > zArraySize(arr) ){\
+    ZRUNWARN( "invalid position %d/%d in array specified", pos, zArraySize(arr) );\
+  } else if( (n) > 0 ){\
+    _zArrayGrow( arr, type, zArraySize(arr)+(n) );\
+    if( zArrayCapacity(arr) >= zArraySize(arr)+(n) ){\
+      if( (pos) < zArraySize(arr) )\
+        memmove( zArrayElemNC(arr,(pos)+(n)), zArrayElemNC(arr,pos), sizeof(type)*(zArraySize(arr)-(pos)) );\
+      memcpy( zArrayElemNC(arr,pos), (dat), sizeof(type)*(n) );\
+      zArraySize(arr) += (n);\
+    }\
+  }\
+} while(0)
+
+#define zArrayEraseRange(arr,type,pos,n) do{\
+  if( !zArrayPosIsValid(arr,pos) || (pos)+(n) > zArraySize(arr) ){\
+    ZRUNWARN( "invalid range %d-%d/%d in array specified", pos, (pos)+(n)-1, zArraySize(arr)-1 );\
+  } else{\
+    if( (pos)+(n) < zArraySize(arr) )\
+      memmove( zArrayElemNC(arr,pos), zArrayElemNC(arr,(pos)+(n)), sizeof(type)*(zArraySize(arr)-(pos)-(n)) );\
+    zArraySize(arr) -= (n);\
+  }\
+} while(0)
+
 /*! \brief add a new cell to an array.
  *
  * zArrayAdd() adds a new cell pointed by \a dat to an array
@@ -120,13 +203,9 @@ typedef struct{\
  * \a type is the data type of the cell.
  */
 #define zArrayAdd(arr,type,dat) do{\
-  type *__zarray_ap;\
-  __zarray_ap = zRealloc( zArrayBuf(arr), type, zArraySize(arr)+1 );\
-  if( __zarray_ap == NULL )\
-    ZALLOCERROR();\
-  else{\
+  _zArrayGrow( arr, type, zArraySize(arr)+1 );\
+  if( zArrayCapacity(arr) > zArraySize(arr) ){\
     zArraySize(arr)++;\
-    zArrayBuf(arr) = __zarray_ap;\
     zArraySetElemNC( arr, zArraySize(arr)-1, dat );\
   }\
 } while(0)
@@ -137,24 +216,7 @@ typedef struct{\
  * array \a arr at the location specified by \a pos, incrementing
  * the size of \a arr. \a type is the data type of the cell.
  */
-#define zArrayInsert(arr,type,pos,dat) do{\
-  type *__zarray_ap;\
-  if( (pos) == zArraySize(arr) ){\
-    zArrayAdd( arr, type, dat );\
-  } else if( zArrayPosIsValid(arr,pos) ){\
-    __zarray_ap = zRealloc( zArrayBuf(arr), type, zArraySize(arr)+1 );\
-    if( __zarray_ap == NULL )\
-      ZALLOCERROR();\
-    else{\
-      zArrayBuf(arr) = __zarray_ap;\
-      memmove( zArrayElemNC(arr,(pos)+1), zArrayElemNC(arr,pos), sizeof(type)*(zArraySize(arr)-(pos)) );\
-      zArraySetElemNC( arr, pos, dat );\
-      zArraySize(arr)++;\
-    }\
-  } else{\
-    ZRUNWARN( "invalid position %d/%d in array specified", pos, zArraySize(arr)-1 );\
-  }\
-} while(0)
+#define zArrayInsert(arr,type,pos,dat) zArrayInsertRange( arr, type, pos, dat, 1 )
 
 /*! \brief delete a cell from an array.
  *
@@ -163,21 +225,8 @@ typedef struct{\
  * \a type is the data type of the cell.
  */
 #define zArrayDelete(arr,type,pos) do{\
-  type *__zarray_ap;\
   if( zArrayPosIsValid(arr,pos) ){\
-    if( (pos) < zArraySize(arr)-1 )\
-      memmove( zArrayElemNC(arr,pos), zArrayElemNC(arr,(pos)+1), sizeof(type)*(zArraySize(arr)-(pos)-1) );\
-    if( zArraySize(arr) > 1 ){\
-      __zarray_ap = zRealloc( zArrayBuf(arr), type, zArraySize(arr)-1 );\
-      if( __zarray_ap == NULL )\
-        ZALLOCERROR();\
-      else{\
-        zArraySize(arr)--;\
-        zArrayBuf(arr) = __zarray_ap;\
-      }\
-    } else{\
-      zArrayFree( arr );\
-    }\
+    zArrayEraseRange( arr, type, pos, 1 );\
   } else{\
     ZRUNWARN( "invalid position %d/%d in array specified", pos, zArraySize(arr)-1 );\
   }\
@@ -189,17 +238,8 @@ typedef struct{\
  * to another array pointed by \a arr.
  * \a type is the data type of the cell.
  */
-#define zArrayAppend(arr,subarr,type) do{\
-  type *__zarray_ap;\
-  __zarray_ap = zRealloc( zArrayBuf(arr), type, zArraySize(arr)+zArraySize(subarr) );\
-  if( __zarray_ap == NULL )\
-    ZALLOCERROR();\
-  else{\
-    zArrayBuf(arr) = __zarray_ap;\
-    memcpy( zArrayElemNC(arr,zArraySize(arr)), zArrayBuf(subarr), zArraySize(subarr)*sizeof(type) );\
-    zArraySize(arr) += zArraySize(subarr);\
-  }\
-} while(0)
+#define zArrayAppend(arr,subarr,type) \
+  zArrayInsertRange( arr, type, zArraySize(arr), zArrayBuf(subarr), zArraySize(subarr) )
 
 #endif /* __KERNEL__ */
 
@@ -227,6 +267,365 @@ __EXPORT void zQuickSort(void *array, size_t nmemb, size_t size, int (*cmp)(void
  */
 #define zArrayQuickSort(arr,cmp,priv) zQuickSort( (void*)zArrayBuf(arr), zArraySize(arr), zArrayElemSize(arr), cmp, priv )
 
+#ifndef __KERNEL__
+/*! \brief default number of threads, maximum number of threads and
+ * default size of blocks for parallel sort. */
+#define ZARRAY_PSORT_THREAD_NUM 4
+#define ZARRAY_PSORT_MAX_THREAD 256
+#define ZARRAY_PSORT_CUTOFF     0x4000
+
+/*! \brief parallel sort for a pointer array.
+ *
+ * zParallelSort() sorts an array pointed by \a array with \a nthread
+ * threads. \a nmemb, \a size, \a cmp and \a priv have the same roles with
+ * those for zQuickSort().
+ * The array is divided into blocks of \a cutoff components, which are
+ * sorted by zQuickSort() in parallel, and the sorted blocks are merged
+ * bottom-up. Each merge is also divided into parts of the output, which
+ * are merged in parallel.
+ * If \a nthread is not positive or \a cutoff is zero, ZARRAY_PSORT_THREAD_NUM
+ * or ZARRAY_PSORT_CUTOFF is applied, respectively. An array with no more
+ * than \a cutoff components is sorted by zQuickSort() in the caller thread.
+ * An extra memory as large as \a array is used for the merge.
+ *
+ * The result is deterministic. Since blocks and merges are determined only
+ * by \a nmemb and \a cutoff, the order of components that compare equal is
+ * even independent of \a nthread.
+ * Without the thread library, it runs sequentially.
+ * \return
+ * zParallelSort() returns the true value if it succeeds. If it fails to
+ * allocate the working memory, the false value is returned and \a array
+ * is left unsorted.
+ * \sa
+ * zQuickSort()
+ */
+__EXPORT bool zParallelSort(void *array, size_t nmemb, size_t size, int (*cmp)(void*,void*,void*), void *priv, int nthread, size_t cutoff);
+
+/*! \brief parallel sort for an array.
+ *
+ * zArrayParallelSort() is a macro which is a wrapper of zParallelSort() that
+ * sorts an array \a arr with \a nthread threads.
+ */
+#define zArrayParallelSort(arr,cmp,priv,nthread) zParallelSort( (void*)zArrayBuf(arr), zArraySize(arr), zArrayElemSize(arr), cmp, priv, nthread, 0 )
+#endif /* __KERNEL__ */
+
+#ifndef __KERNEL__
+/*! \brief order-preserving unsigned keys of numbers.
+ *
+ * zRadixKeyInt32(), zRadixKeyInt64(), zRadixKeyFloat() and zRadixKeyDouble()
+ * convert a 32-bit signed integer, a 64-bit signed integer, a single-precision
+ * and a double-precision floating-point value \a val, respectively, to an
+ * unsigned integer key, so that the order of keys is the same with that of
+ * the original values. The sign bit of an integer is flipped. For a
+ * floating-point value, all bits of a negative value are flipped, and the
+ * sign bit of a non-negative value is flipped.
+ * The keys of a 32-bit integer and a single-precision value fit in the
+ * lower four bytes.
+ * They are supposed to be used in a key extractor for zRadixSortKey() and
+ * zRadixSortPerm().
+ * \return
+ * zRadixKeyInt32(), zRadixKeyInt64(), zRadixKeyFloat() and zRadixKeyDouble()
+ * return the converted key.
+ */
+__EXPORT uint64_t zRadixKeyInt32(int32_t val);
+__EXPORT uint64_t zRadixKeyInt64(int64_t val);
+__EXPORT uint64_t zRadixKeyFloat(float val);
+__EXPORT uint64_t zRadixKeyDouble(double val);
+
+/*! \brief radix sort for an array of numbers.
+ *
+ * zRadixSortInt32(), zRadixSortInt64(), zRadixSortFloat() and zRadixSortDouble()
+ * sort an array \a array of \a nmemb 32-bit signed integers, 64-bit signed
+ * integers, single-precision and double-precision floating-point values,
+ * respectively, in ascending order by LSD radix sort with 8-bit digits.
+ * Values are compared as the keys converted by zRadixKeyInt32(), zRadixKeyInt64(),
+ * zRadixKeyFloat() and zRadixKeyDouble(), so that -0 precedes +0, and NaNs are
+ * gathered at the head or the tail according to their sign bits.
+ * Passes on digits shared by all values are skipped.
+ * An extra memory as large as \a array (twice for floating-point values) is used.
+ * \return
+ * They return the true value if they succeed. If they fail to allocate the
+ * working memory, the false value is returned and \a array is left unsorted.
+ * \sa
+ * zRadixKeyInt32, zRadixKeyInt64, zRadixKeyFloat, zRadixKeyDouble, zQuickSort
+ */
+__EXPORT bool zRadixSortInt32(int32_t *array, size_t nmemb);
+__EXPORT bool zRadixSortInt64(int64_t *array, size_t nmemb);
+__EXPORT bool zRadixSortFloat(float *array, size_t nmemb);
+__EXPORT bool zRadixSortDouble(double *array, size_t nmemb);
+
+/*! \brief radix sort for an array with a key extractor.
+ *
+ * zRadixSortKey() sorts an array \a array of \a nmemb components of \a size
+ * bytes in ascending order of unsigned integer keys extracted from each
+ * component by a function \a key. The first argument of \a key is a pointer
+ * to a component, and the second is for a programmer's private data \a priv.
+ * Only the lower \a keysize bytes of keys are sorted. If \a keysize is out
+ * of [1, 8], 8 is applied.
+ * \a scratch is a working memory as large as \a array. If the null pointer is
+ * given for it, it is internally allocated.
+ *
+ * zRadixSortPerm() does not move components in \a array, but stores the
+ * sorting permutation to \a perm, namely, the \a i th component of the sorted
+ * array is the \a perm[i] th component of \a array. \a perm has to have
+ * \a nmemb components.
+ *
+ * The sort is stable. Keys are extracted only once for each component.
+ * \return
+ * zRadixSortKey() and zRadixSortPerm() return the true value if they succeed.
+ * If they fail to allocate the working memory, the false value is returned.
+ * \sa
+ * zRadixKeyInt32, zRadixKeyInt64, zRadixKeyFloat, zRadixKeyDouble
+ */
+__EXPORT bool zRadixSortKey(void *array, size_t nmemb, size_t size, uint64_t (*key)(void*,void*), void *priv, int keysize, void *scratch);
+__EXPORT bool zRadixSortPerm(void *array, size_t nmemb, size_t size, uint64_t (*key)(void*,void*), void *priv, int keysize, size_t *perm);
+#endif /* __KERNEL__ */
+
+#ifndef __KERNEL__
+/*! \brief size of runs sorted by insertion sort in merge sort. */
+#define ZARRAY_MSORT_RUN 16
+
+/*! \brief stable merge sort for a pointer array.
+ *
+ * zMergeSort() sorts an array pointed by \a array in a stable way, namely,
+ * components that compare equal remain in their original order.
+ * \a nmemb, \a size, \a cmp and \a priv have the same roles with those for
+ * zQuickSort().
+ * Runs of ZARRAY_MSORT_RUN components are sorted by a binary insertion sort,
+ * and then merged bottom-up without recursion. A merge is skipped if two
+ * runs are already in order, so that a nearly sorted array is sorted fast.
+ * It takes O(n log n) time even in the worst case.
+ *
+ * \a scratch is a working memory as large as \a array. If the null pointer is
+ * given for it, it is internally allocated.
+ * \return
+ * zMergeSort() returns the true value if it succeeds. If it fails to allocate
+ * the working memory, the false value is returned and \a array is left unsorted.
+ * \sa
+ * zQuickSort()
+ */
+__EXPORT bool zMergeSort(void *array, size_t nmemb, size_t size, int (*cmp)(void*,void*,void*), void *priv, void *scratch);
+
+/*! \brief stable merge sort for an array.
+ *
+ * zArrayMergeSort() is a macro which is a wrapper of zMergeSort() that sorts
+ * an array \a arr in a stable way with an internally allocated working memory.
+ */
+#define zArrayMergeSort(arr,cmp,priv) zMergeSort( (void*)zArrayBuf(arr), zArraySize(arr), zArrayElemSize(arr), cmp, priv, NULL )
+
+/*! \brief merge sorted arrays.
+ *
+ * zMergeSorted() merges \a k arrays pointed by \a src[0], ..., \a src[k-1],
+ * which are sorted in ascending order according to \a cmp in advance, into
+ * an array \a dest. \a nmemb[i] is the number of components of \a src[i], and
+ * \a size is the size of each component. \a dest has to have as many
+ * components as \a nmemb[0]+...+\a nmemb[k-1].
+ * Arrays are merged at once by choosing the least head of them in a heap, so
+ * that it takes O(n log k) time for n components in total. The merge is
+ * stable; components that compare equal are taken in order of arrays.
+ * \return
+ * zMergeSorted() returns the true value if it succeeds. If it fails to
+ * allocate the working memory, the false value is returned.
+ */
+__EXPORT bool zMergeSorted(void *dest, void **src, size_t *nmemb, int k, size_t size, int (*cmp)(void*,void*,void*), void *priv);
+#endif /* __KERNEL__ */
+
+#ifndef __KERNEL__
+/*! \brief selection of components of a pointer array.
+ *
+ * zNthElement() rearranges an array pointed by \a array so that the \a n th
+ * component is the one which would be there if \a array were sorted, and no
+ * component before it is greater and no component after it is less than it.
+ * zPartialSort() rearranges \a array so that the first \a k components are
+ * the \a k least components sorted in ascending order. The order of the
+ * rest is unspecified.
+ * \a nmemb, \a size, \a cmp and \a priv have the same roles with those for
+ * zQuickSort().
+ *
+ * zNthElement() is based on the introselect algorithm: a quick select with
+ * median-of-three pivots, which switches to a heap sort if partitions are
+ * unbalanced too many times. It takes O(n) time on average and O(n log n)
+ * time in the worst case. zPartialSort() sorts the first \a k components
+ * by a heap sort, so that it takes O(n + k log k) time on average and
+ * O(n log n) time in the worst case.
+ * \return
+ * zNthElement() returns a pointer to the \a n th component, or the null
+ * pointer if \a n is not less than \a nmemb.
+ * zPartialSort() returns no value.
+ * \sa
+ * zQuickSort()
+ */
+__EXPORT void *zNthElement(void *array, size_t nmemb, size_t size, size_t n, int (*cmp)(void*,void*,void*), void *priv);
+__EXPORT void zPartialSort(void *array, size_t nmemb, size_t size, size_t k, int (*cmp)(void*,void*,void*), void *priv);
+
+/*! \brief selection of components of an array.
+ *
+ * zArrayNthElement() and zArrayPartialSort() are macros which are wrappers
+ * of zNthElement() and zPartialSort() for an array \a arr, respectively.
+ */
+#define zArrayNthElement(arr,n,cmp,priv) zNthElement( (void*)zArrayBuf(arr), zArraySize(arr), zArrayElemSize(arr), n, cmp, priv )
+#define zArrayPartialSort(arr,k,cmp,priv) zPartialSort( (void*)zArrayBuf(arr), zArraySize(arr), zArrayElemSize(arr), k, cmp, priv )
+
+/*! \struct zTopK
+ * \brief accumulator of the k least members of a stream.
+ *
+ * zTopK keeps the \a k least members pushed so far according to a
+ * comparison function in a bounded max-heap, so that the least members of
+ * a stream of n members are selected in O(n log k) time with O(k) memory.
+ * zTopKSort() sorts them by a heap sort in O(k log k) time.
+ */
+typedef struct{
+  /*! \cond */
+  byte *buf;
+  size_t size, k, num;
+  int (* cmp)(void*,void*,void*);
+  void *priv;
+  /*! \endcond */
+} zTopK;
+
+/*! \brief the number of members kept in a top-k accumulator. */
+#define zTopKNum(t)   (t)->num
+/*! \brief the greatest member kept in a top-k accumulator, which is the threshold to be kept. */
+#define zTopKWorst(t) ( (t)->num > 0 ? (void *)(t)->buf : NULL )
+/*! \brief clear a top-k accumulator. */
+#define zTopKClear(t) ( (t)->num = 0 )
+
+/*! \brief initialize and destroy a top-k accumulator.
+ *
+ * zTopKInit() initializes a top-k accumulator \a topk to keep the \a k
+ * least members of \a size bytes. \a cmp and \a priv have the same roles
+ * with those for zQuickSort().
+ * zTopKDestroy() destroys \a topk.
+ * \return
+ * zTopKInit() returns the false value if it fails to allocate memory.
+ * Otherwise, the true value is returned.
+ */
+__EXPORT bool zTopKInit(zTopK *topk, size_t k, size_t size, int (*cmp)(void*,void*,void*), void *priv);
+__EXPORT void zTopKDestroy(zTopK *topk);
+
+/*! \brief push a member to a top-k accumulator.
+ *
+ * zTopKPush() pushes a copy of a member pointed by \a memb to a top-k
+ * accumulator \a topk. If \a topk is full, \a memb replaces the greatest
+ * member in \a topk if it is less than that, or is discarded otherwise.
+ * \return
+ * zTopKPush() returns the true value if \a memb is kept, or the false value
+ * if discarded.
+ */
+__EXPORT bool zTopKPush(zTopK *topk, void *memb);
+
+/*! \brief sorted members of a top-k accumulator.
+ *
+ * zTopKSort() copies members kept in a top-k accumulator \a topk to an array
+ * \a dest in ascending order. \a dest has to have at least zTopKNum(topk)
+ * components. \a topk is not modified, so that members can be pushed
+ * further.
+ * \return
+ * zTopKSort() returns the number of members copied.
+ */
+__EXPORT size_t zTopKSort(zTopK *topk, void *dest);
+#endif /* __KERNEL__ */
+
+/*! \brief number of cells under which an array is sorted by insertion sort. */
+#define ZARRAY_SORT_CUTOFF 16
+
+/*! \brief define a sort method specialized for an array class.
+ *
+ * zArraySortDef() defines a sort function for a given array class
+ * \a array_t of cells of \a type.
+ *
+ * The function defined will be named 'array_t'Sort() with the following
+ * prototype.
+ *
+ * \a array_t *array_tSort(\a array_t *arr);
+ *
+ * The cells of \a arr will be sorted in ascending order according to
+ * an expression \a cmp_expr, which has to be true if and only if a cell
+ * pointed by 'a' should be put before another pointed by 'b'. For
+ * example, an array of integers is sorted in ascending order by
+ * zArraySortDef( int_array_t, int, *a < *b ).
+ *
+ * The sort is an introsort: a quick sort with median-of-three pivots,
+ * which switches to a heap sort if the recursion goes too deep and to an
+ * insertion sort for short subarrays. Since \a cmp_expr is compiled in
+ * place and cells are moved as \a type (not byte by byte), it is much
+ * faster than zQuickSort(), while it is O(n log n) even in the worst case.
+ * Note that it is not stable.
+ */
+#define zArraySortDef(array_t,type,cmp_expr) \
+static int _##array_t##SortLess(const type *a, const type *b){ return (cmp_expr); }\
+static void _##array_t##SortSwap(type *a, type *b){\
+  type __zarray_tmp;\
+  __zarray_tmp = *a; *a = *b; *b = __zarray_tmp;\
+}\
+static void _##array_t##InsertionSort(type *buf, size_t n){\
+  size_t i, j;\
+  type __zarray_tmp;\
+  for( i=1; i<n; i++ ){\
+    __zarray_tmp = buf[i];\
+    for( j=i; j>0 && _##array_t##SortLess( &__zarray_tmp, &buf[j-1] ); j-- )\
+      buf[j] = buf[j-1];\
+    buf[j] = __zarray_tmp;\
+  }\
+}\
+static void _##array_t##SiftDown(type *buf, size_t i, size_t n){\
+  size_t c;\
+  for( ; ( c = 2*i+1 ) < n; i=c ){\
+    if( c+1 < n && _##array_t##SortLess( &buf[c], &buf[c+1] ) ) c++;\
+    if( !_##array_t##SortLess( &buf[i], &buf[c] ) ) break;\
+    _##array_t##SortSwap( &buf[i], &buf[c] );\
+  }\
+}\
+static void _##array_t##HeapSort(type *buf, size_t n){\
+  size_t i;\
+  for( i=n/2; i>0; i-- ) _##array_t##SiftDown( buf, i-1, n );\
+  for( i=n-1; i>0; i-- ){\
+    _##array_t##SortSwap( &buf[0], &buf[i] );\
+    _##array_t##SiftDown( buf, 0, i );\
+  }\
+}\
+static void _##array_t##IntroSort(type *buf, size_t n, int depth){\
+  size_t i, j, m;\
+  type __zarray_pivot;\
+  while( n > ZARRAY_SORT_CUTOFF ){\
+    if( depth-- == 0 ){\
+      _##array_t##HeapSort( buf, n );\
+      return;\
+    }\
+    /* median of three, which also places sentinels at both ends */\
+    m = n / 2;\
+    if( _##array_t##SortLess( &buf[m], &buf[0] ) ) _##array_t##SortSwap( &buf[m], &buf[0] );\
+    if( _##array_t##SortLess( &buf[n-1], &buf[m] ) ){\
+      _##array_t##SortSwap( &buf[n-1], &buf[m] );\
+      if( _##array_t##SortLess( &buf[m], &buf[0] ) ) _##array_t##SortSwap( &buf[m], &buf[0] );\
+    }\
+    __zarray_pivot = buf[m];\
+    for( i=0, j=n-1; ; ){\
+      do i++; while( _##array_t##SortLess( &buf[i], &__zarray_pivot ) );\
+      do j--; while( _##array_t##SortLess( &__zarray_pivot, &buf[j] ) );\
+      if( i >= j ) break;\
+      _##array_t##SortSwap( &buf[i], &buf[j] );\
+    }\
+    /* recurse into the smaller part, and loop on the larger part */\
+    j++;\
+    if( j < n - j ){\
+      _##array_t##IntroSort( buf, j, depth );\
+      buf += j; n -= j;\
+    } else{\
+      _##array_t##IntroSort( buf+j, n-j, depth );\
+      n = j;\
+    }\
+  }\
+  _##array_t##InsertionSort( buf, n );\
+}\
+array_t *array_t##Sort(array_t *arr){\
+  int depth = 0;\
+  size_t n;\
+  for( n=zArraySize(arr); n>1; n>>=1 ) depth += 2;\
+  _##array_t##IntroSort( zArrayBuf(arr), zArraySize(arr), depth );\
+  return arr;\
+}
+
 /*! \brief insert a member into a pointer array at sorted position.
  *
  * zInsertSort() inserts a new member \a memb into an array pointed by
@@ -238,6 +637,8 @@ __EXPORT void zQuickSort(void *array, size_t nmemb, size_t size, int (*cmp)(void
  * to the comparison function \a cmp. Namely, a factor 'a' in the \a array
  * is put after another factor 'b' if cmp(a,b,priv) > 0, where \a priv is
  * for programmer's utility.
+ * The location is found by a binary search, and the posterior components
+ * are moved at once.
  * \return
  * zInsertSort() returns a pointer \a memb in the case of success, or the
  * null pointer if \a i is larger than or equal to \a size.
@@ -255,6 +656,145 @@ __EXPORT void *zInsertSort(void *array, void *memb, uint i, size_t nmemb, size_t
  */
 #define zArrayInsertSort(arr,memb,i,cmp,priv) zInsertSort( (void*)zArrayBuf(arr), (memb), (i), zArraySize(arr), zArrayElemSize(arr), cmp, priv )
 
+/*! \brief define a sorted flat set on an array class.
+ *
+ * zArrayFlatSetDef() defines methods to use an array class \a array_t of
+ * cells of \a type, which has to be defined by zArrayClass() in advance,
+ * as a set of cells kept sorted without duplication. \a cmp_expr has to be
+ * true if and only if a cell pointed by 'a' is less than another pointed by
+ * 'b', and two cells are regarded as equivalent if neither is less than the
+ * other. The following functions are defined with 'array_t'Sort() defined by
+ * zArraySortDef().
+ *
+ * uint array_tLowerBound(array_t *set, const type *key);
+ * uint array_tUpperBound(array_t *set, const type *key);
+ *  return the location of the first cell not less than and greater than
+ *  \a key, respectively, or the size of \a set if there is no such a cell.
+ *
+ * type *array_tFind(array_t *set, const type *key);
+ *  returns a pointer to the cell equivalent to \a key, or the null pointer
+ *  if there is no such a cell.
+ *
+ * type *array_tInsert(array_t *set, const type *val);
+ *  inserts a copy of \a val at the sorted location, and returns a pointer to
+ *  it. If a cell equivalent to \a val already exists, it is not modified and
+ *  a pointer to it is returned. The null pointer is returned if it fails to
+ *  allocate memory.
+ *
+ * bool array_tErase(array_t *set, const type *key);
+ *  erases the cell equivalent to \a key. It returns the false value if there
+ *  is no such a cell.
+ *
+ * array_t *array_tBuild(array_t *set);
+ *  sorts cells of \a set which are stored in an arbitrary order, and removes
+ *  duplicates at once. Which one of equivalent cells remains is unspecified.
+ *  It is much faster than inserting cells one by one.
+ *
+ * The binary search is branchless so that the comparison is compiled to a
+ * conditional move, and it takes O(log n) time for a lookup. An insertion
+ * and an erasure move the posterior cells by one memmove().
+ */
+#define zArrayFlatSetDef(array_t,type,cmp_expr) \
+zArraySortDef( array_t, type, cmp_expr )\
+uint array_t##LowerBound(array_t *set, const type *key){\
+  const type *base;\
+  uint n, half;\
+  if( ( n = zArraySize(set) ) == 0 ) return 0;\
+  for( base=zArrayBuf(set); n>1; n-=half ){\
+    half = n / 2;\
+    base = _##array_t##SortLess( &base[half], key ) ? base + half : base;\
+  }\
+  return base - zArrayBuf(set) + ( _##array_t##SortLess( base, key ) ? 1 : 0 );\
+}\
+uint array_t##UpperBound(array_t *set, const type *key){\
+  const type *base;\
+  uint n, half;\
+  if( ( n = zArraySize(set) ) == 0 ) return 0;\
+  for( base=zArrayBuf(set); n>1; n-=half ){\
+    half = n / 2;\
+    base = _##array_t##SortLess( key, &base[half] ) ? base : base + half;\
+  }\
+  return base - zArrayBuf(set) + ( _##array_t##SortLess( key, base ) ? 0 : 1 );\
+}\
+type *array_t##Find(array_t *set, const type *key){\
+  uint pos;\
+  pos = array_t##LowerBound( set, key );\
+  return pos < zArraySize(set) && !_##array_t##SortLess( key, zArrayElemNC(set,pos) ) ?\
+    zArrayElemNC(set,pos) : NULL;\
+}\
+type *array_t##Insert(array_t *set, const type *val){\
+  uint pos, size;\
+  pos = array_t##LowerBound( set, val );\
+  if( pos < zArraySize(set) && !_##array_t##SortLess( val, zArrayElemNC(set,pos) ) )\
+    return zArrayElemNC(set,pos);\
+  size = zArraySize(set);\
+  zArrayInsertRange( set, type, pos, val, 1 );\
+  return zArraySize(set) > size ? zArrayElemNC(set,pos) : NULL;\
+}\
+bool array_t##Erase(array_t *set, const type *key){\
+  uint pos;\
+  pos = array_t##LowerBound( set, key );\
+  if( pos >= zArraySize(set) || _##array_t##SortLess( key, zArrayElemNC(set,pos) ) )\
+    return false;\
+  zArrayEraseRange( set, type, pos, 1 );\
+  return true;\
+}\
+array_t *array_t##Build(array_t *set){\
+  uint i, j;\
+  if( zArraySize(set) <= 1 ) return set;\
+  array_t##Sort( set );\
+  for( j=0, i=1; i<zArraySize(set); i++ )\
+    if( _##array_t##SortLess( zArrayElemNC(set,j), zArrayElemNC(set,i) ) )\
+      *zArrayElemNC(set,++j) = *zArrayElemNC(set,i);\
+  zArraySize(set) = j + 1;\
+  return set;\
+}
+
+/*! \brief generate a sorted flat map class.
+ *
+ * zArrayFlatMapClass() generates a new array class \a map_t of pairs of a
+ * key of \a key_t and a value of \a val_t, which is named 'map_t'Pair and
+ * has members 'key' and 'val'.
+ *
+ * zArrayFlatMapDef() defines methods of \a map_t as a sorted flat set of
+ * pairs ordered by keys, where \a cmp_expr has to be true if and only if a
+ * key pointed by 'a' is less than another pointed by 'b'. All the methods
+ * defined by zArrayFlatSetDef() are available, which take pointers to pairs.
+ * In addition, the following functions are defined.
+ *
+ * val_t *map_tGet(map_t *map, const key_t *key);
+ *  returns a pointer to the value associated with \a key, or the null
+ *  pointer if \a key is not found.
+ *
+ * val_t *map_tSet(map_t *map, const key_t *key, const val_t *val);
+ *  associates a copy of \a val with \a key. If \a key already exists, the
+ *  value is overwritten. It returns a pointer to the value in \a map, or the
+ *  null pointer if it fails to allocate memory.
+ */
+#define zArrayFlatMapClass(map_t,key_t,val_t) \
+typedef struct{\
+  key_t key;\
+  val_t val;\
+} map_t##Pair;\
+zArrayClass( map_t, map_t##Pair )
+
+#define zArrayFlatMapDef(map_t,key_t,val_t,cmp_expr) \
+static int _##map_t##KeyLess(const key_t *a, const key_t *b){ return (cmp_expr); }\
+zArrayFlatSetDef( map_t, map_t##Pair, _##map_t##KeyLess( &a->key, &b->key ) )\
+val_t *map_t##Get(map_t *map, const key_t *key){\
+  map_t##Pair *pair, __zarray_key;\
+  __zarray_key.key = *key;\
+  return ( pair = map_t##Find( map, &__zarray_key ) ) ? &pair->val : NULL;\
+}\
+val_t *map_t##Set(map_t *map, const key_t *key, const val_t *val){\
+  map_t##Pair *pair, __zarray_pair;\
+  __zarray_pair.key = *key;\
+  __zarray_pair.val = *val;\
+  if( !( pair = map_t##Insert( map, &__zarray_pair ) ) ) return NULL;\
+  pair->val = *val;\
+  return &pair->val;\
+}
+
 /*! \} */
 
 /* ********************************************************** */
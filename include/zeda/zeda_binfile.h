@@ -10,6 +10,8 @@
 #define __ZEDA_BINFILE_H__
 
 #include <zeda/zeda_bit.h>
+#include <zeda/zeda_array.h>
+#include <stddef.h>
 
 __BEGIN_DECLS
 
@@ -76,6 +78,7 @@ __EXPORT ZEDA_BINFILE_DEF_FWRITE_REV_TYPE_PROTOTYPE( double );
 
 /* binary-file manipulator */
 
+/* version 2 adds flags to the header, which is applied only when a flag is set */
 #define ZBINFILE_CURRENT_VERSION 0x00000001
 
 #define ZBINFILE_ID "ZBD "
@@ -85,28 +88,84 @@ __EXPORT ZEDA_BINFILE_DEF_FWRITE_REV_TYPE_PROTOTYPE( double );
 #define Z_ENDIAN_BIG     4321
 #define Z_ENDIAN_UNKNOWN 9999
 
+/* flags of ZBD files (version 2 or later) */
+#define ZBINFILE_FLAG_LZ     0x0001 /*!< payload compressed in blocks */
+#define ZBINFILE_FLAG_RECORD 0x0002 /*!< record index and schema in the footer */
+#define ZBINFILE_FLAG_CRC    0x0004 /*!< CRC-32C checksum of each block */
+
+#define ZBINFILE_DEFAULT_BLOCKSIZE 0x10000
+
+/* types of fields of records */
+#define ZBINFILE_TYPE_BYTE   0
+#define ZBINFILE_TYPE_INT    1
+#define ZBINFILE_TYPE_LONG   2
+#define ZBINFILE_TYPE_FLOAT  3
+#define ZBINFILE_TYPE_DOUBLE 4
+#define ZBINFILE_TYPE_DOUBLE_COLUMN 5 /* encoded column of double values */
+#define ZBINFILE_TYPE_INT64_COLUMN  6 /* encoded column of 64-bit integers */
+
+/*! \struct zBinFileField
+ * \brief a named typed field of records in a binary file.
+ */
+typedef struct{
+  char *name; /*!< name of the field */
+  int type;   /*!< type of values, ZBINFILE_TYPE_* */
+  int count;  /*!< number of values */
+} zBinFileField;
+
+/*! \struct zBinFileSchema
+ * \brief schema of records in a binary file, namely, an array of fields.
+ */
+zArrayClass( zBinFileSchema, zBinFileField );
+
 typedef struct _zBinFile{
   int16_t version;      /*!< ZBD file version */
+  int16_t flags;        /*!< ZBD file flags */
   /*! \cond */
   int16_t _endian_type; /* endian type */
   int16_t _size_int;    /* byte size of int */
   int16_t _size_long;   /* byte size of long */
+  int32_t _blocksize;   /* byte size of a block before compression */
   FILE *_fp;            /* file stream */
+  long _dataofs;        /* offset of the payload */
+  void *_blk;           /* block layer */
+  void *_rec;           /* record index */
+  void *_async;         /* asynchronous writer */
+  zBinFileSchema *_schema; /* schema of records to be written */
+  /* raw I/O methods */
+  size_t (* _read)(struct _zBinFile*,void*,size_t,size_t);
+  size_t (* _write)(struct _zBinFile*,const void*,size_t,size_t);
   /* I/O methods */
-  size_t (* _fread_int16)(FILE*,int16_t*);
-  size_t (* _fread_int32)(FILE*,int32_t*);
-  size_t (* _fread_int64)(FILE*,int64_t*);
+  size_t (* _fread_int16)(struct _zBinFile*,int16_t*);
+  size_t (* _fread_int32)(struct _zBinFile*,int32_t*);
+  size_t (* _fread_int64)(struct _zBinFile*,int64_t*);
   int (* _fread_int)(struct _zBinFile*);
   long (* _fread_long)(struct _zBinFile*);
 
-  size_t (* _fwrite_int16)(FILE*,int16_t*);
-  size_t (* _fwrite_int32)(FILE*,int32_t*);
-  size_t (* _fwrite_int64)(FILE*,int64_t*);
+  size_t (* _fwrite_int16)(struct _zBinFile*,int16_t*);
+  size_t (* _fwrite_int32)(struct _zBinFile*,int32_t*);
+  size_t (* _fwrite_int64)(struct _zBinFile*,int64_t*);
   size_t (* _fwrite_int)(struct _zBinFile*,int);
   size_t (* _fwrite_long)(struct _zBinFile*,long);
   /*! \endcond */
 } zBinFile;
 
+/*! \brief open and close a binary file.
+ *
+ * zBinFileInit() initializes a binary file \a bf with an opened file
+ * stream \a fp.
+ * zBinFileOpen() opens a binary file \a filename with a mode \a mode
+ * in the same way with fopen().
+ * zBinFileClose() closes a binary file \a bf. If the payload of \a bf
+ * is written in compressed blocks, the last block and the block index
+ * are written before closing it.
+ * \return
+ * zBinFileInit() returns no value.
+ * zBinFileOpen() returns the true value if it succeeds to open the file,
+ * or the false value otherwise.
+ * zBinFileClose() returns zero if it succeeds. Otherwise, EOF is returned.
+ */
+__EXPORT void zBinFileInit(zBinFile *bf, FILE *fp);
 __EXPORT bool zBinFileOpen(zBinFile *bf, char filename[], const char *mode);
 __EXPORT int zBinFileClose(zBinFile *bf);
 
@@ -119,6 +178,235 @@ __EXPORT size_t zBinFileHeaderFWrite(zBinFile *bf);
 __EXPORT void zBinFileInfoSet(zBinFile *bf, int16_t version, int16_t endian_type, int16_t size_int, int16_t size_long);
 __EXPORT void zBinFileInfoSetThis(zBinFile *bf);
 
+/*! \brief compress the payload of a binary file in blocks.
+ *
+ * zBinFileSetCompress() sets a flag of a binary file \a bf to write the
+ * payload in blocks of \a blocksize bytes, each of which is compressed
+ * by zLZCompress() and can be decompressed independently. If \a blocksize
+ * is zero, ZBINFILE_DEFAULT_BLOCKSIZE is applied. It has to be called
+ * between zBinFileInfoSet() or zBinFileInfoSetThis() and
+ * zBinFileHeaderFWrite(), which records the flag in the header.
+ * The offsets of blocks are written as an index at the end of the file
+ * by zBinFileClose().
+ *
+ * Readers need nothing special; zBinFileHeaderFRead() detects the flag
+ * and every reader decompresses blocks transparently.
+ *
+ * zBinFileIsCompressed() checks if the payload of \a bf is compressed.
+ * \return
+ * zBinFileSetCompress() returns no value.
+ */
+__EXPORT void zBinFileSetCompress(zBinFile *bf, int32_t blocksize);
+#define zBinFileIsCompressed(bf) ( (bf)->flags & ZBINFILE_FLAG_LZ )
+
+/*! \brief checksummed blocks of a binary file.
+ *
+ * zBinFileSetChecksum() sets a flag of a binary file \a bf to write
+ * the payload in blocks each of which has a CRC-32C checksum of the
+ * stored data. It has to be called before zBinFileHeaderFWrite() as
+ * zBinFileSetCompress(). If the payload is not compressed, blocks of
+ * ZBINFILE_DEFAULT_BLOCKSIZE bytes are stored as they are.
+ *
+ * Readers verify the checksum of every block before decompressing it,
+ * and fail with an error message on a mismatch, so that a corrupted file
+ * is detected at the block where it is broken.
+ *
+ * zBinFileVerify() verifies checksums of all blocks of \a bf opened for
+ * reading without decompressing them, using \a nthread threads.
+ *
+ * zBinFileIsChecksummed() checks if blocks of \a bf have checksums.
+ * \return
+ * zBinFileSetChecksum() returns no value.
+ * zBinFileVerify() returns the number of broken blocks, which is zero
+ * if \a bf is intact. It returns -1 if \a bf does not have checksums or
+ * the block index, or it fails to read the file.
+ */
+__EXPORT void zBinFileSetChecksum(zBinFile *bf);
+__EXPORT long zBinFileVerify(zBinFile *bf, int nthread);
+#define zBinFileIsChecksummed(bf) ( (bf)->flags & ZBINFILE_FLAG_CRC )
+
+/*! \brief current position of a binary file.
+ *
+ * zBinFileTell() returns the offset of the current position of a binary
+ * file \a bf from the head of the file. If the payload of \a bf is
+ * compressed, it is the offset in the file before compression.
+ * zBinFileSeek() moves the current position of \a bf to an offset
+ * \a offset from the head of the file, which is counted in the same
+ * way with zBinFileTell(). Compressed files are seekable only when
+ * they are read and indexed.
+ * \return
+ * zBinFileTell() returns the offset, or -1 if it fails.
+ * zBinFileSeek() returns the true value if it succeeds, or the false
+ * value otherwise.
+ */
+__EXPORT long zBinFileTell(zBinFile *bf);
+__EXPORT bool zBinFileSeek(zBinFile *bf, long offset);
+
+/*! \brief read the whole payload of a binary file.
+ *
+ * zBinFilePayloadFRead() reads the whole payload of a binary file \a bf
+ * after the header into a newly allocated buffer, and stores its size
+ * to \a size. If the payload is compressed in blocks, they are read at
+ * once and decompressed by \a nthread threads in parallel. Values in
+ * the buffer are in the byte order of the file. The current position
+ * of \a bf is moved to the end of the payload.
+ * \return
+ * zBinFilePayloadFRead() returns a pointer to the buffer, which has to
+ * be freed by the caller. If it fails to read or decompress the payload,
+ * the null pointer is returned.
+ */
+__EXPORT void *zBinFilePayloadFRead(zBinFile *bf, size_t *size, int nthread);
+
+/* asynchronous writer */
+
+/* overflow policies of the asynchronous writer */
+#define ZBINFILE_ASYNC_BLOCK 0 /*!< wait for a free buffer */
+#define ZBINFILE_ASYNC_DROP  1 /*!< discard values silently */
+#define ZBINFILE_ASYNC_COUNT 2 /*!< discard values and let the writer fail */
+
+/*! \struct zBinFileAsyncStat
+ * \brief statistics of the asynchronous writer of a binary file.
+ */
+typedef struct{
+  int nbuf;         /*!< number of buffers in the ring */
+  int depth;        /*!< current number of buffers waiting to be written */
+  int maxdepth;     /*!< maximum number of buffers waiting to be written */
+  size_t nwrite;    /*!< number of buffers written */
+  size_t nstall;    /*!< number of times the producer waited for a free buffer */
+  size_t noverflow; /*!< number of writes discarded due to overflow */
+  size_t dropped;   /*!< number of bytes discarded due to overflow */
+} zBinFileAsyncStat;
+
+/*! \brief asynchronous writer of a binary file.
+ *
+ * zBinFileSetAsync() lets a binary file \a bf write its payload in an
+ * asynchronous way. Values written to \a bf are stored into a ring of
+ * \a nbuf pre-allocated buffers of \a bufsize bytes, and a background
+ * thread drains full buffers to the file, including compression of
+ * blocks if the payload is compressed. It has to be called after
+ * zBinFileHeaderFWrite().
+ *
+ * The producer path stores values into the current buffer without any
+ * lock, and locks the ring only to hand over a full buffer or to take
+ * a free one. If the ring is full, \a policy decides what to do:
+ * - ZBINFILE_ASYNC_BLOCK: waits until a buffer is freed.
+ * - ZBINFILE_ASYNC_DROP: discards the values as if they were written.
+ * - ZBINFILE_ASYNC_COUNT: discards the values and the writer returns
+ *   zero, so that the caller can notice it.
+ * A write of values which does not fit in the rest of the current
+ * buffer and free buffers is discarded as a whole in the latter cases,
+ * so that no partial record is written. In particular, a write larger
+ * than the whole ring of buffers is always discarded.
+ * The remaining buffers are drained by zBinFileClose().
+ *
+ * zBinFileAsyncGetStat() stores statistics of the asynchronous writer
+ * of \a bf into \a stat.
+ *
+ * If ZEDA is built without threads, values are written synchronously.
+ * \return
+ * zBinFileSetAsync() returns the true value if it succeeds, or the false
+ * value if it fails to allocate buffers or to create the thread.
+ * zBinFileAsyncGetStat() returns the false value if \a bf is not written
+ * asynchronously, or the true value otherwise.
+ */
+__EXPORT bool zBinFileSetAsync(zBinFile *bf, int nbuf, size_t bufsize, int policy);
+__EXPORT bool zBinFileAsyncGetStat(zBinFile *bf, zBinFileAsyncStat *stat);
+
+/*! \brief encoded columns of a binary file.
+ *
+ * zBinFileDoubleColumnFWrite() writes \a n double-precision values of an
+ * array \a val to a binary file \a bf as an encoded column. Each value is
+ * XOR'ed with the previous one and packed without leading and trailing
+ * zero bits (see zTSDoubleCompress()).
+ * zBinFileInt64ColumnFWrite() writes \a n 64-bit integers of an array
+ * \a val to \a bf as an encoded column of delta-of-deltas, which suits
+ * timestamps (see zTSInt64Compress()).
+ *
+ * zBinFileDoubleColumnFRead() and zBinFileInt64ColumnFRead() read an
+ * encoded column from \a bf and store at most \a n values into \a val.
+ * If the column has more than \a n values, the rest is skipped.
+ *
+ * An encoded column consists of the number of values, the size of the
+ * encoded data and the data, and is compressed in blocks if \a bf is.
+ * \return
+ * zBinFileDoubleColumnFWrite() and zBinFileInt64ColumnFWrite() return
+ * the number of values written. zBinFileDoubleColumnFRead() and
+ * zBinFileInt64ColumnFRead() return the number of values stored into
+ * \a val. Zero is returned if an error occurs.
+ */
+__EXPORT size_t zBinFileDoubleColumnFWrite(zBinFile *bf, const double val[], size_t n);
+__EXPORT size_t zBinFileDoubleColumnFRead(zBinFile *bf, double val[], size_t n);
+__EXPORT size_t zBinFileInt64ColumnFWrite(zBinFile *bf, const int64_t val[], size_t n);
+__EXPORT size_t zBinFileInt64ColumnFRead(zBinFile *bf, int64_t val[], size_t n);
+
+/*! \brief schema of records in a binary file.
+ *
+ * zBinFileSchemaInit() initializes a schema \a schema of records.
+ * zBinFileSchemaAddField() adds a field named \a name which consists of
+ * \a count values of a type \a type to \a schema. \a type is one of
+ * ZBINFILE_TYPE_BYTE, ZBINFILE_TYPE_INT, ZBINFILE_TYPE_LONG,
+ * ZBINFILE_TYPE_FLOAT and ZBINFILE_TYPE_DOUBLE. ZBINFILE_TYPE_DOUBLE_COLUMN
+ * and ZBINFILE_TYPE_INT64_COLUMN are encoded columns of at most \a count
+ * values written by zBinFileDoubleColumnFWrite() and
+ * zBinFileInt64ColumnFWrite(), respectively.
+ * zBinFileSchemaDestroy() destroys \a schema.
+ * \return
+ * zBinFileSchemaAddField() returns the true value if it succeeds, or
+ * the false value if \a type is invalid or it fails to allocate memory.
+ * zBinFileSchemaInit() and zBinFileSchemaDestroy() return no value.
+ */
+#define zBinFileSchemaInit(schema) zArrayInit( schema )
+__EXPORT bool zBinFileSchemaAddField(zBinFileSchema *schema, const char *name, int type, int count);
+__EXPORT void zBinFileSchemaDestroy(zBinFileSchema *schema);
+
+/*! \brief record index of a binary file.
+ *
+ * zBinFileSetRecordIndex() sets a flag of a binary file \a bf to write
+ * a footer which consists of the index of records and a schema of
+ * records \a schema, which can be the null pointer. It has to be called
+ * between zBinFileInfoSet() or zBinFileInfoSetThis() and
+ * zBinFileHeaderFWrite(), and \a schema has to be kept until \a bf is
+ * closed.
+ * zBinFileRecordMark() marks the current position of \a bf as the head
+ * of a new record with a key \a key, e.g. a time stamp. Keys of records
+ * have to be in ascending order to be searched by zBinFileRecordFind().
+ * The footer is written by zBinFileClose().
+ *
+ * zBinFileHeaderFRead() reads the footer of a binary file with the flag.
+ * zBinFileRecordNum() is the number of records of \a bf, and
+ * zBinFileRecordKey() is the key of the \a i th record.
+ * zBinFileRecordSeek() moves the current position of \a bf to the head
+ * of the \a i th record.
+ * zBinFileRecordFind() finds the first record whose key is equal to or
+ * larger than \a key by a binary search.
+ * zBinFileRecordSchema() is the schema of records of \a bf.
+ * zBinFileRecordFPrint() reads the values of a record from the current
+ * position of \a bf according to its schema, and prints them out to a
+ * file \a fp in a line separated by commas.
+ * \return
+ * zBinFileRecordMark() and zBinFileRecordSeek() return the true value if
+ * they succeed, or the false value otherwise.
+ * zBinFileRecordNum() returns the number of records, which is zero if
+ * \a bf does not have the record index.
+ * zBinFileRecordKey() returns the key of the record. If \a i is out of
+ * range, zero is returned.
+ * zBinFileRecordFind() returns the identifier of the record found, which
+ * is zBinFileRecordNum() if no record has the key equal to or larger
+ * than \a key.
+ * zBinFileRecordSchema() returns a pointer to the schema, or the null
+ * pointer if \a bf does not have it.
+ * zBinFileRecordFPrint() returns the true value if it succeeds to read
+ * all values of the record, or the false value otherwise.
+ */
+__EXPORT void zBinFileSetRecordIndex(zBinFile *bf, zBinFileSchema *schema);
+__EXPORT bool zBinFileRecordMark(zBinFile *bf, double key);
+__EXPORT int64_t zBinFileRecordNum(zBinFile *bf);
+__EXPORT double zBinFileRecordKey(zBinFile *bf, int64_t i);
+__EXPORT bool zBinFileRecordSeek(zBinFile *bf, int64_t i);
+__EXPORT int64_t zBinFileRecordFind(zBinFile *bf, double key);
+__EXPORT zBinFileSchema *zBinFileRecordSchema(zBinFile *bf);
+__EXPORT bool zBinFileRecordFPrint(FILE *fp, zBinFile *bf);
+
 #define zBinFileIntFRead(bf)       ( (bf)->_fread_int( (bf) ) )
 #define zBinFileIntFWrite(bf,val)  ( (bf)->_fwrite_int( (bf), (val) ) )
 
@@ -130,6 +418,196 @@ __EXPORT size_t zBinFileFloatFWrite(zBinFile *bf, float val);
 __EXPORT double zBinFileDoubleFRead(zBinFile *bf);
 __EXPORT size_t zBinFileDoubleFWrite(zBinFile *bf, double val);
 
+/*! \brief read/write an array of values from/to a binary file.
+ *
+ * zBinFileIntNFRead(), zBinFileLongNFRead(), zBinFileFloatNFRead()
+ * and zBinFileDoubleNFRead() read \a n values of int, long, float
+ * and double from the current position of a binary file \a bf, and
+ * store them into an array \a val.
+ * zBinFileIntNFWrite(), zBinFileLongNFWrite(), zBinFileFloatNFWrite()
+ * and zBinFileDoubleNFWrite() write \a n values of int, long, float
+ * and double in an array \a val to the current position of \a bf.
+ *
+ * If the byte order and the size of values in the file are the same
+ * with those of the host, the array is transferred by a single read
+ * or write. Otherwise, it is converted chunk by chunk.
+ * \return
+ * They return the number of values read or written.
+ */
+__EXPORT size_t zBinFileIntNFRead(zBinFile *bf, int val[], size_t n);
+__EXPORT size_t zBinFileIntNFWrite(zBinFile *bf, int val[], size_t n);
+__EXPORT size_t zBinFileLongNFRead(zBinFile *bf, long val[], size_t n);
+__EXPORT size_t zBinFileLongNFWrite(zBinFile *bf, long val[], size_t n);
+__EXPORT size_t zBinFileFloatNFRead(zBinFile *bf, float val[], size_t n);
+__EXPORT size_t zBinFileFloatNFWrite(zBinFile *bf, float val[], size_t n);
+__EXPORT size_t zBinFileDoubleNFRead(zBinFile *bf, double val[], size_t n);
+__EXPORT size_t zBinFileDoubleNFWrite(zBinFile *bf, double val[], size_t n);
+
+/*! \struct zBinFileLayoutField
+ * \brief a field of a struct serialized to a binary file.
+ */
+typedef struct{
+  int type;      /*!< type of values, ZBINFILE_TYPE_BYTE to ZBINFILE_TYPE_DOUBLE */
+  size_t offset; /*!< offset of the field in the struct */
+  int count;     /*!< number of values */
+} zBinFileLayoutField;
+
+/*! \brief a field descriptor of a member \a member of a struct \a st. */
+#define ZBINFILE_LAYOUT_FIELD(st,member,type,count) { (type), offsetof(st,member), (count) }
+
+/*! \struct zBinFileLayout
+ * \brief layout of a struct serialized to a binary file.
+ */
+typedef struct{
+  size_t size;                      /*!< size of the struct */
+  int nfield;                       /*!< number of fields */
+  const zBinFileLayoutField *field; /*!< array of fields */
+} zBinFileLayout;
+
+/*! \brief set a layout of a struct \a st with an array of fields \a fields. */
+#define zBinFileLayoutSet(layout,st,fields) do{\
+  (layout)->size = sizeof(st);\
+  (layout)->nfield = sizeof(fields) / sizeof(zBinFileLayoutField);\
+  (layout)->field = (fields);\
+} while(0)
+
+/*! \brief read/write an array of structs from/to a binary file.
+ *
+ * zBinFileStructNFWrite() writes \a n structs of an array \a array to
+ * the current position of a binary file \a bf. The fields of each struct
+ * are described by \a layout, and are written in the order of the
+ * descriptors without padding.
+ * zBinFileStructNFRead() reads \a n structs described by \a layout from
+ * the current position of \a bf, and stores them into \a array.
+ *
+ * If the byte order and the sizes of int and long of the file are the
+ * same with those of the host, and the fields are laid out in order
+ * without padding, the array is transferred by a single read or write.
+ * Otherwise, structs are converted field by field into packed rows
+ * chunk by chunk.
+ *
+ * An example of a layout is as follows.
+ * \code
+ * typedef struct{ double t; int id; float pos[3]; } sample_t;
+ * static const zBinFileLayoutField sample_fields[] = {
+ *   ZBINFILE_LAYOUT_FIELD( sample_t, t,   ZBINFILE_TYPE_DOUBLE, 1 ),
+ *   ZBINFILE_LAYOUT_FIELD( sample_t, id,  ZBINFILE_TYPE_INT,    1 ),
+ *   ZBINFILE_LAYOUT_FIELD( sample_t, pos, ZBINFILE_TYPE_FLOAT,  3 ),
+ * };
+ * zBinFileLayout layout;
+ * zBinFileLayoutSet( &layout, sample_t, sample_fields );
+ * \endcode
+ * \return
+ * They return the number of structs read or written.
+ */
+__EXPORT size_t zBinFileStructNFWrite(zBinFile *bf, const zBinFileLayout *layout, const void *array, size_t n);
+__EXPORT size_t zBinFileStructNFRead(zBinFile *bf, const zBinFileLayout *layout, void *array, size_t n);
+
+/*! \brief pad a binary file to an aligned offset.
+ *
+ * zBinFileAlignFWrite() writes zero bytes to a binary file \a bf until
+ * the offset of the current position becomes a multiple of \a align.
+ * Values written after it are accessed through aligned pointers by a
+ * mapped reader zBinFileMap.
+ * \return
+ * zBinFileAlignFWrite() returns the number of padded bytes.
+ */
+__EXPORT size_t zBinFileAlignFWrite(zBinFile *bf, size_t align);
+
+/* memory-mapped reader of binary files */
+
+/*! \struct zBinFileMap
+ * \brief memory-mapped reader of a binary file.
+ *
+ * The whole of a ZBD file is mapped to the memory, and values in it
+ * are accessed through typed pointers without any read system call.
+ */
+typedef struct{
+  zBinFile bf;     /*!< header information */
+  /*! \cond */
+  byte *_buf;      /* head of the mapped file */
+  size_t _size;    /* size of the mapped file */
+  size_t _cur;     /* current offset */
+  bool _mapped;    /* whether mapped or loaded */
+  void *_tmp;      /* buffer for converted values */
+  size_t _tmpsize; /* size of the buffer */
+  /*! \endcond */
+} zBinFileMap;
+
+/*! \brief open and close a memory-mapped reader of a binary file.
+ *
+ * zBinFileMapOpen() opens a ZBD file \a filename, validates its header,
+ * and maps the file up to the end of the payload to the memory, so that
+ * the footer of records is not read as the payload. The current position
+ * is set at the end of the header. If the file cannot be mapped, it is
+ * loaded into the memory instead. If the payload is compressed,
+ * it is decompressed into the memory in parallel, and offsets in the
+ * file are counted in the same way with zBinFileTell().
+ *
+ * zBinFileMapClose() unmaps the file mapped by \a map.
+ * \return
+ * zBinFileMapOpen() returns a pointer \a map if it succeeds. If it fails
+ * to open or map the file, or the header is invalid, the null pointer
+ * is returned.
+ * zBinFileMapClose() returns no value.
+ */
+__EXPORT zBinFileMap *zBinFileMapOpen(zBinFileMap *map, char filename[]);
+__EXPORT void zBinFileMapClose(zBinFileMap *map);
+
+/*! \brief size of and current position in a mapped binary file. */
+#define zBinFileMapSize(map) (map)->_size
+#define zBinFileMapTell(map) (map)->_cur
+#define zBinFileMapIsEOF(map) ( (map)->_cur >= (map)->_size )
+
+/*! \brief check if values in a mapped binary file are accessed without copy.
+ *
+ * zBinFileMapIsZeroCopy() checks if the byte order of the binary file
+ * mapped by \a map is the same with the host, namely, the file is
+ * accessed without conversion.
+ */
+#define zBinFileMapIsZeroCopy(map) ( (map)->bf._endian_type == endian_check() )
+
+/*! \brief move the current position in a mapped binary file.
+ *
+ * zBinFileMapSeek() moves the current position of a mapped binary file
+ * \a map to \a offset bytes from the head of the file.
+ * zBinFileMapAlign() moves the current position of \a map forward to
+ * the nearest offset which is a multiple of \a align, which corresponds
+ * to zBinFileAlignFWrite().
+ * \return
+ * zBinFileMapSeek() and zBinFileMapAlign() return the true value if
+ * the new position is within the file, or the false value otherwise,
+ * in which case the position is not changed.
+ */
+__EXPORT bool zBinFileMapSeek(zBinFileMap *map, size_t offset);
+__EXPORT bool zBinFileMapAlign(zBinFileMap *map, size_t align);
+
+/*! \brief typed pointers to values in a mapped binary file.
+ *
+ * zBinFileMapBytes() returns a pointer to \a n bytes from the current
+ * position of a mapped binary file \a map.
+ * zBinFileMapIntArray(), zBinFileMapLongArray(), zBinFileMapFloatArray()
+ * and zBinFileMapDoubleArray() return pointers to arrays of \a n values
+ * of int, long, float and double, respectively, from the current
+ * position of \a map.
+ * The current position is moved forward to the end of the array.
+ *
+ * If the byte order and the size of values in the file are the same
+ * with those of the host and the position is aligned to the size of
+ * the type, the returned pointer directly points the mapped memory.
+ * Otherwise, the values are copied to an internal buffer of \a map
+ * with conversion, which is valid until the next call of them.
+ * In any case, the values must not be modified.
+ * \return
+ * They return the null pointer if the file does not have \a n values
+ * from the current position, or it fails to allocate the buffer.
+ */
+__EXPORT const ubyte *zBinFileMapBytes(zBinFileMap *map, size_t n);
+__EXPORT const int *zBinFileMapIntArray(zBinFileMap *map, size_t n);
+__EXPORT const long *zBinFileMapLongArray(zBinFileMap *map, size_t n);
+__EXPORT const float *zBinFileMapFloatArray(zBinFileMap *map, size_t n);
+__EXPORT const double *zBinFileMapDoubleArray(zBinFileMap *map, size_t n);
+
 __END_DECLS
 
 #endif /* __ZEDA_BINFILE_H__ */
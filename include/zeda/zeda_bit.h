@@ -65,6 +65,39 @@ __EXPORT uint32_t endian_reverse32(uint32_t val);
  */
 __EXPORT uint64_t endian_reverse64(uint64_t val);
 
+/*! \brief convert an array of little/big endian values to big/little endian.
+ *
+ * endian_reverse16_array(), endian_reverse32_array() and
+ * endian_reverse64_array() convert \a n 16-bit, 32-bit and 64-bit
+ * values in an array \a buf from little endian to big endian,
+ * and vice versa, in place. \a buf has to be aligned to the size
+ * of a value.
+ * \note
+ * PDP endian is not dealt with.
+ */
+__EXPORT void endian_reverse16_array(void *buf, size_t n);
+__EXPORT void endian_reverse32_array(void *buf, size_t n);
+__EXPORT void endian_reverse64_array(void *buf, size_t n);
+
+/*! \} */
+
+/* ********************************************************** */
+/*! \defgroup crc cyclic redundancy check.
+ * \{ *//* ************************************************** */
+
+/*! \brief CRC-32C (Castagnoli) checksum.
+ *
+ * crc32c() updates a CRC-32C checksum \a crc with \a size bytes of data
+ * pointed by \a buf. The checksum of a sequence of data is computed by
+ * giving zero to \a crc at first and the returned value to the next call.
+ *
+ * The SSE4.2 crc32 instruction is used on x86-64 processors which
+ * support it, and slicing-by-8 tables otherwise.
+ * \return
+ * crc32c() returns the updated checksum.
+ */
+__EXPORT uint32_t crc32c(uint32_t crc, const void *buf, size_t size);
+
 /*! \} */
 
 /* ********************************************************** */
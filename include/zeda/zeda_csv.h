@@ -13,6 +13,8 @@
 #define __ZEDA_CSV_H__
 
 #include <zeda/zeda_string.h>
+#include <zeda/zeda_binfile.h>
+#include <zeda/zeda_array.h>
 
 #ifndef __KERNEL__
 
@@ -27,21 +29,80 @@ __BEGIN_DECLS
  * \brief CSV manager class
  *
  * zCSV class handles a CSV file.
+ *
+ * The starting positions of lines are indexed in either of two modes.
+ * In the full mode, \a pos has the position of every line.
+ * In the sparse mode, only every \a stride th line is checkpointed.
+ * The positions of checkpoints are coded as variable-length deltas
+ * in \a delta, and every ZCSV_ANCHOR_NUM th checkpoint is anchored
+ * in \a pos with an absolute position. Other lines are reached by
+ * scanning forward from the nearest checkpoint.
  *//* ******************************************************* */
 typedef struct{
   FILE *fp;         /*!< file pointer */
   int nl;           /*!< number of lines */
-  long *pos;        /*!< array of starting positions of lines in the file stream */
+  long *pos;        /*!< array of starting positions of lines (or anchors) in the file stream */
   int nf;           /*!< number of fields per line */
+  int stride;       /*!< interval of checkpoints (1 for the full index) */
+  ubyte *delta;     /*!< variable-length deltas of checkpoint positions */
+  size_t *deltapos; /*!< head positions of deltas at anchors */
+  size_t deltasize; /*!< size of deltas */
   char buf[BUFSIZ]; /*!< internal buffer */
 } zCSV;
 
+/*! \brief default interval of checkpoints in the sparse mode. */
+#define ZCSV_DEFAULT_STRIDE 1024
+/*! \brief number of checkpoints per anchor in the sparse mode. */
+#define ZCSV_ANCHOR_NUM       64
+
 /*! \brief number of lines of a CSV file. */
 #define zCSVLineNum(csv) (csv)->nl
 
+/*! \brief check if a CSV file is indexed in the sparse mode. */
+#define zCSVIsSparse(csv) ( (csv)->stride > 1 )
+
 /*! \brief open a CSV file. */
 __EXPORT zCSV *zCSVOpen(zCSV *csv, char filename[]);
 
+/*! \brief open a CSV file with a sparse line index.
+ *
+ * zCSVOpenSparse() opens a CSV file \a filename, and indexes only
+ * every \a stride th line of it. The memory consumption of the index
+ * is much less than that of zCSVOpen() for a huge file, while
+ * zCSVGoToLine() has to scan at most \a stride - 1 lines forward.
+ * If \a stride is less than or equal to 1, it works as zCSVOpen().
+ * \return
+ * zCSVOpenSparse() returns a pointer \a csv if it succeeds.
+ * Otherwise, the null pointer is returned.
+ */
+__EXPORT zCSV *zCSVOpenSparse(zCSV *csv, char filename[], int stride);
+
+/*! \brief save the line index of a CSV file to a sidecar file.
+ *
+ * zCSVIndexSave() saves the sparse line index of \a csv to a file
+ * \a idxfile in the ZBD format, so that the index is instantly
+ * restored by zCSVOpenIndex().
+ * \return
+ * zCSVIndexSave() returns the true value if it succeeds. If \a csv
+ * is not in the sparse mode or it fails to write the file, the false
+ * value is returned.
+ */
+__EXPORT bool zCSVIndexSave(zCSV *csv, char idxfile[]);
+
+/*! \brief open a CSV file with a saved line index.
+ *
+ * zCSVOpenIndex() opens a CSV file \a filename and restores its
+ * sparse line index from a sidecar file \a idxfile saved by
+ * zCSVIndexSave(). If \a idxfile is not found, is broken or does not
+ * match the CSV file, namely, either the size or the modification time
+ * of the CSV file differs from those recorded in \a idxfile, the index
+ * is rebuilt with the default stride ZCSV_DEFAULT_STRIDE.
+ * \return
+ * zCSVOpenIndex() returns a pointer \a csv if it succeeds.
+ * Otherwise, the null pointer is returned.
+ */
+__EXPORT zCSV *zCSVOpenIndex(zCSV *csv, char filename[], char idxfile[]);
+
 /*! \brief close a CSV file. */
 __EXPORT void zCSVClose(zCSV *csv);
 
@@ -75,6 +136,294 @@ __EXPORT bool zCSVGetDouble(zCSV *csv, double *val);
 /*! \brief get multiple double-precision floating-point values from the current buffer of a CSV file. */
 __EXPORT bool zCSVGetDoubleN(zCSV *csv, double val[], int n);
 
+/* ********************************************************** */
+/*! \struct zCSVProjection
+ * \brief projection of columns of a CSV file with row filters
+ *
+ * zCSVProjection class declares columns to be read from a CSV file
+ * and range filters on columns. zCSVGetProjectedRow() reads only
+ * the declared columns of rows that pass all the filters; the other
+ * fields are skipped without being copied, and the rows that do not
+ * pass the filters are dropped before the projected columns are
+ * converted to values.
+ *//* ******************************************************* */
+typedef struct{
+  int col;    /*!< column index */
+  double min; /*!< lower bound of values */
+  double max; /*!< upper bound of values */
+} zCSVFilter;
+
+zArrayClass( zCSVColArray, int );
+zArrayClass( zCSVFilterArray, zCSVFilter );
+
+typedef struct{
+  zCSVColArray col;       /*!< indices of columns to be read */
+  zCSVFilterArray filter; /*!< filters on columns */
+  /*! \cond */
+  int _maxcol;            /* the largest index of columns needed */
+  ubyte *_need;           /* flags of columns needed */
+  char **_field;          /* fields located in the current line */
+  /*! \endcond */
+} zCSVProjection;
+
+/*! \brief initialize a projection of columns of a CSV file. */
+__EXPORT zCSVProjection *zCSVProjectionInit(zCSVProjection *proj);
+
+/*! \brief add a column to a projection.
+ *
+ * zCSVProjectionAddColumn() adds the \a col th column to a projection
+ * \a proj. The values of columns are stored in the order of addition.
+ * \return
+ * zCSVProjectionAddColumn() returns the true value if it succeeds.
+ * Otherwise, the false value is returned.
+ */
+__EXPORT bool zCSVProjectionAddColumn(zCSVProjection *proj, int col);
+
+/*! \brief add a range filter to a projection.
+ *
+ * zCSVProjectionAddFilter() adds a filter to a projection \a proj,
+ * which accepts only rows whose value of the \a col th column is in
+ * between \a min and \a max. The column needs not to be projected.
+ * \return
+ * zCSVProjectionAddFilter() returns the true value if it succeeds.
+ * Otherwise, the false value is returned.
+ */
+__EXPORT bool zCSVProjectionAddFilter(zCSVProjection *proj, int col, double min, double max);
+
+/*! \brief destroy a projection of columns of a CSV file. */
+__EXPORT void zCSVProjectionDestroy(zCSVProjection *proj);
+
+/*! \brief number of projected columns. */
+#define zCSVProjectionColNum(p) zArraySize(&(p)->col)
+
+/*! \brief get projected values of the next row of a CSV file.
+ *
+ * zCSVGetProjectedRow() reads rows from the current position of a
+ * CSV file \a csv until it finds a row that passes all filters of
+ * a projection \a proj, and stores values of projected columns of
+ * the row into \a val. \a val has to have zCSVProjectionColNum()
+ * components at least. An empty or missing field is regarded as
+ * zero.
+ * \return
+ * zCSVGetProjectedRow() returns the true value if it finds a row.
+ * If it reaches the end of file, the false value is returned.
+ */
+__EXPORT bool zCSVGetProjectedRow(zCSV *csv, zCSVProjection *proj, double val[]);
+
+/* ********************************************************** */
+/*! \struct zCSVWriter
+ * \brief buffered CSV writer class
+ *
+ * zCSVWriter class formats values into a large output buffer, and
+ * flushes it to a file in a big write when the buffer is full.
+ * If it is opened by zCSVWriterOpenAsync(), the full buffer is
+ * handed to a background thread to be flushed, while the values
+ * are formatted into the other buffer.
+ *//* ******************************************************* */
+typedef struct{
+  FILE *fp;       /*!< file pointer */
+  char *buf;      /*!< output buffer */
+  size_t size;    /*!< size of the output buffer */
+  size_t len;     /*!< length of data in the output buffer */
+  bool bol;       /*!< flag to be at the beginning of a line */
+  /*! \cond */
+  void *_flusher; /* background flusher */
+  /*! \endcond */
+} zCSVWriter;
+
+/*! \brief default size of the output buffer of a CSV writer. */
+#define ZCSV_WRITER_DEFAULT_BUFSIZ ( 1 << 20 )
+
+/*! \brief identifiers of types of columns. */
+#define ZCSV_TYPE_INT    0
+#define ZCSV_TYPE_LONG   1
+#define ZCSV_TYPE_DOUBLE 2
+#define ZCSV_TYPE_INT64  3
+#define ZCSV_TYPE_STRING 4
+
+/*! \brief a typed column of values to be written to a CSV file.
+ *
+ * ZCSV_TYPE_STRING is only for cache columns, and is rejected by
+ * zCSVWriterPutColumns().
+ */
+typedef struct{
+  int type;   /*!< type of values, either of ZCSV_TYPE_INT, ZCSV_TYPE_LONG, ZCSV_TYPE_DOUBLE and ZCSV_TYPE_INT64 */
+  void *data; /*!< array of values */
+} zCSVColumn;
+
+/*! \brief open a CSV file to be written.
+ *
+ * zCSVWriterOpen() opens a CSV file \a filename for writing, and
+ * allocates an output buffer with the size \a size. If \a size is
+ * zero, ZCSV_WRITER_DEFAULT_BUFSIZ is applied.
+ * zCSVWriterOpenAsync() does the same, in addition, allocates
+ * another buffer and launches a background thread which flushes
+ * full buffers. If the library is built without the thread support,
+ * it works as zCSVWriterOpen().
+ * \return
+ * zCSVWriterOpen() and zCSVWriterOpenAsync() return a pointer \a w
+ * if they succeed. Otherwise, the null pointer is returned.
+ */
+__EXPORT zCSVWriter *zCSVWriterOpen(zCSVWriter *w, char filename[], size_t size);
+__EXPORT zCSVWriter *zCSVWriterOpenAsync(zCSVWriter *w, char filename[], size_t size);
+
+/*! \brief flush the output buffer of a CSV writer.
+ *
+ * zCSVWriterFlush() writes all data stored in the output buffer of
+ * \a w to the file. In the asynchronous mode, it waits for the
+ * background thread to complete writing.
+ * \return
+ * zCSVWriterFlush() returns the true value if it succeeds.
+ * Otherwise, the false value is returned.
+ */
+__EXPORT bool zCSVWriterFlush(zCSVWriter *w);
+
+/*! \brief close a CSV file to be written.
+ *
+ * zCSVWriterClose() flushes the output buffer of \a w, closes the
+ * file, and frees the buffers.
+ */
+__EXPORT void zCSVWriterClose(zCSVWriter *w);
+
+/*! \brief put a field to a CSV file.
+ *
+ * zCSVWriterPutField() puts a string \a field to the current line
+ * of a CSV writer \a w. A comma is inserted before it unless it is
+ * the first field of the line.
+ * zCSVWriterPutInt(), zCSVWriterPutLong() and zCSVWriterPutDouble()
+ * put an integer value, a long integer value and a double-precision
+ * floating-point value, respectively. A double-precision value is
+ * formatted in the shortest string that is read back to the same
+ * value.
+ * \return
+ * They return the true value if they succeed. Otherwise, the false
+ * value is returned.
+ */
+__EXPORT bool zCSVWriterPutField(zCSVWriter *w, const char *field);
+__EXPORT bool zCSVWriterPutInt(zCSVWriter *w, int val);
+__EXPORT bool zCSVWriterPutLong(zCSVWriter *w, long val);
+__EXPORT bool zCSVWriterPutDouble(zCSVWriter *w, double val);
+
+/*! \brief terminate the current line of a CSV file. */
+__EXPORT bool zCSVWriterEndLine(zCSVWriter *w);
+
+/*! \brief put a row of values to a CSV file.
+ *
+ * zCSVWriterPutIntRow() and zCSVWriterPutDoubleRow() put \a n values
+ * of an array \a val as a line of a CSV writer \a w.
+ * \return
+ * They return the true value if they succeed. Otherwise, the false
+ * value is returned.
+ */
+__EXPORT bool zCSVWriterPutIntRow(zCSVWriter *w, int val[], int n);
+__EXPORT bool zCSVWriterPutDoubleRow(zCSVWriter *w, double val[], int n);
+
+/*! \brief put a batch of typed columns to a CSV file.
+ *
+ * zCSVWriterPutColumns() puts \a nrow lines of a CSV writer \a w
+ * from \a ncol typed columns \a col. The \a i th line consists of
+ * the \a i th values of the columns.
+ * \return
+ * zCSVWriterPutColumns() returns the true value if it succeeds.
+ * Otherwise, the false value is returned.
+ */
+__EXPORT bool zCSVWriterPutColumns(zCSVWriter *w, int nrow, int ncol, zCSVColumn col[]);
+
+/* ********************************************************** */
+/*! \struct zCSVCache
+ * \brief binary columnar cache of a CSV file
+ *
+ * zCSVCache class holds a CSV file converted to a binary columnar
+ * file, which consists of the ZBD header, typed arrays of columns
+ * and a footer that tells the offsets of the columns.
+ * A column of integer values is stored as an array of int64_t,
+ * a column of real values as an array of double, and a column of
+ * other strings is dictionary-encoded as an array of int32_t codes
+ * and a pool of unique null-terminated strings.
+ *
+ * If the byte order of the file is the same with that of the host,
+ * the file is mapped to the memory as is, and the columns point
+ * directly into the mapping. Otherwise, the file is read into the
+ * memory and the columns are byte-swapped.
+ *//* ******************************************************* */
+typedef struct{
+  int type;         /*!< type of values, either of ZCSV_TYPE_INT64, ZCSV_TYPE_DOUBLE and ZCSV_TYPE_STRING */
+  void *data;       /*!< array of values (codes for a string column) */
+  int ndict;        /*!< number of entries of the dictionary */
+  int64_t *dictofs; /*!< offsets of the entries in the string pool */
+  char *dictpool;   /*!< string pool */
+} zCSVCacheColumn;
+
+typedef struct{
+  int nrow;              /*!< number of rows */
+  int ncol;              /*!< number of columns */
+  zCSVCacheColumn *col;  /*!< array of columns */
+  /*! \cond */
+  int64_t _srcsize;      /* size of the source CSV file */
+  int64_t _srcmtime;     /* modification time of the source CSV file */
+  byte *_buf;            /* memory of the whole file */
+  size_t _size;          /* size of the file */
+  bool _mapped;          /* flag to be mapped */
+  /*! \endcond */
+} zCSVCache;
+
+/*! \brief number of rows of a CSV cache. */
+#define zCSVCacheRowNum(c)     (c)->nrow
+/*! \brief number of columns of a CSV cache. */
+#define zCSVCacheColNum(c)     (c)->ncol
+/*! \brief type of a column of a CSV cache. */
+#define zCSVCacheColType(c,j)  (c)->col[j].type
+
+/*! \brief array of integer values of a column of a CSV cache (the null pointer for a column of other types). */
+#define zCSVCacheInt64Col(c,j)  ( zCSVCacheColType(c,j) == ZCSV_TYPE_INT64 ? (int64_t *)(c)->col[j].data : NULL )
+/*! \brief array of real values of a column of a CSV cache (the null pointer for a column of other types). */
+#define zCSVCacheDoubleCol(c,j) ( zCSVCacheColType(c,j) == ZCSV_TYPE_DOUBLE ? (double *)(c)->col[j].data : NULL )
+/*! \brief array of codes of strings of a column of a CSV cache (the null pointer for a column of other types). */
+#define zCSVCacheCodeCol(c,j)   ( zCSVCacheColType(c,j) == ZCSV_TYPE_STRING ? (int32_t *)(c)->col[j].data : NULL )
+/*! \brief a string in the dictionary of a column of a CSV cache. */
+#define zCSVCacheDictStr(c,j,k) ( (c)->col[j].dictpool + (c)->col[j].dictofs[k] )
+/*! \brief a string at the \a i th row of a string column of a CSV cache. */
+#define zCSVCacheStr(c,i,j)     zCSVCacheDictStr( c, j, zCSVCacheCodeCol(c,j)[i] )
+
+/*! \brief convert a CSV file to a binary columnar cache file.
+ *
+ * zCSVCacheCreate() converts the whole of a CSV file \a csv to a
+ * binary columnar file \a filename. The type of each column is
+ * automatically chosen from integer, real and string values.
+ * An empty field in a numerical column is regarded as zero.
+ * \return
+ * zCSVCacheCreate() returns the true value if it succeeds.
+ * Otherwise, the false value is returned.
+ */
+__EXPORT bool zCSVCacheCreate(zCSV *csv, char filename[]);
+
+/*! \brief load a binary columnar cache file.
+ *
+ * zCSVCacheLoad() loads a binary columnar file \a filename created
+ * by zCSVCacheCreate() to \a cache.
+ * \return
+ * zCSVCacheLoad() returns a pointer \a cache if it succeeds.
+ * Otherwise, the null pointer is returned.
+ */
+__EXPORT zCSVCache *zCSVCacheLoad(zCSVCache *cache, char filename[]);
+
+/*! \brief open a CSV file via its binary columnar cache.
+ *
+ * zCSVCacheOpen() loads a binary columnar file \a cachefile of a CSV
+ * file \a csvfile. If \a cachefile is not found or does not match
+ * \a csvfile, namely, either the size or the modification time of
+ * \a csvfile differs from those recorded in \a cachefile, it is
+ * recreated from \a csvfile beforehand. Otherwise, \a csvfile is not
+ * read at all.
+ * \return
+ * zCSVCacheOpen() returns a pointer \a cache if it succeeds.
+ * Otherwise, the null pointer is returned.
+ */
+__EXPORT zCSVCache *zCSVCacheOpen(zCSVCache *cache, char csvfile[], char cachefile[]);
+
+/*! \brief close a binary columnar cache of a CSV file. */
+__EXPORT void zCSVCacheClose(zCSVCache *cache);
+
 /*! \} */
 
 __END_DECLS
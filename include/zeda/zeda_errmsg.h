@@ -29,9 +29,13 @@
 #define ZEDA_WARN_TOOLNG_TKN           "too long string to tokenize"
 #define ZEDA_WARN_TOOLNG_NUM           "too long number"
 
+#define ZEDA_WARN_STREAM_FULL          "memory stream full, data truncated"
+
 #define ZEDA_WARN_INDEX_SIZMIS         "index has only %d components, while specified size is %d"
 
 #define ZEDA_WARN_CSV_FIELD_EMPTY      "field empty"
+#define ZEDA_WARN_CSV_NOT_SPARSE       "CSV file not indexed sparsely"
+#define ZEDA_WARN_CSV_INDEX_REBUILT    "%s: invalid or obsolete CSV index, rebuilt."
 
 #define ZEDA_WARN_ZTK_INCLUDE_DUP      "%s: duplicate file inclusion, skipped."
 #define ZEDA_WARN_ZTK_NOT_TAGGED       "not in a tagged field, skipped."
@@ -50,6 +54,18 @@
 #define ZEDA_ERR_INTSIZ_NOT_FOUND      "size of int not found."
 #define ZEDA_ERR_LNGSIZ_NOT_FOUND      "size of long not found."
 #define ZEDA_ERR_UNKNOWN_ENDIAN        "unknown endian."
+#define ZEDA_ERR_ZBD_FLAG_NOT_FOUND    "flags not found."
+#define ZEDA_ERR_ZBD_UNKNOWN_FLAG      "unsupported flags %x of ZBD file."
+#define ZEDA_ERR_ZBD_INVALID_BLOCK     "invalid block of ZBD file."
+#define ZEDA_ERR_ZBD_NOT_SEEKABLE      "ZBD file not seekable."
+#define ZEDA_ERR_ZBD_INVALID_FIELD     "%s: invalid field of records."
+#define ZEDA_ERR_ZBD_NO_RECORD_INDEX   "ZBD file without record index."
+#define ZEDA_ERR_ZBD_INVALID_RECORD_INDEX "invalid record index of ZBD file."
+#define ZEDA_ERR_ZBD_INVALID_RECORD    "out-of-range record %ld specified."
+#define ZEDA_ERR_ZBD_CHECKSUM_MISMATCH "checksum mismatch in block %ld of ZBD file."
+#define ZEDA_ERR_ZBD_NOT_VERIFIABLE    "ZBD file without checksums or block index."
+#define ZEDA_ERR_ZBD_INVALID_LAYOUT    "invalid layout of structs."
+#define ZEDA_ERR_ZBD_INVALID_COLUMN    "invalid encoded column of ZBD file."
 
 #define ZEDA_ERR_EMPTY_STRING "empty string"
 
@@ -59,6 +75,14 @@
 
 #define ZEDA_ERR_CSV_INVALID           "invalid CSV file"
 #define ZEDA_ERR_CSV_INVALID_LINE      "out-of-range line number %d specified"
+#define ZEDA_ERR_CSV_INVALID_TYPE      "invalid type of column %d"
+#define ZEDA_ERR_CSV_INVALID_COL       "invalid column %d specified"
+#define ZEDA_ERR_CSV_INVALID_CACHE     "%s: invalid CSV cache file"
+
+#define ZEDA_ERR_STREAM_MMAP_FAILED    "%s: cannot map file to stream"
+#define ZEDA_ERR_STREAM_INVALID_BLOCK  "invalid compressed block in stream"
+
+#define ZEDA_ERR_THREAD_CREATE         "cannot create a thread"
 
 #define ZEDA_ERR_FATAL                 "fatal error! - please report to the author"
 
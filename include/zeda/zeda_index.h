@@ -166,6 +166,19 @@ __EXPORT int zIndexMove(zIndex idx, int from, int to);
 __EXPORT zIndex zIndexRemove(zIndex idx, int i);
 
 #ifndef __KERNEL__
+/*! \brief sort an integer vector.
+ *
+ * zIndexRadixSort() sorts components of an integer vector \a idx in
+ * ascending order by radix sort. zRadixSortInt32() or zRadixSortInt64()
+ * is chosen according to the size of int, and zQuickSort() is used
+ * instead if int is of neither of them.
+ * \return
+ * zIndexRadixSort() returns a pointer \a idx, or the null pointer if it
+ * fails to allocate the working memory.
+ * \sa zRadixSortInt32, zRadixSortInt64
+ */
+__EXPORT zIndex zIndexRadixSort(zIndex idx);
+
 /*! \brief scan an array of integer values from a file.
  *
  * zIndexFScan() scans a sequence of integer values from
@@ -364,6 +364,63 @@ list_t *list_t##QuickSort(list_t *list, int (* cmp)(void*,void*,void*), void *pr
   return list;\
 }
 
+/*! \brief define the merge sort method for a list class.
+ *
+ * zListMergeSortDef() defines a merge sort function
+ * for a given list class \a list_t and a list cell
+ * class \a cell_t. \a list_t class must stand upon
+ * \a cell_t class.
+ *
+ * The function defined will be named 'list_t'MergeSort()
+ * with the following prototype.
+ *
+ * \a list_t *list_tMergeSort(\a list_t *list, int (*cmp)(void*,void*,void*), void *priv);
+ *
+ * The cells of \a list will be sorted in the same order
+ * with 'list_t'QuickSort() defined by zListQuickSortDef().
+ * Unlike it, the sort is stable, namely, cells that
+ * compare equal remain in their original order.
+ * Cells are relinked in place by merging sublists
+ * bottom-up with doubling their lengths, so that it
+ * takes O(n log n) time even in the worst case without
+ * recursion and extra memory.
+ */
+#define zListMergeSortDef(list_t, cell_t) \
+list_t *list_t##MergeSort(list_t *list, int (* cmp)(void*,void*,void*), void *priv)\
+{\
+  cell_t *first, *last, *p, *q, *c;\
+  int width, np, nq, nmerge;\
+\
+  if( zListSize(list) <= 1 ) return list;\
+  first = zListTail(list);\
+  zListCellSetNext( zListHead(list), NULL ); /* unlink to a chain */\
+  for( width=1; ; width*=2 ){\
+    for( p=first, first=last=NULL, nmerge=0; p; p=q, nmerge++ ){\
+      for( q=p, np=0; q && np<width; np++ ) q = zListCellNext(q);\
+      for( nq=width; np > 0 || ( nq > 0 && q ); ){\
+        if( np > 0 && ( nq == 0 || !q || cmp( (void *)p, (void *)q, priv ) <= 0 ) ){\
+          c = p; p = zListCellNext(p); np--;\
+        } else{\
+          c = q; q = zListCellNext(q); nq--;\
+        }\
+        if( last ) zListCellSetNext( last, c );\
+        else first = c;\
+        last = c;\
+      }\
+    }\
+    zListCellSetNext( last, NULL );\
+    if( nmerge <= 1 ) break;\
+  }\
+  /* restore the ring */\
+  for( p=zListRoot(list), c=first; c; p=c, c=zListCellNext(c) ){\
+    zListCellSetNext( p, c );\
+    zListCellSetPrev( c, p );\
+  }\
+  zListCellSetNext( p, zListRoot(list) );\
+  zListCellSetPrev( zListRoot(list), p );\
+  return list;\
+}
+
 /*! \brief print connection information of a list.
  *
  * zListFPrint() prints the connection information of a
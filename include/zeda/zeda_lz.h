@@ -0,0 +1,59 @@
+/* ZEDA - Elementary Data and Algorithms
+ * Copyright (C) 1998 Tomomichi Sugihara (Zhidao)
+ */
+/*! \file zeda_lz.h
+ * \brief LZ-style fast block compression.
+ * \author Zhidao
+ */
+
+#ifndef __ZEDA_LZ_H__
+#define __ZEDA_LZ_H__
+
+#include <zeda/zeda_misc.h>
+
+__BEGIN_DECLS
+
+/* ********************************************************** */
+/*! \defgroup lz LZ-style block compression.
+ * \{ *//* ************************************************** */
+
+/*! \brief the minimum length of a match of the LZ codec. */
+#define ZLZ_MINMATCH 4
+/*! \brief the maximum distance of a match of the LZ codec. */
+#define ZLZ_MAXOFFSET 0xffff
+
+/*! \brief the maximum size of a compressed block.
+ *
+ * zLZCompressBound() is the maximum size of a block compressed from
+ * \a n bytes, which is enough for the destination of zLZCompress().
+ */
+#define zLZCompressBound(n) ( (n) + (n)/255 + 16 )
+
+/*! \brief compress and decompress a block of data.
+ *
+ * zLZCompress() compresses \a srcsize bytes of data pointed by \a src
+ * and stores the result into a buffer \a dst of \a dstsize bytes.
+ * zLZDecompress() decompresses \a srcsize bytes of compressed data
+ * \a src and stores the result into a buffer \a dst of \a dstsize bytes.
+ *
+ * The format is a sequence of literal runs and back-references within
+ * the same block as the LZ4 block format, so that each block can be
+ * decompressed independently of others. Back-references are limited to
+ * ZLZ_MAXOFFSET bytes.
+ *
+ * Both functions are reentrant, so that blocks can be compressed or
+ * decompressed in parallel.
+ * \return
+ * zLZCompress() returns the size of the compressed data. If \a dstsize
+ * is not enough to store the compressed data, it returns zero.
+ * zLZDecompress() returns the size of the decompressed data. If \a src
+ * is broken or \a dstsize is not enough, it returns zero.
+ */
+__EXPORT size_t zLZCompress(const void *src, size_t srcsize, void *dst, size_t dstsize);
+__EXPORT size_t zLZDecompress(const void *src, size_t srcsize, void *dst, size_t dstsize);
+
+/*! \} */
+
+__END_DECLS
+
+#endif /* __ZEDA_LZ_H__ */
@@ -13,6 +13,7 @@
 #define __ZEDA_STREAM_H__
 
 #include <zeda/zeda_misc.h>
+#include <zeda/zeda_bit.h>
 
 #ifndef __KERNEL__
 
@@ -36,8 +37,12 @@ typedef struct __zstream{
     FILE *fp;
     struct{
       byte *buf, *cur;
-      size_t size;
+      size_t size, capacity;
     } mem;
+    struct{
+      struct __zstream *sink;
+      void *state;
+    } filter;
   } src;
   void (* rewind)(struct __zstream *str);
   int (* seek)(struct __zstream *str, long offset);
@@ -45,6 +50,10 @@ typedef struct __zstream{
   size_t (* read)(struct __zstream *str, byte *dest, size_t size, size_t nmemb);
   size_t (* write)(struct __zstream *str, byte *src, size_t size, size_t nmemb);
   int (* close)(struct __zstream *str);
+  /*! \cond */
+  void *_buf; /* read buffer */
+  void *_prefetch; /* read-ahead prefetcher */
+  /*! \endcond */
 } zStream;
 
 /*! \brief attach a file to a stream.
@@ -59,6 +68,8 @@ __EXPORT void zStreamAttachFile(zStream *str, FILE *fp);
  * zStreamAttachMem() attaches a memory buffer pointed
  * by \a mem with the size \a size to an abstracted
  * stream \a str.
+ * As fread() and fwrite(), zStreamRead() and zStreamWrite()
+ * on the stream return the number of data cells.
  */
 __EXPORT void zStreamAttachMem(zStream *str, byte *mem, size_t size);
 
@@ -76,12 +87,66 @@ __EXPORT zStream *zStreamOpenFile(zStream *str, char filename[], char *mode);
  *
  * zStreamOpenMem() allocates a memory buffer with the
  * size \a size, and attaches it to a stream \a str.
+ * The buffer is zero-cleared, and zStreamWrite() on \a str
+ * does not write data beyond \a size bytes.
  * \return
  * a pointer \a str is returned if succeeding to allocate
  * the memory space. Otherwise, the null pointer is returned.
  */
 __EXPORT zStream *zStreamOpenMem(zStream *str, size_t size);
 
+/*! \brief minimum capacity of a growable memory stream. */
+#define ZSTREAM_MEM_MINSIZE BUFSIZ
+
+/*! \brief growable memory stream.
+ *
+ * zStreamOpenGrowMem() attaches an empty memory buffer to a stream
+ * \a str, which grows as data are written to \a str. The capacity of the
+ * buffer is doubled when it runs short, so that serialization of data
+ * of an unknown size into the memory costs only a few reallocations.
+ * \a capacity bytes are allocated in advance.
+ * zStreamReserve() enlarges the capacity of the buffer of \a str to
+ * \a capacity bytes in advance. It does not shrink the buffer.
+ * zStreamSeek() on \a str accepts positions up to the end of written
+ * data, and zStreamTell() returns the offset from the head.
+ *
+ * zStreamDetachBuf() detaches the memory buffer from a stream \a str on
+ * the memory without copying it, and stores the size of data in it to
+ * \a size unless \a size is the null pointer. The caller has to free
+ * the buffer afterwards. \a str becomes an empty stream.
+ * \return
+ * zStreamOpenGrowMem() returns a pointer \a str if succeeding to allocate
+ * the buffer. Otherwise, the null pointer is returned.
+ * zStreamReserve() returns the true value if the capacity of \a str is
+ * no less than \a capacity afterwards, or the false value otherwise.
+ * zStreamDetachBuf() returns a pointer to the detached buffer, or the
+ * null pointer if \a str is not on an allocated memory (or is empty).
+ */
+__EXPORT zStream *zStreamOpenGrowMem(zStream *str, size_t capacity);
+__EXPORT bool zStreamReserve(zStream *str, size_t capacity);
+__EXPORT byte *zStreamDetachBuf(zStream *str, size_t *size);
+
+/*! \brief map a file to a stream.
+ *
+ * zStreamOpenMmap() maps a file \a filename to the memory, and attaches
+ * it to a stream \a str, so that zStreamRead() on \a str is served as a
+ * copy from the mapped memory.
+ * If \a mode includes neither 'w' nor '+', the whole file is mapped
+ * read-only, and zStreamWrite() on \a str always fails. \a size is
+ * ignored in this case. If the file cannot be mapped, it is loaded into
+ * an allocated memory instead.
+ * If \a mode includes 'w', a file with \a size bytes is newly created
+ * and mapped read-write. If \a mode includes '+' without 'w', an existing
+ * file is resized to \a size bytes and mapped read-write; it keeps its
+ * size if \a size is zero. What is written to \a str is reflected to the
+ * file, which does not grow beyond the mapped size.
+ * zStreamClose() unmaps the file.
+ * \return
+ * a pointer \a str is returned if succeeding to map the file. Otherwise,
+ * the null pointer is returned.
+ */
+__EXPORT zStream *zStreamOpenMmap(zStream *str, char filename[], char *mode, size_t size);
+
 /*!
  * \def zStreamRewind
  * \brief set the current position to the head of a stream.
@@ -106,6 +171,265 @@ __EXPORT zStream *zStreamOpenMem(zStream *str, size_t size);
 #define zStreamWrite(s,m,u,n) (*(s)->write)( (s), (m), (u), (n) )
 #define zStreamClose(s)       (*(s)->close)( (s) )
 
+/*! \brief default size of the read buffer of a stream. */
+#define ZSTREAM_BUFSIZ 0x10000
+
+/*! \brief buffered character access to a stream.
+ *
+ * zStreamSetBuffer() puts a read buffer of \a size bytes on a stream
+ * \a str. Afterwards, data are read from the underlying source in large
+ * chunks, and zStreamRead(), zStreamSeek(), zStreamTell(), zStreamRewind()
+ * and zStreamWrite() keep working consistently with the buffer. If \a size
+ * is zero, ZSTREAM_BUFSIZ is applied.
+ * zStreamUnsetBuffer() removes the read buffer from \a str, and moves the
+ * position of the underlying source to the current position of \a str.
+ * zStreamClose() also frees the buffer.
+ *
+ * zStreamGetc() reads a character from \a str.
+ * zStreamPeek() returns the next character of \a str without reading it.
+ * zStreamUngetc() pushes a character \a c back to \a str, so that it is
+ * read next. At least ZSTREAM_PUTBACK characters can be pushed back.
+ * A read buffer is put on \a str automatically by those functions.
+ * \return
+ * zStreamSetBuffer() returns the true value if it succeeds, or the false
+ * value if it fails to allocate the buffer.
+ * zStreamUnsetBuffer() returns no value.
+ * zStreamGetc() and zStreamPeek() return the character as an unsigned
+ * char cast to an int, or EOF at the end of \a str.
+ * zStreamUngetc() returns \a c, or EOF if it fails to push it back.
+ */
+#define ZSTREAM_PUTBACK 16
+__EXPORT bool zStreamSetBuffer(zStream *str, size_t size);
+__EXPORT void zStreamUnsetBuffer(zStream *str);
+__EXPORT int zStreamGetc(zStream *str);
+__EXPORT int zStreamPeek(zStream *str);
+__EXPORT int zStreamUngetc(zStream *str, int c);
+
+/*! \brief default number and size of buffers of a read-ahead prefetcher. */
+#define ZSTREAM_PREFETCH_NUM    4
+#define ZSTREAM_PREFETCH_BUFSIZ 0x100000
+
+/*! \brief read-ahead prefetching of a stream.
+ *
+ * zStreamSetPrefetch() puts a read-ahead prefetcher on a stream \a str.
+ * A helper thread fills a ring of \a nbuf buffers of \a size bytes with
+ * data read ahead from the underlying source, so that reading the source
+ * overlaps processing of data on the consumer side. If \a nbuf is less
+ * than two or \a size is zero, ZSTREAM_PREFETCH_NUM or
+ * ZSTREAM_PREFETCH_BUFSIZ is applied, respectively. If \a str is a file,
+ * the system is also advised to read it sequentially.
+ * Any function to read \a str, including tokenizers and zStreamGetc(),
+ * works on a prefetched stream as it does. zStreamSeek(), zStreamRewind()
+ * and zStreamWrite() are also available; they stop the helper thread and
+ * restart it from the new position.
+ * Since the helper thread owns the underlying source while it runs, the
+ * source (e.g. the file pointer) must not be accessed directly.
+ * zStreamUnsetPrefetch() removes the prefetcher from \a str, and moves the
+ * position of the underlying source to the current position of \a str.
+ * zStreamClose() also removes the prefetcher.
+ * Prefetching is not applied to a stream on the memory. Without the
+ * thread library, a large read buffer is put on \a str instead.
+ * \return
+ * zStreamSetPrefetch() returns the true value if it succeeds, or the
+ * false value if it fails to allocate buffers or to create the thread.
+ * zStreamUnsetPrefetch() returns no value.
+ */
+__EXPORT bool zStreamSetPrefetch(zStream *str, int nbuf, size_t size);
+__EXPORT void zStreamUnsetPrefetch(zStream *str);
+
+/*! \brief access patterns of a mapped file. */
+#define ZSTREAM_ADVICE_NORMAL     0
+#define ZSTREAM_ADVICE_SEQUENTIAL 1
+#define ZSTREAM_ADVICE_RANDOM     2
+#define ZSTREAM_ADVICE_WILLNEED   3
+
+/*! \brief zero-copy access to a stream on the memory.
+ *
+ * zStreamIsMapped() checks if a stream \a str is a file mapped by
+ * zStreamOpenMmap().
+ *
+ * zStreamAdvise() tells the expected access pattern of a mapped file
+ * \a str to the system. \a advice is one of ZSTREAM_ADVICE_NORMAL,
+ * ZSTREAM_ADVICE_SEQUENTIAL (read-ahead aggressively and drop pages
+ * soon after being read), ZSTREAM_ADVICE_RANDOM (no read-ahead) and
+ * ZSTREAM_ADVICE_WILLNEED (read the whole in advance).
+ *
+ * zStreamView() returns a pointer to \a len bytes at the current
+ * position of a stream \a str on the memory, namely, either a mapped file
+ * or an attached memory space, and moves the current position forward by
+ * \a len bytes. The bytes are not copied, and are valid until \a str is
+ * closed.
+ * \return
+ * zStreamIsMapped() returns the true value if \a str is a mapped file,
+ * or the false value otherwise.
+ * zStreamAdvise() returns the true value if the advice is accepted, or
+ * the false value if \a str is not a mapped file or the system rejects it.
+ * zStreamView() returns the pointer to the bytes, or the null pointer if
+ * \a str is not on the memory or less than \a len bytes remain.
+ */
+__EXPORT bool zStreamIsMapped(zStream *str);
+__EXPORT bool zStreamAdvise(zStream *str, int advice);
+__EXPORT const byte *zStreamView(zStream *str, size_t len);
+
+/*! \brief size of a block of a filter stream. */
+#define ZSTREAM_FILTER_BLKSIZ 0x10000
+/*! \brief maximum size of a block of a compression filter. */
+#define ZSTREAM_LZ_BLKSIZ_MAX 0x4000000
+
+/*! \brief filter streams.
+ *
+ * A filter stream wraps another stream \a sink, and transforms data
+ * read from or written to \a sink on the fly. Since a filter stream is
+ * also a stream, filters can be stacked to build a pipeline, e.g. a
+ * compression filter on a checksumming filter on a tee to files. Data
+ * are transformed in a block passed to zStreamRead() or zStreamWrite()
+ * as a whole, or in blocks of ZSTREAM_FILTER_BLKSIZ bytes.
+ * zStreamClose() on a filter stream flushes data left in the filter and
+ * frees it, but does not close \a sink.
+ *
+ * zStreamOpenEndianFilter() opens a byte order conversion filter \a str
+ * on \a sink, the byte order of which is \a endian (either Z_ENDIAN_LITTLE
+ * or Z_ENDIAN_BIG). Data cells of 2, 4 and 8 bytes passed to zStreamRead()
+ * and zStreamWrite() are converted between \a endian and that of the host.
+ *
+ * zStreamOpenCRCFilter() opens a checksumming filter \a str on \a sink.
+ * zStreamFilterCRC() returns CRC-32C of data read or written so far.
+ * Note that a read buffer put on \a str, e.g. by zStreamGetc() or a
+ * tokenizer, reads data ahead from \a sink through the filter, so that
+ * the checksum also covers data in the buffer not consumed yet. Read
+ * \a str with zStreamRead() only to checksum exactly the data consumed.
+ *
+ * zStreamOpenLZFilter() opens a compression filter \a str on \a sink.
+ * Data written to \a str are compressed with zLZCompress() in blocks of
+ * \a blksize bytes (ZSTREAM_FILTER_BLKSIZ if zero, and at most
+ * ZSTREAM_LZ_BLKSIZ_MAX), and data read from \a str are decompressed.
+ * A block larger than ZSTREAM_LZ_BLKSIZ_MAX is rejected as broken. A compression filter is used either for
+ * writing or for reading. zStreamSeek() on it fails except for the
+ * current position, while zStreamTell() returns the position in the raw
+ * data.
+ *
+ * zStreamOpenTeeFilter() opens a tee filter \a str on \a nsink streams
+ * \a sink. Data written to \a str are written to all of \a sink, and data
+ * read from \a str are read from \a sink[0] and copied to the others.
+ * \a sink has to be kept while \a str is open.
+ *
+ * zStreamOpenCountFilter() opens a counting filter \a str on \a sink.
+ * zStreamFilterGetStat() stores numbers of bytes read and written
+ * through \a str, the time elapsed since \a str was opened and the
+ * transfer rates to \a stat. It also works on a compression filter, in
+ * which case the numbers are of raw data. Data read ahead into a read
+ * buffer put on \a str are not counted until they are consumed.
+ * \return
+ * zStreamOpenEndianFilter(), zStreamOpenCRCFilter(), zStreamOpenLZFilter(),
+ * zStreamOpenTeeFilter() and zStreamOpenCountFilter() return a pointer
+ * \a str if succeeding, or the null pointer if failing to allocate the
+ * internal workspace.
+ * zStreamFilterCRC() returns the checksum, or zero if \a str is not a
+ * filter stream.
+ * zStreamFilterGetStat() returns the false value if \a str is not a filter
+ * stream, or the true value otherwise.
+ */
+typedef struct{
+  size_t nread, nwrite;  /* bytes read and written */
+  double elapsed;        /* elapsed time in second */
+  double read_rate, write_rate; /* transfer rates in byte per second */
+} zStreamFilterStat;
+
+__EXPORT zStream *zStreamOpenEndianFilter(zStream *str, zStream *sink, int endian);
+__EXPORT zStream *zStreamOpenCRCFilter(zStream *str, zStream *sink);
+__EXPORT uint32_t zStreamFilterCRC(zStream *str);
+__EXPORT zStream *zStreamOpenLZFilter(zStream *str, zStream *sink, size_t blksize);
+__EXPORT zStream *zStreamOpenTeeFilter(zStream *str, zStream *sink[], int nsink);
+__EXPORT zStream *zStreamOpenCountFilter(zStream *str, zStream *sink);
+__EXPORT bool zStreamFilterGetStat(zStream *str, zStreamFilterStat *stat);
+
+/* ********************************************************** */
+/*! \struct zStreamAIOReq
+ * \brief read request to a batched asynchronous reader.
+ *
+ * A request to read \a size bytes at \a offset of a file \a filename.
+ * If \a size is zero, the rest of the file from \a offset is read.
+ * Data are stored in \a buf. If \a buf is the null pointer, a buffer is
+ * allocated, which has to be freed by the caller. \a data is an arbitrary
+ * pointer for the caller to identify the request.
+ * \a len and \a error are set on completion: \a len is the number of
+ * bytes actually read, and \a error is zero if succeeding, or the error
+ * number otherwise.
+ *//* ******************************************************* */
+typedef struct _zStreamAIOReq{
+  char *filename;
+  long offset;
+  size_t size;
+  byte *buf;
+  void *data;
+  size_t len;
+  int error;
+  /*! \cond */
+  struct _zStreamAIOReq *_next;
+  /*! \endcond */
+} zStreamAIOReq;
+
+/*! \brief attach data read by a request to a stream.
+ *
+ * The buffer of the request \a r is freed by zStreamClose() on \a s.
+ */
+#define zStreamAIOAttach(s,r) zStreamAttachMem( s, (r)->buf, (r)->len )
+
+/* ********************************************************** */
+/*! \struct zStreamAIO
+ * \brief batched asynchronous reader.
+ *
+ * zStreamAIO class reads many files or many ranges of files
+ * concurrently, so that the storage is kept busy while data read
+ * are parsed.
+ *//* ******************************************************* */
+typedef struct{
+  /*! \cond */
+  void *_aio;
+  /*! \endcond */
+} zStreamAIO;
+
+/*! \brief default number of threads and queue depth of a batched asynchronous reader. */
+#define ZSTREAM_AIO_THREAD_NUM 4
+#define ZSTREAM_AIO_DEPTH      64
+
+/*! \brief batched asynchronous read.
+ *
+ * zStreamAIOInit() initializes a batched asynchronous reader \a aio with
+ * \a nthread worker threads, which accepts up to \a depth requests in
+ * flight. If \a nthread or \a depth is not positive, ZSTREAM_AIO_THREAD_NUM
+ * or ZSTREAM_AIO_DEPTH is applied, respectively.
+ * zStreamAIODestroy() destroys \a aio. Requests not reaped are abandoned.
+ *
+ * zStreamAIOSubmit() submits a request \a req to \a aio. \a req has to
+ * be kept until it is reaped. If \a depth requests are already in flight,
+ * it refuses \a req; some have to be reaped before submitting it again.
+ * zStreamAIOWait() reaps a completed request from \a aio. It waits for
+ * one to be completed if none has been completed yet.
+ * zStreamAIOPoll() reaps a completed request from \a aio without waiting.
+ * Requests are reaped in the order of completion.
+ * zStreamAIOPending() counts requests submitted and not reaped yet.
+ *
+ * The requests are served by a pool of threads with pread() (not by the
+ * kernel asynchronous I/O interface). Without the thread library, they
+ * are served synchronously on submission.
+ * \return
+ * zStreamAIOInit() returns the true value if succeeding to allocate the
+ * internal workspace and to create threads, or the false value otherwise.
+ * zStreamAIOSubmit() returns the true value if \a req is accepted, or
+ * the false value if \a depth requests are in flight.
+ * zStreamAIOWait() and zStreamAIOPoll() return a pointer to the completed
+ * request, or the null pointer if no request is in flight (zStreamAIOWait())
+ * or none has been completed (zStreamAIOPoll()).
+ * zStreamAIOPending() returns the number of requests in flight.
+ */
+__EXPORT bool zStreamAIOInit(zStreamAIO *aio, int nthread, int depth);
+__EXPORT void zStreamAIODestroy(zStreamAIO *aio);
+__EXPORT bool zStreamAIOSubmit(zStreamAIO *aio, zStreamAIOReq *req);
+__EXPORT zStreamAIOReq *zStreamAIOWait(zStreamAIO *aio);
+__EXPORT zStreamAIOReq *zStreamAIOPoll(zStreamAIO *aio);
+__EXPORT int zStreamAIOPending(zStreamAIO *aio);
+
 /*! \} */
 
 __END_DECLS
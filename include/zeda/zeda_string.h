@@ -10,6 +10,7 @@
 #define __ZEDA_STRING_H__
 
 #include <zeda/zeda_misc.h>
+#include <zeda/zeda_stream.h>
 
 __BEGIN_DECLS
 
@@ -692,6 +693,33 @@ __EXPORT int zFCountKey(FILE *fp, char *key);
  */
 __EXPORT bool zFieldFScan(FILE *fp, bool (* field_fscan)(FILE*,void*,char*,bool*), void *instance);
 
+/*! \brief tokenize a stream.
+ *
+ * zStreamSkipWS(), zStreamSkipIncludedChar(), zStreamSkipDelimiter(),
+ * zStreamSkipComment(), zStreamToken(), zStreamIntToken(),
+ * zStreamNumToken(), zStreamInt(), zStreamDouble() and
+ * zStreamPostCheckKey() are counterparts of zFSkipWS(),
+ * zFSkipIncludedChar(), zFSkipDelimiter(), zFSkipComment(), zFToken(),
+ * zFIntToken(), zFNumToken(), zFInt(), zFDouble() and zFPostCheckKey()
+ * for a stream \a str, respectively.
+ *
+ * They read \a str through its read buffer (see zStreamGetc()), so that
+ * files and memory are tokenized in the same way without a system call
+ * per charactor.
+ * \return
+ * The same with the counterparts.
+ */
+__EXPORT char zStreamSkipWS(zStream *str);
+__EXPORT char zStreamSkipIncludedChar(zStream *str, char *s);
+__EXPORT char zStreamSkipDelimiter(zStream *str);
+__EXPORT char zStreamSkipComment(zStream *str);
+__EXPORT char *zStreamToken(zStream *str, char *tkn, size_t size);
+__EXPORT char *zStreamIntToken(zStream *str, char *tkn, size_t size);
+__EXPORT char *zStreamNumToken(zStream *str, char *tkn, size_t size);
+__EXPORT char *zStreamInt(zStream *str, int *val);
+__EXPORT char *zStreamDouble(zStream *str, double *val);
+__EXPORT bool zStreamPostCheckKey(zStream *str);
+
 #endif /* __KERNEL__ */
 
 /*! \brief insert whitespaces before a string.
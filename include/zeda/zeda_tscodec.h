@@ -0,0 +1,80 @@
+/* ZEDA - Elementary Data and Algorithms
+ * Copyright (C) 1998 Tomomichi Sugihara (Zhidao)
+ */
+/*! \file zeda_tscodec.h
+ * \brief compression of time series of numbers.
+ * \author Zhidao
+ */
+
+#ifndef __ZEDA_TSCODEC_H__
+#define __ZEDA_TSCODEC_H__
+
+#include <zeda/zeda_misc.h>
+
+__BEGIN_DECLS
+
+/* ********************************************************** */
+/*! \defgroup tscodec compression of time series.
+ * \{ *//* ************************************************** */
+
+/*! \brief the maximum size of a compressed time series.
+ *
+ * zTSCompressBound() is the maximum size of a series of \a n values
+ * compressed by zTSDoubleCompress() or zTSInt64Compress(), which is
+ * enough for their destinations.
+ * ZTS_COMPRESS_NUM_MAX is the maximum number of values whose compressed
+ * size is bounded within a 32-bit signed integer.
+ */
+#define zTSCompressBound(n) ( (n)*10 + 16 )
+#define ZTS_COMPRESS_NUM_MAX ( ( 0x7fffffff - zTSCompressBound(0) ) / ( zTSCompressBound(1) - zTSCompressBound(0) ) )
+
+/*! \brief compress and decompress a time series of double-precision
+ * floating-point values.
+ *
+ * zTSDoubleCompress() compresses \a n values of an array \a src and
+ * stores the result into a buffer \a dst of \a dstsize bytes.
+ * zTSDoubleDecompress() decompresses \a srcsize bytes of compressed
+ * data \a src and stores the values into an array \a dst of \a n values.
+ *
+ * Each value is exclusive-or'ed with the previous one, and only the
+ * meaningful bits between the leading and trailing zeros of the result
+ * are stored. If the meaningful bits fit in the window of the previous
+ * value, the window is reused. A value equal to the previous one costs
+ * only one bit, and slowly changing values such as joint angles of a
+ * robot cost much less than eight bytes.
+ *
+ * The compressed data is a bit stream independent of the byte order of
+ * the host.
+ * \return
+ * zTSDoubleCompress() returns the size of the compressed data, or zero
+ * if \a dstsize is not enough to store it.
+ * zTSDoubleDecompress() returns the number of decompressed values, which
+ * is less than \a n if \a src is broken or too short.
+ */
+__EXPORT size_t zTSDoubleCompress(const double *src, size_t n, void *dst, size_t dstsize);
+__EXPORT size_t zTSDoubleDecompress(const void *src, size_t srcsize, double *dst, size_t n);
+
+/*! \brief compress and decompress a time series of 64-bit integers.
+ *
+ * zTSInt64Compress() compresses \a n values of an array \a src and
+ * stores the result into a buffer \a dst of \a dstsize bytes.
+ * zTSInt64Decompress() decompresses \a srcsize bytes of compressed
+ * data \a src and stores the values into an array \a dst of \a n values.
+ *
+ * The difference of successive deltas is stored with a variable-length
+ * prefix code, so that timestamps sampled at a regular interval cost
+ * one bit per value.
+ * \return
+ * zTSInt64Compress() returns the size of the compressed data, or zero
+ * if \a dstsize is not enough to store it.
+ * zTSInt64Decompress() returns the number of decompressed values, which
+ * is less than \a n if \a src is broken or too short.
+ */
+__EXPORT size_t zTSInt64Compress(const int64_t *src, size_t n, void *dst, size_t dstsize);
+__EXPORT size_t zTSInt64Decompress(const void *src, size_t srcsize, int64_t *dst, size_t n);
+
+/*! \} */
+
+__END_DECLS
+
+#endif /* __ZEDA_TSCODEC_H__ */
@@ -112,6 +112,13 @@ __EXPORT ZTK *ZTKInit(ZTK *ztk);
 /*! \brief destroy a ZTK format processor. */
 __EXPORT void ZTKDestroy(ZTK *ztk);
 
+/*! \brief scan and parse a stream into a tag-and-key list of a ZTK format processor.
+ *
+ * The stream \a str is read through its read buffer (see zStreamGetc()),
+ * which is kept attached to \a str after parsing.
+ */
+__EXPORT bool ZTKParseStream(ZTK *ztk, zStream *str);
+
 /*! \brief scan and parse a file stream into a tag-and-key list of a ZTK format processor. */
 __EXPORT bool ZTKParseFP(ZTK *ztk, FILE *fp);
 
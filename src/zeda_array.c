@@ -6,6 +6,10 @@
 
 #include <zeda/zeda_array.h>
 
+#ifdef __ZEDA_USE_PTHREAD
+#include <pthread.h>
+#endif /* __ZEDA_USE_PTHREAD */
+
 /* quick sort for an array of pointers. */
 void zQuickSort(void *array, size_t nmemb, size_t size, int (* cmp)(void*,void*,void*), void *priv)
 {
@@ -37,13 +41,709 @@ void zQuickSort(void *array, size_t nmemb, size_t size, int (* cmp)(void*,void*,
 void *zInsertSort(void *array, void *memb, uint i, size_t nmemb, size_t size, int (* cmp)(void*,void*,void*), void *priv)
 {
   byte *p;
+  uint lo, hi, mid;
 
   if( i >= nmemb ){
     ZRUNERROR( "array already occupied" );
     return NULL;
   }
-  for( p=(byte*)array+size*i; p > (byte*)array && cmp( p-size, memb, priv ) > 0; p-=size ){
-    memcpy( p, p-size, size );
+  /* binary search of the position after equal members */
+  for( lo=0, hi=i; lo<hi; ){
+    mid = ( lo + hi ) / 2;
+    if( cmp( (byte*)array+size*mid, memb, priv ) > 0 )
+      hi = mid;
+    else
+      lo = mid + 1;
   }
+  p = (byte*)array + size*lo;
+  memmove( p+size, p, size*(i-lo) );
   return memcpy( p, memb, size );
 }
+
+#ifndef __KERNEL__
+/* parallel sort */
+
+typedef struct{
+  size_t lo, mid, hi; /* runs [lo,mid) and [mid,hi) to be merged, or a block [lo,hi) to be sorted */
+  size_t k0, k1;      /* range of the merged run to be output */
+} _zParallelSortTask;
+
+typedef struct{
+  byte *src, *dst;
+  size_t size;
+  int (* cmp)(void*,void*,void*);
+  void *priv;
+  bool merge;
+  _zParallelSortTask *task;
+  size_t ntask;
+  int nthread;
+} _zParallelSort;
+
+typedef struct{
+  _zParallelSort *ps;
+  int id;
+} _zParallelSortWorker;
+
+/* find the number of cells taken from the first run for the first k cells of the merged run. */
+static size_t _zParallelSortCorank(_zParallelSort *ps, byte *a, size_t n, byte *b, size_t m, size_t k)
+{
+  size_t lo, hi, i;
+
+  lo = k > m ? k - m : 0;
+  hi = _zMin( k, n );
+  while( lo < hi ){
+    i = ( lo + hi ) / 2;
+    /* a[i] precedes b[k-i-1] unless the latter is strictly less */
+    if( ps->cmp( b+ps->size*(k-i-1), a+ps->size*i, ps->priv ) >= 0 )
+      lo = i + 1;
+    else
+      hi = i;
+  }
+  return lo;
+}
+
+/* merge a part of two runs stably. */
+static void _zParallelSortMerge(_zParallelSort *ps, _zParallelSortTask *task)
+{
+  byte *a, *b, *out;
+  size_t n, m, i, j, iend, jend, size;
+
+  size = ps->size;
+  a = ps->src + size*task->lo; n = task->mid - task->lo;
+  b = ps->src + size*task->mid; m = task->hi - task->mid;
+  i = _zParallelSortCorank( ps, a, n, b, m, task->k0 ); j = task->k0 - i;
+  iend = _zParallelSortCorank( ps, a, n, b, m, task->k1 ); jend = task->k1 - iend;
+  out = ps->dst + size*( task->lo + task->k0 );
+  while( i < iend && j < jend ){
+    if( ps->cmp( b+size*j, a+size*i, ps->priv ) < 0 )
+      memcpy( out, b+size*j++, size );
+    else
+      memcpy( out, a+size*i++, size );
+    out += size;
+  }
+  memcpy( out, a+size*i, size*(iend-i) );
+  memcpy( out+size*(iend-i), b+size*j, size*(jend-j) );
+}
+
+/* serve tasks assigned to a worker. */
+static void *_zParallelSortWork(void *arg)
+{
+  _zParallelSortWorker *worker;
+  _zParallelSort *ps;
+  size_t i;
+
+  worker = (_zParallelSortWorker *)arg;
+  ps = worker->ps;
+  for( i=worker->id; i<ps->ntask; i+=ps->nthread ){
+    if( ps->merge )
+      _zParallelSortMerge( ps, &ps->task[i] );
+    else
+      zQuickSort( ps->src+ps->size*ps->task[i].lo, ps->task[i].hi-ps->task[i].lo, ps->size, ps->cmp, ps->priv );
+  }
+  return NULL;
+}
+
+/* serve all tasks with workers. */
+static void _zParallelSortRun(_zParallelSort *ps)
+{
+  _zParallelSortWorker worker[ZARRAY_PSORT_MAX_THREAD];
+#ifdef __ZEDA_USE_PTHREAD
+  pthread_t thread[ZARRAY_PSORT_MAX_THREAD];
+  bool created[ZARRAY_PSORT_MAX_THREAD];
+#endif /* __ZEDA_USE_PTHREAD */
+  int i;
+
+  for( i=0; i<ps->nthread; i++ ){
+    worker[i].ps = ps;
+    worker[i].id = i;
+  }
+#ifdef __ZEDA_USE_PTHREAD
+  for( i=1; i<ps->nthread; i++ )
+    created[i] = pthread_create( &thread[i], NULL, _zParallelSortWork, &worker[i] ) == 0;
+  _zParallelSortWork( &worker[0] );
+  for( i=1; i<ps->nthread; i++ ){
+    if( created[i] )
+      pthread_join( thread[i], NULL );
+    else
+      _zParallelSortWork( &worker[i] ); /* failed to create a thread */
+  }
+#else
+  for( i=0; i<ps->nthread; i++ )
+    _zParallelSortWork( &worker[i] );
+#endif /* __ZEDA_USE_PTHREAD */
+}
+
+/* parallel sort for an array of pointers. */
+bool zParallelSort(void *array, size_t nmemb, size_t size, int (* cmp)(void*,void*,void*), void *priv, int nthread, size_t cutoff)
+{
+  _zParallelSort ps;
+  byte *buf;
+  size_t width, seg, lo, k;
+
+  if( nthread <= 0 ) nthread = ZARRAY_PSORT_THREAD_NUM;
+  if( nthread > ZARRAY_PSORT_MAX_THREAD ) nthread = ZARRAY_PSORT_MAX_THREAD;
+  if( cutoff == 0 ) cutoff = ZARRAY_PSORT_CUTOFF;
+  if( nmemb <= cutoff ){
+    zQuickSort( array, nmemb, size, cmp, priv );
+    return true;
+  }
+  ps.task = zAlloc( _zParallelSortTask, ( nmemb + cutoff - 1 ) / cutoff + nthread + 2 );
+  buf = zAlloc( byte, nmemb*size );
+  if( !ps.task || !buf ){
+    ZALLOCERROR();
+    free( ps.task );
+    free( buf );
+    return false;
+  }
+  ps.size = size;
+  ps.cmp = cmp;
+  ps.priv = priv;
+  ps.nthread = nthread;
+  /* sort blocks */
+  ps.src = (byte *)array;
+  ps.merge = false;
+  for( ps.ntask=0, lo=0; lo<nmemb; lo+=cutoff, ps.ntask++ ){
+    ps.task[ps.ntask].lo = lo;
+    ps.task[ps.ntask].hi = _zMin( lo + cutoff, nmemb );
+  }
+  _zParallelSortRun( &ps );
+  /* merge runs bottom-up */
+  ps.dst = buf;
+  ps.merge = true;
+  seg = _zMax( cutoff, ( nmemb + nthread - 1 ) / nthread );
+  for( width=cutoff; width<nmemb; width*=2 ){
+    for( ps.ntask=0, lo=0; lo<nmemb; lo+=2*width )
+      for( k=0; k<_zMin(lo+2*width,nmemb)-lo; k+=seg, ps.ntask++ ){
+        ps.task[ps.ntask].lo = lo;
+        ps.task[ps.ntask].mid = _zMin( lo + width, nmemb );
+        ps.task[ps.ntask].hi = _zMin( lo + 2*width, nmemb );
+        ps.task[ps.ntask].k0 = k;
+        ps.task[ps.ntask].k1 = _zMin( k + seg, ps.task[ps.ntask].hi - lo );
+      }
+    _zParallelSortRun( &ps );
+    zSwap( byte*, ps.src, ps.dst );
+  }
+  if( ps.src != (byte *)array )
+    memcpy( array, ps.src, nmemb*size );
+  free( ps.task );
+  free( buf );
+  return true;
+}
+#endif /* __KERNEL__ */
+
+#ifndef __KERNEL__
+/* radix sort */
+
+/* LSD radix sort for 32-bit unsigned integers. */
+static void _zRadixSort32(uint32_t *array, uint32_t *tmp, size_t nmemb)
+{
+  size_t count[4][0x100], i, sum, c;
+  uint32_t *src, *dst;
+  int p;
+
+  memset( count, 0, sizeof(count) );
+  for( i=0; i<nmemb; i++ )
+    for( p=0; p<4; p++ )
+      count[p][( array[i] >> ( p << 3 ) ) & 0xff]++;
+  for( src=array, dst=tmp, p=0; p<4; p++ ){
+    if( count[p][( src[0] >> ( p << 3 ) ) & 0xff] == nmemb ) continue; /* all the same digit */
+    for( sum=0, i=0; i<0x100; i++ ){
+      c = count[p][i]; count[p][i] = sum; sum += c;
+    }
+    for( i=0; i<nmemb; i++ )
+      dst[count[p][( src[i] >> ( p << 3 ) ) & 0xff]++] = src[i];
+    zSwap( uint32_t*, src, dst );
+  }
+  if( src != array )
+    memcpy( array, src, sizeof(uint32_t)*nmemb );
+}
+
+/* LSD radix sort for 64-bit unsigned integers. */
+static void _zRadixSort64(uint64_t *array, uint64_t *tmp, size_t nmemb)
+{
+  size_t count[8][0x100], i, sum, c;
+  uint64_t *src, *dst;
+  int p;
+
+  memset( count, 0, sizeof(count) );
+  for( i=0; i<nmemb; i++ )
+    for( p=0; p<8; p++ )
+      count[p][( array[i] >> ( p << 3 ) ) & 0xff]++;
+  for( src=array, dst=tmp, p=0; p<8; p++ ){
+    if( count[p][( src[0] >> ( p << 3 ) ) & 0xff] == nmemb ) continue; /* all the same digit */
+    for( sum=0, i=0; i<0x100; i++ ){
+      c = count[p][i]; count[p][i] = sum; sum += c;
+    }
+    for( i=0; i<nmemb; i++ )
+      dst[count[p][( src[i] >> ( p << 3 ) ) & 0xff]++] = src[i];
+    zSwap( uint64_t*, src, dst );
+  }
+  if( src != array )
+    memcpy( array, src, sizeof(uint64_t)*nmemb );
+}
+
+/* order-preserving unsigned key of a 32-bit signed integer. */
+uint64_t zRadixKeyInt32(int32_t val)
+{
+  return (uint32_t)val ^ 0x80000000UL;
+}
+
+/* order-preserving unsigned key of a 64-bit signed integer. */
+uint64_t zRadixKeyInt64(int64_t val)
+{
+  return (uint64_t)val ^ ( (uint64_t)1 << 63 );
+}
+
+/* order-preserving unsigned key of a single-precision floating-point value. */
+uint64_t zRadixKeyFloat(float val)
+{
+  uint32_t u;
+
+  memcpy( &u, &val, sizeof(uint32_t) );
+  return u & 0x80000000UL ? (uint32_t)~u : u | 0x80000000UL;
+}
+
+/* order-preserving unsigned key of a double-precision floating-point value. */
+uint64_t zRadixKeyDouble(double val)
+{
+  uint64_t u, sign = (uint64_t)1 << 63;
+
+  memcpy( &u, &val, sizeof(uint64_t) );
+  return u & sign ? ~u : u | sign;
+}
+
+/* radix sort for an array of 32-bit signed integers. */
+bool zRadixSortInt32(int32_t *array, size_t nmemb)
+{
+  uint32_t *tmp;
+  size_t i;
+
+  if( nmemb <= 1 ) return true;
+  if( !( tmp = zAlloc( uint32_t, nmemb ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  for( i=0; i<nmemb; i++ ) ((uint32_t*)array)[i] ^= 0x80000000UL;
+  _zRadixSort32( (uint32_t*)array, tmp, nmemb );
+  for( i=0; i<nmemb; i++ ) ((uint32_t*)array)[i] ^= 0x80000000UL;
+  free( tmp );
+  return true;
+}
+
+/* radix sort for an array of 64-bit signed integers. */
+bool zRadixSortInt64(int64_t *array, size_t nmemb)
+{
+  uint64_t *tmp, sign = (uint64_t)1 << 63;
+  size_t i;
+
+  if( nmemb <= 1 ) return true;
+  if( !( tmp = zAlloc( uint64_t, nmemb ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  for( i=0; i<nmemb; i++ ) ((uint64_t*)array)[i] ^= sign;
+  _zRadixSort64( (uint64_t*)array, tmp, nmemb );
+  for( i=0; i<nmemb; i++ ) ((uint64_t*)array)[i] ^= sign;
+  free( tmp );
+  return true;
+}
+
+/* radix sort for an array of single-precision floating-point values. */
+bool zRadixSortFloat(float *array, size_t nmemb)
+{
+  uint32_t *buf, *tmp, u;
+  size_t i;
+
+  if( nmemb <= 1 ) return true;
+  if( !( buf = zAlloc( uint32_t, nmemb*2 ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  tmp = buf + nmemb;
+  for( i=0; i<nmemb; i++ )
+    buf[i] = (uint32_t)zRadixKeyFloat( array[i] );
+  _zRadixSort32( buf, tmp, nmemb );
+  for( i=0; i<nmemb; i++ ){
+    u = buf[i] & 0x80000000UL ? buf[i] ^ 0x80000000UL : ~buf[i];
+    memcpy( &array[i], &u, sizeof(uint32_t) );
+  }
+  free( buf );
+  return true;
+}
+
+/* radix sort for an array of double-precision floating-point values. */
+bool zRadixSortDouble(double *array, size_t nmemb)
+{
+  uint64_t *buf, *tmp, u, sign = (uint64_t)1 << 63;
+  size_t i;
+
+  if( nmemb <= 1 ) return true;
+  if( !( buf = zAlloc( uint64_t, nmemb*2 ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  tmp = buf + nmemb;
+  for( i=0; i<nmemb; i++ )
+    buf[i] = zRadixKeyDouble( array[i] );
+  _zRadixSort64( buf, tmp, nmemb );
+  for( i=0; i<nmemb; i++ ){
+    u = buf[i] & sign ? buf[i] ^ sign : ~buf[i];
+    memcpy( &array[i], &u, sizeof(uint64_t) );
+  }
+  free( buf );
+  return true;
+}
+
+typedef struct{
+  uint64_t key;
+  size_t id;
+} _zRadixPair;
+
+/* LSD radix sort for pairs of a key and an identifier. */
+static _zRadixPair *_zRadixSortPair(_zRadixPair *pair, _zRadixPair *tmp, size_t nmemb, int keysize)
+{
+  size_t count[0x100], i, sum, c;
+  int p;
+
+  for( p=0; p<keysize; p++ ){
+    memset( count, 0, sizeof(count) );
+    for( i=0; i<nmemb; i++ )
+      count[( pair[i].key >> ( p << 3 ) ) & 0xff]++;
+    if( count[( pair[0].key >> ( p << 3 ) ) & 0xff] == nmemb ) continue; /* all the same digit */
+    for( sum=0, i=0; i<0x100; i++ ){
+      c = count[i]; count[i] = sum; sum += c;
+    }
+    for( i=0; i<nmemb; i++ )
+      tmp[count[( pair[i].key >> ( p << 3 ) ) & 0xff]++] = pair[i];
+    zSwap( _zRadixPair*, pair, tmp );
+  }
+  return pair;
+}
+
+/* sort pairs of keys extracted from an array and identifiers. */
+static _zRadixPair *_zRadixSortKey(void *array, size_t nmemb, size_t size, uint64_t (* key)(void*,void*), void *priv, int keysize, _zRadixPair **buf)
+{
+  size_t i;
+
+  if( keysize <= 0 || keysize > 8 ) keysize = 8;
+  if( !( *buf = zAlloc( _zRadixPair, nmemb*2 ) ) ){
+    ZALLOCERROR();
+    return NULL;
+  }
+  for( i=0; i<nmemb; i++ ){
+    (*buf)[i].key = key( (byte*)array+size*i, priv );
+    (*buf)[i].id = i;
+  }
+  return _zRadixSortPair( *buf, *buf+nmemb, nmemb, keysize );
+}
+
+/* radix sort for an array with a key extractor. */
+bool zRadixSortKey(void *array, size_t nmemb, size_t size, uint64_t (* key)(void*,void*), void *priv, int keysize, void *scratch)
+{
+  _zRadixPair *buf, *pair;
+  byte *tmp;
+  size_t i;
+
+  if( nmemb <= 1 ) return true;
+  if( !( tmp = (byte *)scratch ) && !( tmp = zAlloc( byte, nmemb*size ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  if( !( pair = _zRadixSortKey( array, nmemb, size, key, priv, keysize, &buf ) ) ){
+    if( !scratch ) free( tmp );
+    return false;
+  }
+  for( i=0; i<nmemb; i++ )
+    memcpy( tmp+size*i, (byte*)array+size*pair[i].id, size );
+  memcpy( array, tmp, nmemb*size );
+  free( buf );
+  if( !scratch ) free( tmp );
+  return true;
+}
+
+/* sorting permutation of an array with a key extractor by radix sort. */
+bool zRadixSortPerm(void *array, size_t nmemb, size_t size, uint64_t (* key)(void*,void*), void *priv, int keysize, size_t *perm)
+{
+  _zRadixPair *buf, *pair;
+  size_t i;
+
+  if( nmemb == 0 ) return true;
+  if( !( pair = _zRadixSortKey( array, nmemb, size, key, priv, keysize, &buf ) ) )
+    return false;
+  for( i=0; i<nmemb; i++ )
+    perm[i] = pair[i].id;
+  free( buf );
+  return true;
+}
+#endif /* __KERNEL__ */
+
+#ifndef __KERNEL__
+/* stable merge sort */
+
+/* stable insertion sort for a short run. */
+static void _zMergeSortRun(byte *array, size_t nmemb, size_t size, int (* cmp)(void*,void*,void*), void *priv, byte *tmp)
+{
+  size_t i, lo, hi, mid;
+
+  for( i=1; i<nmemb; i++ ){
+    if( cmp( array+size*(i-1), array+size*i, priv ) <= 0 ) continue;
+    for( lo=0, hi=i-1; lo<hi; ){ /* find the position after equal members */
+      mid = ( lo + hi ) / 2;
+      if( cmp( array+size*mid, array+size*i, priv ) > 0 )
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    memcpy( tmp, array+size*i, size );
+    memmove( array+size*(lo+1), array+size*lo, size*(i-lo) );
+    memcpy( array+size*lo, tmp, size );
+  }
+}
+
+/* merge two adjacent sorted runs stably. */
+static void _zMergeSortMerge(byte *src, byte *dst, size_t n, size_t m, size_t size, int (* cmp)(void*,void*,void*), void *priv)
+{
+  byte *a, *b, *aend, *bend;
+
+  a = src; aend = b = src + size*n; bend = b + size*m;
+  if( n == 0 || m == 0 || cmp( aend-size, b, priv ) <= 0 ){ /* already in order */
+    memcpy( dst, src, size*(n+m) );
+    return;
+  }
+  while( a < aend && b < bend ){
+    if( cmp( b, a, priv ) < 0 ){
+      memcpy( dst, b, size ); b += size;
+    } else{
+      memcpy( dst, a, size ); a += size;
+    }
+    dst += size;
+  }
+  memcpy( dst, a, aend-a );
+  memcpy( dst+(aend-a), b, bend-b );
+}
+
+/* stable merge sort for an array of pointers. */
+bool zMergeSort(void *array, size_t nmemb, size_t size, int (* cmp)(void*,void*,void*), void *priv, void *scratch)
+{
+  byte *buf, *src, *dst;
+  size_t width, lo;
+
+  if( nmemb <= 1 ) return true;
+  if( !( buf = (byte *)scratch ) && !( buf = zAlloc( byte, nmemb*size ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  for( lo=0; lo<nmemb; lo+=ZARRAY_MSORT_RUN )
+    _zMergeSortRun( (byte*)array+size*lo, _zMin( ZARRAY_MSORT_RUN, nmemb-lo ), size, cmp, priv, buf );
+  for( src=(byte*)array, dst=buf, width=ZARRAY_MSORT_RUN; width<nmemb; width*=2 ){
+    for( lo=0; lo<nmemb; lo+=2*width )
+      _zMergeSortMerge( src+size*lo, dst+size*lo, _zMin( width, nmemb-lo ), lo+width < nmemb ? _zMin( width, nmemb-lo-width ) : 0, size, cmp, priv );
+    zSwap( byte*, src, dst );
+  }
+  if( src != (byte *)array )
+    memcpy( array, src, nmemb*size );
+  if( !scratch ) free( buf );
+  return true;
+}
+
+/* k-way merge */
+
+/* sift down a run in the heap of runs. */
+static void _zMergeSortedSiftDown(size_t *heap, size_t n, size_t i, byte **head, int (* cmp)(void*,void*,void*), void *priv)
+{
+  size_t c, r;
+  int d;
+
+  for( r=heap[i]; ( c = 2*i+1 ) < n; i=c ){
+    if( c+1 < n && ( ( d = cmp( head[heap[c+1]], head[heap[c]], priv ) ) < 0 || ( d == 0 && heap[c+1] < heap[c] ) ) )
+      c++;
+    if( ( d = cmp( head[heap[c]], head[r], priv ) ) > 0 || ( d == 0 && heap[c] > r ) ) break;
+    heap[i] = heap[c];
+  }
+  heap[i] = r;
+}
+
+/* merge sorted arrays into one array. */
+bool zMergeSorted(void *dest, void **src, size_t *nmemb, int k, size_t size, int (* cmp)(void*,void*,void*), void *priv)
+{
+  size_t *heap, n = 0, i, r;
+  byte **head, **tail, *dp;
+
+  if( k <= 0 ) return true;
+  heap = zAlloc( size_t, k );
+  head = zAlloc( byte*, k );
+  tail = zAlloc( byte*, k );
+  if( !heap || !head || !tail ){
+    ZALLOCERROR();
+    free( heap ); free( head ); free( tail );
+    return false;
+  }
+  for( r=0; r<(size_t)k; r++ ){
+    head[r] = (byte *)src[r];
+    tail[r] = head[r] + size*nmemb[r];
+    if( nmemb[r] > 0 ) heap[n++] = r;
+  }
+  for( i=n/2; i>0; i-- )
+    _zMergeSortedSiftDown( heap, n, i-1, head, cmp, priv );
+  for( dp=(byte *)dest; n>1; dp+=size ){
+    r = heap[0];
+    memcpy( dp, head[r], size );
+    if( ( head[r] += size ) == tail[r] ) heap[0] = heap[--n]; /* run exhausted */
+    _zMergeSortedSiftDown( heap, n, 0, head, cmp, priv );
+  }
+  if( n == 1 ) /* the last run */
+    memcpy( dp, head[heap[0]], tail[heap[0]]-head[heap[0]] );
+  free( heap );
+  free( head );
+  free( tail );
+  return true;
+}
+#endif /* __KERNEL__ */
+
+#ifndef __KERNEL__
+/* selection */
+
+/* swap two components of an array. */
+static void _zSelectSwap(byte *a, byte *b, size_t size)
+{
+  size_t i;
+
+  if( a == b ) return;
+  for( i=0; i<size; i++ )
+    zSwap( byte, a[i], b[i] );
+}
+
+/* sift down a component in a max-heap. */
+static void _zSelectSiftDown(byte *base, size_t i, size_t n, size_t size, int (* cmp)(void*,void*,void*), void *priv)
+{
+  size_t c;
+
+  for( ; ( c = 2*i+1 ) < n; i=c ){
+    if( c+1 < n && cmp( base+size*c, base+size*(c+1), priv ) < 0 ) c++;
+    if( cmp( base+size*i, base+size*c, priv ) >= 0 ) break;
+    _zSelectSwap( base+size*i, base+size*c, size );
+  }
+}
+
+/* heap sort for an array, which is the fallback of introselect. */
+static void _zSelectHeapSort(byte *base, size_t n, size_t size, int (* cmp)(void*,void*,void*), void *priv)
+{
+  size_t i;
+
+  for( i=n/2; i>0; i-- )
+    _zSelectSiftDown( base, i-1, n, size, cmp, priv );
+  for( i=n-1; i>0; i-- ){
+    _zSelectSwap( base, base+size*i, size );
+    _zSelectSiftDown( base, 0, i, size, cmp, priv );
+  }
+}
+
+/* put the n-th component of an array in place. */
+void *zNthElement(void *array, size_t nmemb, size_t size, size_t n, int (* cmp)(void*,void*,void*), void *priv)
+{
+  byte *base;
+  size_t lo, hi, mid, i, j;
+  int depth = 0;
+
+  if( n >= nmemb ) return NULL;
+  base = (byte *)array;
+  for( i=nmemb; i>1; i>>=1 ) depth += 2;
+  for( lo=0, hi=nmemb; hi-lo > ZARRAY_SORT_CUTOFF; ){
+    if( depth-- == 0 ){
+      _zSelectHeapSort( base+size*lo, hi-lo, size, cmp, priv );
+      return base + size*n;
+    }
+    /* median of three, moved to the head as the pivot */
+    mid = lo + ( hi - lo ) / 2;
+    if( cmp( base+size*lo, base+size*mid, priv ) > 0 ) _zSelectSwap( base+size*lo, base+size*mid, size );
+    if( cmp( base+size*mid, base+size*(hi-1), priv ) > 0 ){
+      _zSelectSwap( base+size*mid, base+size*(hi-1), size );
+      if( cmp( base+size*lo, base+size*mid, priv ) > 0 ) _zSelectSwap( base+size*lo, base+size*mid, size );
+    }
+    _zSelectSwap( base+size*lo, base+size*mid, size );
+    for( i=lo, j=hi; ; ){
+      do i++; while( i < hi && cmp( base+size*i, base+size*lo, priv ) < 0 );
+      do j--; while( cmp( base+size*j, base+size*lo, priv ) > 0 );
+      if( i >= j ) break;
+      _zSelectSwap( base+size*i, base+size*j, size );
+    }
+    _zSelectSwap( base+size*lo, base+size*j, size );
+    /* continue on the part which contains the n-th component */
+    if( n == j ) return base + size*n;
+    if( n < j ) hi = j;
+    else        lo = j + 1;
+  }
+  zQuickSort( base+size*lo, hi-lo, size, cmp, priv );
+  return base + size*n;
+}
+
+/* sort the first k components of an array. */
+void zPartialSort(void *array, size_t nmemb, size_t size, size_t k, int (* cmp)(void*,void*,void*), void *priv)
+{
+  if( k >= nmemb ){
+    _zSelectHeapSort( (byte *)array, nmemb, size, cmp, priv );
+    return;
+  }
+  if( k == 0 ) return;
+  /* the first k-1 components are not greater than the (k-1)th */
+  zNthElement( array, nmemb, size, k-1, cmp, priv );
+  _zSelectHeapSort( (byte *)array, k-1, size, cmp, priv );
+}
+
+/* initialize a top-k accumulator. */
+bool zTopKInit(zTopK *topk, size_t k, size_t size, int (* cmp)(void*,void*,void*), void *priv)
+{
+  topk->k = k;
+  topk->size = size;
+  topk->num = 0;
+  topk->cmp = cmp;
+  topk->priv = priv;
+  if( k == 0 ){
+    topk->buf = NULL;
+    return true;
+  }
+  if( !( topk->buf = zAlloc( byte, k*size ) ) ){
+    ZALLOCERROR();
+    topk->k = 0;
+    return false;
+  }
+  return true;
+}
+
+/* destroy a top-k accumulator. */
+void zTopKDestroy(zTopK *topk)
+{
+  zFree( topk->buf );
+  topk->k = topk->num = 0;
+}
+
+/* push a member to a top-k accumulator. */
+bool zTopKPush(zTopK *topk, void *memb)
+{
+  byte *p;
+  size_t i, parent;
+
+  if( topk->num < topk->k ){ /* sift up */
+    for( i=topk->num++; i>0; i=parent ){
+      parent = ( i - 1 ) / 2;
+      p = topk->buf + topk->size*parent;
+      if( topk->cmp( p, memb, topk->priv ) >= 0 ) break;
+      memcpy( topk->buf+topk->size*i, p, topk->size );
+    }
+    memcpy( topk->buf+topk->size*i, memb, topk->size );
+    return true;
+  }
+  if( topk->k == 0 || topk->cmp( memb, topk->buf, topk->priv ) >= 0 ) return false;
+  memcpy( topk->buf, memb, topk->size ); /* replace the worst */
+  _zSelectSiftDown( topk->buf, 0, topk->num, topk->size, topk->cmp, topk->priv );
+  return true;
+}
+
+/* sorted members kept in a top-k accumulator. */
+size_t zTopKSort(zTopK *topk, void *dest)
+{
+  memcpy( dest, topk->buf, topk->size*topk->num );
+  _zSelectHeapSort( (byte *)dest, topk->num, topk->size, topk->cmp, topk->priv );
+  return topk->num;
+}
+#endif /* __KERNEL__ */
@@ -4,7 +4,20 @@
  * zeda_binfile - binary data file manipulation
  */
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <zeda/zeda_binfile.h>
+#include <zeda/zeda_lz.h>
+#include <zeda/zeda_tscodec.h>
+#include <zeda/zeda_string.h>
+
+#ifdef __ZEDA_USE_PTHREAD
+#include <pthread.h>
+#endif /* __ZEDA_USE_PTHREAD */
+
+#ifndef __WINDOWS__
+#include <sys/mman.h>
+#endif /* __WINDOWS__ */
 
 /* endian-conversion-friendly I/O functions */
 
@@ -99,17 +112,55 @@ ZEDA_BINFILE_DEF_FWRITE_REV_TYPE( double, 64 )
 
 /* binary-file manipulator */
 
+/* raw I/O methods via the file stream. */
+static size_t _zBinFileStdioRead(zBinFile *bf, void *buf, size_t size, size_t n){
+  return fread( buf, size, n, bf->_fp );
+}
+
+static size_t _zBinFileStdioWrite(zBinFile *bf, const void *buf, size_t size, size_t n){
+  return fwrite( buf, size, n, bf->_fp );
+}
+
+#define ZBINFILE_DEF_RAW_FREAD( bit ) \
+static size_t _zBinFile_fread##bit(zBinFile *bf, int##bit##_t *val){\
+  return bf->_read( bf, val, sizeof(int##bit##_t), 1 );\
+}\
+static size_t _zBinFile_fread##bit##_rev(zBinFile *bf, int##bit##_t *val){\
+  int##bit##_t __tmp;\
+  size_t size;\
+  if( ( size = bf->_read( bf, &__tmp, sizeof(int##bit##_t), 1 ) ) > 0 )\
+    *val = endian_reverse##bit( __tmp );\
+  return size;\
+}
+
+#define ZBINFILE_DEF_RAW_FWRITE( bit ) \
+static size_t _zBinFile_fwrite##bit(zBinFile *bf, int##bit##_t *val){\
+  return bf->_write( bf, val, sizeof(int##bit##_t), 1 );\
+}\
+static size_t _zBinFile_fwrite##bit##_rev(zBinFile *bf, int##bit##_t *val){\
+  int##bit##_t __tmp;\
+  __tmp = endian_reverse##bit( *val );\
+  return bf->_write( bf, &__tmp, sizeof(int##bit##_t), 1 );\
+}
+
+ZBINFILE_DEF_RAW_FREAD(  16 )
+ZBINFILE_DEF_RAW_FWRITE( 16 )
+ZBINFILE_DEF_RAW_FREAD(  32 )
+ZBINFILE_DEF_RAW_FWRITE( 32 )
+ZBINFILE_DEF_RAW_FREAD(  64 )
+ZBINFILE_DEF_RAW_FWRITE( 64 )
+
 #define ZBINFILE_DEF_INT_FREAD( bit, type ) \
 static type _zBinFile_##type##_fread##bit(zBinFile *bf){\
   int##bit##_t val;\
-  return bf->_fread_int##bit( bf->_fp, &val ) > 0 ? val : 0;\
+  return bf->_fread_int##bit( bf, &val ) > 0 ? val : 0;\
 }
 
 #define ZBINFILE_DEF_INT_FWRITE( bit, type ) \
 static size_t _zBinFile_##type##_fwrite##bit(zBinFile *bf, type val){\
   int##bit##_t __tmp;\
   __tmp = val;\
-  return bf->_fwrite_int##bit( bf->_fp, &__tmp );\
+  return bf->_fwrite_int##bit( bf, &__tmp );\
 }
 
 ZBINFILE_DEF_INT_FREAD(  16, int )
@@ -126,26 +177,65 @@ ZBINFILE_DEF_INT_FWRITE( 32, long )
 ZBINFILE_DEF_INT_FREAD(  64, long )
 ZBINFILE_DEF_INT_FWRITE( 64, long )
 
-byte zBinFileByteFRead(zBinFile *bf){ return fread_byte( bf->_fp ); }
-size_t zBinFileByteFWrite(zBinFile *bf, byte val){ return fwrite_byte( bf->_fp, val ); }
+byte zBinFileByteFRead(zBinFile *bf){
+  byte val;
+  return bf->_read( bf, &val, sizeof(byte), 1 ) > 0 ? val : 0;
+}
+
+size_t zBinFileByteFWrite(zBinFile *bf, byte val){
+  return bf->_write( bf, &val, sizeof(byte), 1 );
+}
 
-static bool _zBinFileEndianIsSame(zBinFile *bf);;
+static bool _zBinFileEndianIsSame(zBinFile *bf);
 
 static size_t _zBinFileEndianCheckerFWrite(zBinFile *bf);
 
+/* whether the payload is written in blocks. */
+#define _zBinFileIsBlocked(bf) ( (bf)->flags & ( ZBINFILE_FLAG_LZ | ZBINFILE_FLAG_CRC ) )
+
+static bool _zBinFileBlockReaderCreate(zBinFile *bf);
+static bool _zBinFileBlockWriterCreate(zBinFile *bf);
+static bool _zBinFileBlockDestroy(zBinFile *bf);
+static bool _zBinFileRecordReaderCreate(zBinFile *bf);
+static bool _zBinFileRecordWriterCreate(zBinFile *bf);
+static bool _zBinFileRecordDestroy(zBinFile *bf);
+static bool _zBinFileAsyncDestroy(zBinFile *bf);
+static long _zBinFileAsyncTell(zBinFile *bf);
+
+void zBinFileInit(zBinFile *bf, FILE *fp)
+{
+  bf->_fp = fp;
+  bf->_dataofs = 0;
+  bf->_blk = NULL;
+  bf->_rec = NULL;
+  bf->_async = NULL;
+  bf->_read = _zBinFileStdioRead;
+  bf->_write = _zBinFileStdioWrite;
+}
+
 bool zBinFileOpen(zBinFile *bf, char filename[], const char *mode)
 {
-  if( !( bf->_fp = fopen( filename, mode ) ) ){
+  FILE *fp;
+
+  if( !( fp = fopen( filename, mode ) ) ){
     ZOPENERROR( filename );
+    bf->_fp = NULL;
     return false;
   }
+  zBinFileInit( bf, fp );
   return true;
 }
 
 int zBinFileClose(zBinFile *bf)
 {
-  if( bf->_fp ) return fclose( bf->_fp );
-  return EOF;
+  bool ret;
+
+  if( !bf->_fp ) return EOF;
+  ret = _zBinFileAsyncDestroy( bf );
+  if( !_zBinFileBlockDestroy( bf ) ) ret = false;
+  if( !_zBinFileRecordDestroy( bf ) ) ret = false;
+  if( fclose( bf->_fp ) != 0 || !ret ) return EOF;
+  return 0;
 }
 
 bool _zBinFileEndianIsSame(zBinFile *bf)
@@ -157,7 +247,6 @@ bool zBinFileHeaderFRead(zBinFile *bf)
 {
   char id[BUFSIZ];
   int id_len;
-  int16_t version;
   union{
     uint8_t byte[4];
     uint32_t val;
@@ -190,27 +279,42 @@ bool zBinFileHeaderFRead(zBinFile *bf)
     return false;
   }
   if( _zBinFileEndianIsSame( bf ) ){
-    bf->_fread_int16 = fread_int16;
-    bf->_fread_int32 = fread_int32;
-    bf->_fread_int64 = fread_int64;
+    bf->_fread_int16 = _zBinFile_fread16;
+    bf->_fread_int32 = _zBinFile_fread32;
+    bf->_fread_int64 = _zBinFile_fread64;
   } else{
-    bf->_fread_int16 = fread_int16_rev;
-    bf->_fread_int32 = fread_int32_rev;
-    bf->_fread_int64 = fread_int64_rev;
+    bf->_fread_int16 = _zBinFile_fread16_rev;
+    bf->_fread_int32 = _zBinFile_fread32_rev;
+    bf->_fread_int64 = _zBinFile_fread64_rev;
   }
   /* read version and byte sizes of some types */
-  if( bf->_fread_int16( bf->_fp, &version ) < 1 ){
+  if( bf->_fread_int16( bf, &bf->version ) < 1 ){
     ZRUNERROR( ZEDA_ERR_VERSION_NOT_FOUND );
     return false;
   }
-  if( bf->_fread_int16( bf->_fp, &bf->_size_int ) < 1 ){
+  if( bf->_fread_int16( bf, &bf->_size_int ) < 1 ){
     ZRUNERROR( ZEDA_ERR_INTSIZ_NOT_FOUND );
     return false;
   }
-  if( bf->_fread_int16( bf->_fp, &bf->_size_long ) < 1 ){
+  if( bf->_fread_int16( bf, &bf->_size_long ) < 1 ){
     ZRUNERROR( ZEDA_ERR_LNGSIZ_NOT_FOUND );
     return false;
   }
+  /* read flags */
+  bf->flags = 0;
+  if( bf->version >= 2 && bf->_fread_int16( bf, &bf->flags ) < 1 ){
+    ZRUNERROR( ZEDA_ERR_ZBD_FLAG_NOT_FOUND );
+    return false;
+  }
+  if( bf->flags & ~( ZBINFILE_FLAG_LZ | ZBINFILE_FLAG_RECORD | ZBINFILE_FLAG_CRC ) ){
+    ZRUNERROR( ZEDA_ERR_ZBD_UNKNOWN_FLAG, bf->flags );
+    return false;
+  }
+  if( _zBinFileIsBlocked( bf ) &&
+      ( bf->_fread_int32( bf, &bf->_blocksize ) < 1 || bf->_blocksize <= 0 ) ){
+    ZRUNERROR( ZEDA_ERR_ZBD_INVALID_BLOCK );
+    return false;
+  }
   /* assign readers of int and long */
   switch( bf->_size_int ){
   case 2: bf->_fread_int = _zBinFile_int_fread16; break;
@@ -230,15 +334,21 @@ bool zBinFileHeaderFRead(zBinFile *bf)
   if( bf->_size_long > (int16_t)sizeof(long) ){
     ZRUNWARN( ZEDA_WARN_LNG_SHRTSIZ, bf->_size_long, sizeof(long) );
   }
+  bf->_dataofs = ftell( bf->_fp );
+  if( ( bf->flags & ZBINFILE_FLAG_RECORD ) && !_zBinFileRecordReaderCreate( bf ) ) return false;
+  if( _zBinFileIsBlocked( bf ) && !_zBinFileBlockReaderCreate( bf ) ) return false;
   return ret;
 }
 
 void zBinFileInfoSet(zBinFile *bf, int16_t version, int16_t endian_type, int16_t size_int, int16_t size_long)
 {
   bf->version = version;
+  bf->flags = 0;
   bf->_endian_type = endian_type;
   bf->_size_int = size_int;
   bf->_size_long = size_long;
+  bf->_blocksize = ZBINFILE_DEFAULT_BLOCKSIZE;
+  bf->_schema = NULL;
 }
 
 void zBinFileInfoSetThis(zBinFile *bf)
@@ -246,6 +356,19 @@ void zBinFileInfoSetThis(zBinFile *bf)
   zBinFileInfoSet( bf, ZBINFILE_CURRENT_VERSION, endian_check(), sizeof(int), sizeof(long) );
 }
 
+void zBinFileSetCompress(zBinFile *bf, int32_t blocksize)
+{
+  if( bf->version < 2 ) bf->version = 2; /* flags are available since version 2 */
+  bf->flags |= ZBINFILE_FLAG_LZ;
+  bf->_blocksize = blocksize > 0 ? blocksize : ZBINFILE_DEFAULT_BLOCKSIZE;
+}
+
+void zBinFileSetChecksum(zBinFile *bf)
+{
+  if( bf->version < 2 ) bf->version = 2;
+  bf->flags |= ZBINFILE_FLAG_CRC;
+}
+
 size_t _zBinFileEndianCheckerFWrite(zBinFile *bf)
 {
   size_t size = 0;
@@ -279,17 +402,21 @@ size_t zBinFileHeaderFWrite(zBinFile *bf)
   header_size += fwrite( ZBINFILE_ID, sizeof(char), strlen(ZBINFILE_ID), bf->_fp );
   header_size += _zBinFileEndianCheckerFWrite( bf );
   if( _zBinFileEndianIsSame( bf ) ){
-    bf->_fwrite_int16 = fwrite_int16;
-    bf->_fwrite_int32 = fwrite_int32;
-    bf->_fwrite_int64 = fwrite_int64;
+    bf->_fwrite_int16 = _zBinFile_fwrite16;
+    bf->_fwrite_int32 = _zBinFile_fwrite32;
+    bf->_fwrite_int64 = _zBinFile_fwrite64;
   } else{
-    bf->_fwrite_int16 = fwrite_int16_rev;
-    bf->_fwrite_int32 = fwrite_int32_rev;
-    bf->_fwrite_int64 = fwrite_int64_rev;
+    bf->_fwrite_int16 = _zBinFile_fwrite16_rev;
+    bf->_fwrite_int32 = _zBinFile_fwrite32_rev;
+    bf->_fwrite_int64 = _zBinFile_fwrite64_rev;
   }
-  header_size += bf->_fwrite_int16( bf->_fp, &bf->version );
-  header_size += bf->_fwrite_int16( bf->_fp, &bf->_size_int );
-  header_size += bf->_fwrite_int16( bf->_fp, &bf->_size_long );
+  header_size += bf->_fwrite_int16( bf, &bf->version );
+  header_size += bf->_fwrite_int16( bf, &bf->_size_int );
+  header_size += bf->_fwrite_int16( bf, &bf->_size_long );
+  if( bf->version >= 2 )
+    header_size += bf->_fwrite_int16( bf, &bf->flags );
+  if( _zBinFileIsBlocked( bf ) )
+    header_size += bf->_fwrite_int32( bf, &bf->_blocksize );
   /* ssign writers of int and long */
   switch( bf->_size_int ){
   case 2: bf->_fwrite_int = _zBinFile_int_fwrite16; break;
@@ -309,6 +436,9 @@ size_t zBinFileHeaderFWrite(zBinFile *bf)
   if( bf->_size_long < (int16_t)sizeof(long) ){
     ZRUNWARN( ZEDA_WARN_LNG_SHRTSIZ, bf->_size_long, sizeof(long) );
   }
+  bf->_dataofs = ftell( bf->_fp );
+  if( ( bf->flags & ZBINFILE_FLAG_RECORD ) && !_zBinFileRecordWriterCreate( bf ) ) ret = false;
+  if( _zBinFileIsBlocked( bf ) && !_zBinFileBlockWriterCreate( bf ) ) ret = false;
   return ret ? header_size : 0;
 }
 
@@ -316,18 +446,1840 @@ size_t zBinFileHeaderFWrite(zBinFile *bf)
 
 float zBinFileFloatFRead(zBinFile *bf){
   float val;
-  return bf->_fread_int32( bf->_fp, (int32_t *)&val ) > 0 ? val : 0;
+  return bf->_fread_int32( bf, (int32_t *)&val ) > 0 ? val : 0;
 }
 
 size_t zBinFileFloatFWrite(zBinFile *bf, float val){
-  return bf->_fwrite_int32( bf->_fp, (int32_t *)&val );
+  return bf->_fwrite_int32( bf, (int32_t *)&val );
 }
 
 double zBinFileDoubleFRead(zBinFile *bf){
   double val;
-  return bf->_fread_int64( bf->_fp, (int64_t *)&val ) > 0 ? val : 0;
+  return bf->_fread_int64( bf, (int64_t *)&val ) > 0 ? val : 0;
 }
 
 size_t zBinFileDoubleFWrite(zBinFile *bf, double val){
-  return bf->_fwrite_int64( bf->_fp, (int64_t *)&val );
+  return bf->_fwrite_int64( bf, (int64_t *)&val );
+}
+
+/* bulk readers / writers */
+
+/* number of values converted at once. */
+#define ZBINFILE_CHUNK_NUM 4096
+
+/* reverse byte orders of an array of values of a given size. */
+static void _zBinFileEndianReverseArray(void *buf, size_t size, size_t n)
+{
+  switch( size ){
+  case 2: endian_reverse16_array( buf, n ); break;
+  case 4: endian_reverse32_array( buf, n ); break;
+  case 8: endian_reverse64_array( buf, n ); break;
+  default: ;
+  }
+}
+
+/* read an array of fixed-size values. */
+static size_t _zBinFileNFRead(zBinFile *bf, void *val, size_t size, size_t n)
+{
+  size_t ret;
+
+  ret = bf->_read( bf, val, size, n );
+  if( !_zBinFileEndianIsSame( bf ) )
+    _zBinFileEndianReverseArray( val, size, ret );
+  return ret;
+}
+
+/* write an array of fixed-size values. */
+static size_t _zBinFileNFWrite(zBinFile *bf, void *val, size_t size, size_t n)
+{
+  union{
+    int16_t i16[ZBINFILE_CHUNK_NUM];
+    int32_t i32[ZBINFILE_CHUNK_NUM];
+    int64_t i64[ZBINFILE_CHUNK_NUM];
+  } buf;
+  size_t m, ret = 0;
+
+  if( _zBinFileEndianIsSame( bf ) )
+    return bf->_write( bf, val, size, n );
+  for( ; n>0; n-=m, val=(byte *)val+size*m ){
+    m = _zMin( n, ZBINFILE_CHUNK_NUM );
+    memcpy( &buf, val, size*m );
+    _zBinFileEndianReverseArray( &buf, size, m );
+    ret += bf->_write( bf, &buf, size, m );
+  }
+  return ret;
+}
+
+/* read an array of integer values with conversion of sizes. */
+#define ZBINFILE_DEF_INT_NFREAD( type ) \
+static size_t _zBinFile_##type##_nfread(zBinFile *bf, type val[], size_t n){\
+  union{\
+    int16_t i16[ZBINFILE_CHUNK_NUM];\
+    int32_t i32[ZBINFILE_CHUNK_NUM];\
+    int64_t i64[ZBINFILE_CHUNK_NUM];\
+  } buf;\
+  size_t i, m, r, ret = 0;\
+  if( bf->_size_##type == sizeof(type) )\
+    return _zBinFileNFRead( bf, val, sizeof(type), n );\
+  for( ; n>0; n-=m, val+=m ){\
+    m = _zMin( n, ZBINFILE_CHUNK_NUM );\
+    r = _zBinFileNFRead( bf, &buf, bf->_size_##type, m );\
+    switch( bf->_size_##type ){\
+    case 2: for( i=0; i<r; i++ ) val[i] = buf.i16[i]; break;\
+    case 4: for( i=0; i<r; i++ ) val[i] = buf.i32[i]; break;\
+    case 8: for( i=0; i<r; i++ ) val[i] = buf.i64[i]; break;\
+    default: return 0;\
+    }\
+    ret += r;\
+    if( r < m ) break;\
+  }\
+  return ret;\
+}
+
+/* write an array of integer values with conversion of sizes. */
+#define ZBINFILE_DEF_INT_NFWRITE( type ) \
+static size_t _zBinFile_##type##_nfwrite(zBinFile *bf, type val[], size_t n){\
+  union{\
+    int16_t i16[ZBINFILE_CHUNK_NUM];\
+    int32_t i32[ZBINFILE_CHUNK_NUM];\
+    int64_t i64[ZBINFILE_CHUNK_NUM];\
+  } buf;\
+  size_t i, m, ret = 0;\
+  if( bf->_size_##type == sizeof(type) )\
+    return _zBinFileNFWrite( bf, val, sizeof(type), n );\
+  for( ; n>0; n-=m, val+=m ){\
+    m = _zMin( n, ZBINFILE_CHUNK_NUM );\
+    switch( bf->_size_##type ){\
+    case 2: for( i=0; i<m; i++ ) buf.i16[i] = val[i]; break;\
+    case 4: for( i=0; i<m; i++ ) buf.i32[i] = val[i]; break;\
+    case 8: for( i=0; i<m; i++ ) buf.i64[i] = val[i]; break;\
+    default: return 0;\
+    }\
+    ret += _zBinFileNFWrite( bf, &buf, bf->_size_##type, m );\
+  }\
+  return ret;\
+}
+
+ZBINFILE_DEF_INT_NFREAD(  int )
+ZBINFILE_DEF_INT_NFWRITE( int )
+ZBINFILE_DEF_INT_NFREAD(  long )
+ZBINFILE_DEF_INT_NFWRITE( long )
+
+size_t zBinFileIntNFRead(zBinFile *bf, int val[], size_t n){
+  return _zBinFile_int_nfread( bf, val, n );
+}
+
+size_t zBinFileIntNFWrite(zBinFile *bf, int val[], size_t n){
+  return _zBinFile_int_nfwrite( bf, val, n );
+}
+
+size_t zBinFileLongNFRead(zBinFile *bf, long val[], size_t n){
+  return _zBinFile_long_nfread( bf, val, n );
+}
+
+size_t zBinFileLongNFWrite(zBinFile *bf, long val[], size_t n){
+  return _zBinFile_long_nfwrite( bf, val, n );
+}
+
+size_t zBinFileFloatNFRead(zBinFile *bf, float val[], size_t n){
+  return _zBinFileNFRead( bf, val, sizeof(float), n );
+}
+
+size_t zBinFileFloatNFWrite(zBinFile *bf, float val[], size_t n){
+  return _zBinFileNFWrite( bf, val, sizeof(float), n );
+}
+
+size_t zBinFileDoubleNFRead(zBinFile *bf, double val[], size_t n){
+  return _zBinFileNFRead( bf, val, sizeof(double), n );
+}
+
+size_t zBinFileDoubleNFWrite(zBinFile *bf, double val[], size_t n){
+  return _zBinFileNFWrite( bf, val, sizeof(double), n );
+}
+
+/* struct layouts */
+
+/* size of a value in a binary file. */
+static size_t _zBinFileTypeSize(zBinFile *bf, int type)
+{
+  switch( type ){
+  case ZBINFILE_TYPE_BYTE:   return 1;
+  case ZBINFILE_TYPE_INT:    return bf->_size_int;
+  case ZBINFILE_TYPE_LONG:   return bf->_size_long;
+  case ZBINFILE_TYPE_FLOAT:  return sizeof(float);
+  case ZBINFILE_TYPE_DOUBLE: return sizeof(double);
+  default: ;
+  }
+  return 0;
+}
+
+/* size of a value in the host. */
+static size_t _zBinFileTypeHostSize(int type)
+{
+  switch( type ){
+  case ZBINFILE_TYPE_BYTE:   return 1;
+  case ZBINFILE_TYPE_INT:    return sizeof(int);
+  case ZBINFILE_TYPE_LONG:   return sizeof(long);
+  case ZBINFILE_TYPE_FLOAT:  return sizeof(float);
+  case ZBINFILE_TYPE_DOUBLE: return sizeof(double);
+  default: ;
+  }
+  return 0;
+}
+
+/* size of a packed row of a struct in a binary file. */
+static size_t _zBinFileLayoutRowSize(zBinFile *bf, const zBinFileLayout *layout)
+{
+  size_t size = 0, s;
+  int i;
+
+  for( i=0; i<layout->nfield; i++ ){
+    if( ( s = _zBinFileTypeSize( bf, layout->field[i].type ) ) == 0 ){
+      ZRUNERROR( ZEDA_ERR_ZBD_INVALID_LAYOUT );
+      return 0;
+    }
+    size += s * layout->field[i].count;
+  }
+  return size;
+}
+
+/* check if a struct is identical with its packed row in a binary file. */
+static bool _zBinFileLayoutIsIdentical(zBinFile *bf, const zBinFileLayout *layout)
+{
+  size_t ofs = 0;
+  int i;
+
+  if( !_zBinFileEndianIsSame( bf ) ) return false;
+  for( i=0; i<layout->nfield; i++ ){
+    if( layout->field[i].offset != ofs ||
+        _zBinFileTypeSize( bf, layout->field[i].type ) != _zBinFileTypeHostSize( layout->field[i].type ) )
+      return false;
+    ofs += _zBinFileTypeHostSize( layout->field[i].type ) * layout->field[i].count;
+  }
+  return ofs == layout->size;
+}
+
+/* pack integers of a field with conversion of sizes. */
+#define ZBINFILE_DEF_INT_PACK( type ) \
+static void _zBinFile_##type##_pack(ubyte *dst, const type *src, int n, size_t size){\
+  int16_t i16; int32_t i32; int64_t i64;\
+  for( ; n>0; n--, src++, dst+=size ){\
+    switch( size ){\
+    case 2: i16 = *src; memcpy( dst, &i16, size ); break;\
+    case 4: i32 = *src; memcpy( dst, &i32, size ); break;\
+    case 8: i64 = *src; memcpy( dst, &i64, size ); break;\
+    default: ;\
+    }\
+  }\
+}
+
+/* unpack integers of a field with conversion of sizes. */
+#define ZBINFILE_DEF_INT_UNPACK( type ) \
+static void _zBinFile_##type##_unpack(type *dst, const ubyte *src, int n, size_t size){\
+  int16_t i16; int32_t i32; int64_t i64;\
+  for( ; n>0; n--, dst++, src+=size ){\
+    switch( size ){\
+    case 2: memcpy( &i16, src, size ); *dst = i16; break;\
+    case 4: memcpy( &i32, src, size ); *dst = i32; break;\
+    case 8: memcpy( &i64, src, size ); *dst = i64; break;\
+    default: ;\
+    }\
+  }\
+}
+
+ZBINFILE_DEF_INT_PACK(   int )
+ZBINFILE_DEF_INT_UNPACK( int )
+ZBINFILE_DEF_INT_PACK(   long )
+ZBINFILE_DEF_INT_UNPACK( long )
+
+/* pack a struct into a row of a binary file. */
+static void _zBinFileLayoutPack(zBinFile *bf, const zBinFileLayout *layout, const ubyte *src, ubyte *dst)
+{
+  const zBinFileLayoutField *f;
+  size_t size;
+  int i;
+
+  for( f=layout->field, i=0; i<layout->nfield; i++, f++ ){
+    size = _zBinFileTypeSize( bf, f->type );
+    if( size == _zBinFileTypeHostSize( f->type ) )
+      memcpy( dst, src + f->offset, size * f->count );
+    else if( f->type == ZBINFILE_TYPE_INT )
+      _zBinFile_int_pack( dst, (const int *)( src + f->offset ), f->count, size );
+    else
+      _zBinFile_long_pack( dst, (const long *)( src + f->offset ), f->count, size );
+    if( !_zBinFileEndianIsSame( bf ) ) _zBinFileEndianReverseArray( dst, size, f->count );
+    dst += size * f->count;
+  }
+}
+
+/* unpack a row of a binary file into a struct. */
+static void _zBinFileLayoutUnpack(zBinFile *bf, const zBinFileLayout *layout, ubyte *src, ubyte *dst)
+{
+  const zBinFileLayoutField *f;
+  size_t size;
+  int i;
+
+  for( f=layout->field, i=0; i<layout->nfield; i++, f++ ){
+    size = _zBinFileTypeSize( bf, f->type );
+    if( !_zBinFileEndianIsSame( bf ) ) _zBinFileEndianReverseArray( src, size, f->count );
+    if( size == _zBinFileTypeHostSize( f->type ) )
+      memcpy( dst + f->offset, src, size * f->count );
+    else if( f->type == ZBINFILE_TYPE_INT )
+      _zBinFile_int_unpack( (int *)( dst + f->offset ), src, f->count, size );
+    else
+      _zBinFile_long_unpack( (long *)( dst + f->offset ), src, f->count, size );
+    src += size * f->count;
+  }
+}
+
+/* write an array of structs. */
+size_t zBinFileStructNFWrite(zBinFile *bf, const zBinFileLayout *layout, const void *array, size_t n)
+{
+  ubyte *buf;
+  const ubyte *p;
+  size_t rowsize, m, i, w, ret = 0;
+
+  if( _zBinFileLayoutIsIdentical( bf, layout ) )
+    return bf->_write( bf, array, layout->size, n );
+  if( ( rowsize = _zBinFileLayoutRowSize( bf, layout ) ) == 0 ) return 0;
+  m = _zMax( ZBINFILE_CHUNK_NUM * sizeof(double) / rowsize, 1 );
+  if( !( buf = zAlloc( ubyte, rowsize * m ) ) ){
+    ZALLOCERROR();
+    return 0;
+  }
+  for( p=(const ubyte *)array; n>0; n-=m ){
+    if( m > n ) m = n;
+    for( i=0; i<m; i++, p+=layout->size )
+      _zBinFileLayoutPack( bf, layout, p, buf + rowsize*i );
+    ret += ( w = bf->_write( bf, buf, rowsize, m ) );
+    if( w < m ) break;
+  }
+  free( buf );
+  return ret;
+}
+
+/* read an array of structs. */
+size_t zBinFileStructNFRead(zBinFile *bf, const zBinFileLayout *layout, void *array, size_t n)
+{
+  ubyte *buf, *p;
+  size_t rowsize, m, i, r, ret = 0;
+
+  if( _zBinFileLayoutIsIdentical( bf, layout ) )
+    return bf->_read( bf, array, layout->size, n );
+  if( ( rowsize = _zBinFileLayoutRowSize( bf, layout ) ) == 0 ) return 0;
+  m = _zMax( ZBINFILE_CHUNK_NUM * sizeof(double) / rowsize, 1 );
+  if( !( buf = zAlloc( ubyte, rowsize * m ) ) ){
+    ZALLOCERROR();
+    return 0;
+  }
+  for( p=(ubyte *)array; n>0; n-=m ){
+    if( m > n ) m = n;
+    r = bf->_read( bf, buf, rowsize, m );
+    for( i=0; i<r; i++, p+=layout->size )
+      _zBinFileLayoutUnpack( bf, layout, buf + rowsize*i, p );
+    ret += r;
+    if( r < m ) break;
+  }
+  free( buf );
+  return ret;
+}
+
+/* record index */
+
+#define ZBINFILE_RECORD_ID "ZBDR"
+
+/* size of the trailer of the footer: offset of the footer and ID. */
+#define ZBINFILE_RECORD_TRAILER_SIZE ( sizeof(int64_t) + 4 )
+
+typedef struct{
+  int64_t *ofs;          /* offsets of records */
+  double *key;           /* keys of records */
+  int64_t nrec;          /* number of records */
+  int64_t capacity;      /* size of arrays */
+  long footerofs;        /* offset of the footer */
+  zBinFileSchema schema; /* schema read from the footer */
+  bool writer;           /* whether the index is to be written */
+  long cur;              /* current offset of an uncompressed file */
+} _zBinFileRecord;
+
+/* the end of the payload and the block index. */
+static long _zBinFileEnd(zBinFile *bf)
+{
+  if( bf->_rec ) return ((_zBinFileRecord *)bf->_rec)->footerofs;
+  return zFileSize( bf->_fp );
+}
+
+/* block layer of compressed payload */
+
+#define ZBINFILE_INDEX_ID "ZBDX"
+
+/* size of the header of a block: sizes before and after compression,
+ * followed by CRC-32C of the stored data if checksummed. */
+#define ZBINFILE_BLOCK_HEADER_MAXSIZE ( sizeof(int32_t) * 3 )
+#define _zBinFileBlockHeaderSize(bf) \
+  ( sizeof(int32_t) * ( zBinFileIsChecksummed(bf) ? 3 : 2 ) )
+/* size of the trailer of the block index: number of blocks, offset and ID. */
+#define ZBINFILE_INDEX_TRAILER_SIZE ( sizeof(int64_t) * 2 + 4 )
+
+typedef struct{
+  ubyte *raw;      /* block before compression */
+  size_t len;      /* size of data in the block */
+  size_t cur;      /* current position in the block */
+  ubyte *comp;     /* compressed block */
+  size_t compsize; /* size of the buffer for the compressed block */
+  int64_t *ofs;    /* file offsets of blocks */
+  int64_t nblock;  /* number of blocks */
+  int64_t capacity;/* size of the array of offsets */
+  int64_t next;    /* identifier of the next block to be read */
+  int64_t indexofs;/* file offset of the block index */
+  bool indexed;    /* whether the block index is available */
+} _zBinFileBlock;
+
+/* integers in the byte order of a binary file. */
+static void _zBinFileIntToFile(zBinFile *bf, void *val, size_t size){
+  if( !_zBinFileEndianIsSame( bf ) ) _zBinFileEndianReverseArray( val, size, 1 );
+}
+
+static size_t _zBinFileRawInt32FWrite(zBinFile *bf, int32_t val){
+  _zBinFileIntToFile( bf, &val, sizeof(int32_t) );
+  return fwrite( &val, sizeof(int32_t), 1, bf->_fp );
+}
+
+static size_t _zBinFileRawInt64FWrite(zBinFile *bf, int64_t val){
+  _zBinFileIntToFile( bf, &val, sizeof(int64_t) );
+  return fwrite( &val, sizeof(int64_t), 1, bf->_fp );
+}
+
+static int32_t _zBinFileRawInt32(zBinFile *bf, const ubyte *p){
+  int32_t val;
+  memcpy( &val, p, sizeof(int32_t) );
+  _zBinFileIntToFile( bf, &val, sizeof(int32_t) );
+  return val;
+}
+
+static int64_t _zBinFileRawInt64(zBinFile *bf, const ubyte *p){
+  int64_t val;
+  memcpy( &val, p, sizeof(int64_t) );
+  _zBinFileIntToFile( bf, &val, sizeof(int64_t) );
+  return val;
+}
+
+/* allocate a block layer. */
+static _zBinFileBlock *_zBinFileBlockAlloc(zBinFile *bf)
+{
+  _zBinFileBlock *blk;
+
+  if( !( blk = zAlloc( _zBinFileBlock, 1 ) ) ){
+    ZALLOCERROR();
+    return NULL;
+  }
+  blk->compsize = zLZCompressBound( (size_t)bf->_blocksize );
+  blk->raw = zAlloc( ubyte, bf->_blocksize );
+  blk->comp = zAlloc( ubyte, blk->compsize );
+  if( !blk->raw || !blk->comp ){
+    ZALLOCERROR();
+    free( blk->raw );
+    free( blk->comp );
+    free( blk );
+    return NULL;
+  }
+  blk->len = blk->cur = 0;
+  blk->ofs = NULL;
+  blk->nblock = blk->capacity = blk->next = 0;
+  blk->indexofs = -1;
+  blk->indexed = false;
+  return ( bf->_blk = blk );
+}
+
+/* add a block offset to the block index. */
+static bool _zBinFileBlockAddOffset(_zBinFileBlock *blk, int64_t ofs)
+{
+  int64_t *p;
+
+  if( blk->nblock == blk->capacity ){
+    if( !( p = zRealloc( blk->ofs, int64_t, blk->capacity > 0 ? blk->capacity*2 : 16 ) ) ){
+      ZALLOCERROR();
+      return false;
+    }
+    blk->ofs = p;
+    blk->capacity = blk->capacity > 0 ? blk->capacity*2 : 16;
+  }
+  blk->ofs[blk->nblock++] = ofs;
+  return true;
+}
+
+/* compress and write the current block. */
+static bool _zBinFileBlockFlush(zBinFile *bf)
+{
+  _zBinFileBlock *blk;
+  size_t compsize;
+  long ofs;
+
+  if( ( blk = (_zBinFileBlock *)bf->_blk )->len == 0 ) return true;
+  if( ( ofs = ftell( bf->_fp ) ) < 0 || !_zBinFileBlockAddOffset( blk, ofs ) ) return false;
+  if( !zBinFileIsCompressed( bf ) ||
+      ( compsize = zLZCompress( blk->raw, blk->len, blk->comp, blk->compsize ) ) == 0 ||
+      compsize >= blk->len ){ /* stored without compression */
+    compsize = blk->len;
+    memcpy( blk->comp, blk->raw, blk->len );
+  }
+  if( _zBinFileRawInt32FWrite( bf, blk->len ) < 1 ||
+      _zBinFileRawInt32FWrite( bf, compsize ) < 1 ||
+      ( zBinFileIsChecksummed( bf ) &&
+        _zBinFileRawInt32FWrite( bf, (int32_t)crc32c( 0, blk->comp, compsize ) ) < 1 ) ||
+      fwrite( blk->comp, 1, compsize, bf->_fp ) < compsize ) return false;
+  blk->len = 0;
+  return true;
+}
+
+/* write data to blocks. */
+static size_t _zBinFileBlockWrite(zBinFile *bf, const void *buf, size_t size, size_t n)
+{
+  _zBinFileBlock *blk;
+  const ubyte *p;
+  size_t rest, m;
+
+  blk = (_zBinFileBlock *)bf->_blk;
+  for( p=(const ubyte *)buf, rest=size*n; rest>0; p+=m, rest-=m ){
+    m = _zMin( rest, bf->_blocksize - blk->len );
+    memcpy( blk->raw + blk->len, p, m );
+    if( ( blk->len += m ) == (size_t)bf->_blocksize && !_zBinFileBlockFlush( bf ) )
+      return ( size*n - rest ) / size;
+  }
+  return n;
+}
+
+/* write the block index. */
+static bool _zBinFileBlockIndexFWrite(zBinFile *bf)
+{
+  _zBinFileBlock *blk;
+  long indexofs;
+  int64_t i;
+
+  blk = (_zBinFileBlock *)bf->_blk;
+  if( ( indexofs = ftell( bf->_fp ) ) < 0 ) return false;
+  for( i=0; i<blk->nblock; i++ )
+    if( _zBinFileRawInt64FWrite( bf, blk->ofs[i] ) < 1 ) return false;
+  return _zBinFileRawInt64FWrite( bf, blk->nblock ) == 1 &&
+         _zBinFileRawInt64FWrite( bf, indexofs ) == 1 &&
+         fwrite( ZBINFILE_INDEX_ID, 1, 4, bf->_fp ) == 4;
+}
+
+/* create a block writer. */
+bool _zBinFileBlockWriterCreate(zBinFile *bf)
+{
+  if( !_zBinFileBlockAlloc( bf ) ) return false;
+  bf->_write = _zBinFileBlockWrite;
+  return true;
+}
+
+/* check the header of a block. */
+static bool _zBinFileBlockHeader(zBinFile *bf, const ubyte *p, int32_t *rawsize, int32_t *compsize, uint32_t *crc)
+{
+  *rawsize = _zBinFileRawInt32( bf, p );
+  *compsize = _zBinFileRawInt32( bf, p + sizeof(int32_t) );
+  *crc = zBinFileIsChecksummed( bf ) ? (uint32_t)_zBinFileRawInt32( bf, p + sizeof(int32_t)*2 ) : 0;
+  if( *rawsize <= 0 || *rawsize > bf->_blocksize || *compsize <= 0 || *compsize > *rawsize ){
+    ZRUNERROR( ZEDA_ERR_ZBD_INVALID_BLOCK );
+    return false;
+  }
+  return true;
+}
+
+/* verify the checksum of a block. */
+static bool _zBinFileBlockVerify(zBinFile *bf, const ubyte *comp, int32_t compsize, uint32_t crc)
+{
+  return !zBinFileIsChecksummed( bf ) || crc32c( 0, comp, compsize ) == crc;
+}
+
+/* decompress a block. */
+static bool _zBinFileBlockInflate(const ubyte *comp, int32_t compsize, ubyte *raw, int32_t rawsize)
+{
+  if( compsize == rawsize ){ /* stored without compression */
+    memcpy( raw, comp, rawsize );
+    return true;
+  }
+  if( zLZDecompress( comp, compsize, raw, rawsize ) != (size_t)rawsize ){
+    ZRUNERROR( ZEDA_ERR_ZBD_INVALID_BLOCK );
+    return false;
+  }
+  return true;
+}
+
+/* read and decompress the next block. */
+static bool _zBinFileBlockLoad(zBinFile *bf)
+{
+  _zBinFileBlock *blk;
+  ubyte header[ZBINFILE_BLOCK_HEADER_MAXSIZE];
+  int32_t rawsize, compsize;
+  uint32_t crc;
+
+  blk = (_zBinFileBlock *)bf->_blk;
+  blk->len = blk->cur = 0;
+  if( blk->indexed && blk->next >= blk->nblock ) return false;
+  if( fread( header, 1, _zBinFileBlockHeaderSize(bf), bf->_fp ) < _zBinFileBlockHeaderSize(bf) ||
+      !_zBinFileBlockHeader( bf, header, &rawsize, &compsize, &crc ) ||
+      fread( blk->comp, 1, compsize, bf->_fp ) < (size_t)compsize ) return false;
+  if( !_zBinFileBlockVerify( bf, blk->comp, compsize, crc ) ){
+    ZRUNERROR( ZEDA_ERR_ZBD_CHECKSUM_MISMATCH, (long)blk->next );
+    return false;
+  }
+  if( !_zBinFileBlockInflate( blk->comp, compsize, blk->raw, rawsize ) ) return false;
+  blk->len = rawsize;
+  blk->next++;
+  return true;
+}
+
+/* read data from blocks. */
+static size_t _zBinFileBlockRead(zBinFile *bf, void *buf, size_t size, size_t n)
+{
+  _zBinFileBlock *blk;
+  ubyte *p;
+  size_t rest, m;
+
+  blk = (_zBinFileBlock *)bf->_blk;
+  for( p=(ubyte *)buf, rest=size*n; rest>0; p+=m, rest-=m ){
+    if( blk->cur == blk->len && !_zBinFileBlockLoad( bf ) ) break;
+    m = _zMin( rest, blk->len - blk->cur );
+    memcpy( p, blk->raw + blk->cur, m );
+    blk->cur += m;
+  }
+  return ( size*n - rest ) / size;
+}
+
+/* read the block index. */
+static bool _zBinFileBlockIndexFRead(zBinFile *bf)
+{
+  _zBinFileBlock *blk;
+  ubyte trailer[ZBINFILE_INDEX_TRAILER_SIZE], *p = NULL;
+  int64_t nblock, indexofs, i;
+  long size;
+  bool ret = false;
+
+  blk = (_zBinFileBlock *)bf->_blk;
+  if( ( size = _zBinFileEnd( bf ) ) < bf->_dataofs + (long)ZBINFILE_INDEX_TRAILER_SIZE ||
+      fseek( bf->_fp, size - ZBINFILE_INDEX_TRAILER_SIZE, SEEK_SET ) != 0 ||
+      fread( trailer, 1, ZBINFILE_INDEX_TRAILER_SIZE, bf->_fp ) < ZBINFILE_INDEX_TRAILER_SIZE ||
+      strncmp( (char *)trailer + sizeof(int64_t)*2, ZBINFILE_INDEX_ID, 4 ) != 0 ) goto TERMINATE;
+  nblock = _zBinFileRawInt64( bf, trailer );
+  indexofs = _zBinFileRawInt64( bf, trailer + sizeof(int64_t) );
+  if( nblock < 0 || indexofs < bf->_dataofs ||
+      indexofs + (int64_t)sizeof(int64_t)*nblock + (int64_t)ZBINFILE_INDEX_TRAILER_SIZE != size ) goto TERMINATE;
+  if( nblock > 0 &&
+      ( !( blk->ofs = zAlloc( int64_t, nblock ) ) || !( p = zAlloc( ubyte, sizeof(int64_t)*nblock ) ) ) ){
+    ZALLOCERROR();
+    goto TERMINATE;
+  }
+  if( fseek( bf->_fp, indexofs, SEEK_SET ) != 0 ||
+      fread( p, sizeof(int64_t), nblock, bf->_fp ) < (size_t)nblock ) goto TERMINATE;
+  for( i=0; i<nblock; i++ )
+    if( ( blk->ofs[i] = _zBinFileRawInt64( bf, p + sizeof(int64_t)*i ) ) < bf->_dataofs ||
+        blk->ofs[i] >= indexofs ) goto TERMINATE;
+  blk->nblock = blk->capacity = nblock;
+  blk->indexofs = indexofs;
+  ret = blk->indexed = true;
+ TERMINATE:
+  free( p );
+  if( !ret ) zFree( blk->ofs );
+  fseek( bf->_fp, bf->_dataofs, SEEK_SET );
+  return ret;
+}
+
+/* create a block reader. */
+bool _zBinFileBlockReaderCreate(zBinFile *bf)
+{
+  if( !_zBinFileBlockAlloc( bf ) ) return false;
+  _zBinFileBlockIndexFRead( bf ); /* a file without index is still read sequentially. */
+  bf->_read = _zBinFileBlockRead;
+  return true;
+}
+
+/* destroy the block layer. */
+bool _zBinFileBlockDestroy(zBinFile *bf)
+{
+  _zBinFileBlock *blk;
+  bool ret = true;
+
+  if( !( blk = (_zBinFileBlock *)bf->_blk ) ) return true;
+  if( bf->_write == _zBinFileBlockWrite )
+    ret = _zBinFileBlockFlush( bf ) && _zBinFileBlockIndexFWrite( bf );
+  free( blk->raw );
+  free( blk->comp );
+  free( blk->ofs );
+  zFree( bf->_blk );
+  bf->_read = _zBinFileStdioRead;
+  bf->_write = _zBinFileStdioWrite;
+  return ret;
+}
+
+/* current position of a binary file. */
+long zBinFileTell(zBinFile *bf)
+{
+  _zBinFileBlock *blk;
+
+  if( bf->_async ) return _zBinFileAsyncTell( bf );
+  if( !( blk = (_zBinFileBlock *)bf->_blk ) )
+    return bf->_rec && !((_zBinFileRecord *)bf->_rec)->writer ?
+      ((_zBinFileRecord *)bf->_rec)->cur : ftell( bf->_fp );
+  if( bf->_write == _zBinFileBlockWrite )
+    return bf->_dataofs + (long)blk->nblock * bf->_blocksize + (long)blk->len;
+  return blk->next == 0 ? bf->_dataofs :
+    bf->_dataofs + (long)( blk->next - 1 ) * bf->_blocksize + (long)blk->cur;
+}
+
+/* move the current position of a binary file. */
+bool zBinFileSeek(zBinFile *bf, long offset)
+{
+  _zBinFileBlock *blk;
+  int64_t i;
+  long pos;
+
+  if( !( blk = (_zBinFileBlock *)bf->_blk ) ){
+    if( fseek( bf->_fp, offset, SEEK_SET ) != 0 ) return false;
+    if( bf->_rec ) ((_zBinFileRecord *)bf->_rec)->cur = offset;
+    return true;
+  }
+  if( bf->_write == _zBinFileBlockWrite || !blk->indexed ){
+    ZRUNERROR( ZEDA_ERR_ZBD_NOT_SEEKABLE );
+    return false;
+  }
+  if( ( pos = offset - bf->_dataofs ) < 0 ) return false;
+  if( ( i = pos / bf->_blocksize ) >= blk->nblock ){
+    if( i > blk->nblock || pos % bf->_blocksize != 0 ) return false;
+    blk->next = blk->nblock; /* end of the payload */
+    blk->len = blk->cur = 0;
+    return true;
+  }
+  if( fseek( bf->_fp, blk->ofs[i], SEEK_SET ) != 0 ) return false;
+  blk->next = i;
+  if( !_zBinFileBlockLoad( bf ) || (size_t)( pos % bf->_blocksize ) > blk->len ) return false;
+  blk->cur = pos % bf->_blocksize;
+  return true;
+}
+
+/* parallel decompression of blocks */
+
+typedef struct{
+  zBinFile *bf;
+  const ubyte *comp; /* compressed blocks */
+  ubyte *raw;        /* payload, or NULL only to verify blocks */
+  int64_t from;      /* the first block */
+  int step;          /* interval of blocks */
+  int64_t nbroken;   /* number of broken blocks */
+  bool ret;
+} _zBinFileInflater;
+
+/* decompress every step-th block. */
+static void *_zBinFileInflateThread(void *arg)
+{
+  _zBinFileInflater *inf;
+  _zBinFileBlock *blk;
+  const ubyte *p;
+  int32_t rawsize, compsize;
+  uint32_t crc;
+  size_t hsize;
+  int64_t i;
+
+  inf = (_zBinFileInflater *)arg;
+  blk = (_zBinFileBlock *)inf->bf->_blk;
+  hsize = _zBinFileBlockHeaderSize(inf->bf);
+  inf->ret = true;
+  inf->nbroken = 0;
+  for( i=inf->from; i<blk->nblock; i+=inf->step ){
+    p = inf->comp + ( blk->ofs[i] - blk->ofs[0] );
+    if( blk->ofs[i] < blk->ofs[0] || blk->ofs[i] + (int64_t)hsize > blk->indexofs || /* header out of the payload */
+        !_zBinFileBlockHeader( inf->bf, p, &rawsize, &compsize, &crc ) ||
+        ( i < blk->nblock - 1 && rawsize != inf->bf->_blocksize ) ||
+        blk->ofs[i] + (int64_t)hsize + compsize > ( i < blk->nblock - 1 ? blk->ofs[i+1] : blk->indexofs ) ||
+        !_zBinFileBlockVerify( inf->bf, p + hsize, compsize, crc ) ){
+      inf->ret = false;
+      inf->nbroken++;
+      if( inf->raw ) break;
+      continue;
+    }
+    if( inf->raw &&
+        !_zBinFileBlockInflate( p + hsize, compsize, inf->raw + i*inf->bf->_blocksize, rawsize ) ){
+      inf->ret = false;
+      break;
+    }
+  }
+  return NULL;
+}
+
+/* decompress or verify all blocks in parallel. */
+static bool _zBinFileInflateAll(zBinFile *bf, const ubyte *comp, ubyte *raw, int nthread, int64_t *nbroken)
+{
+  _zBinFileInflater *inf;
+  int i;
+  bool ret = true;
+#ifdef __ZEDA_USE_PTHREAD
+  pthread_t *thread;
+  bool *created;
+#endif /* __ZEDA_USE_PTHREAD */
+
+  if( nthread < 1 ) nthread = 1;
+  if( !( inf = zAlloc( _zBinFileInflater, nthread ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  for( i=0; i<nthread; i++ ){
+    inf[i].bf = bf;
+    inf[i].comp = comp;
+    inf[i].raw = raw;
+    inf[i].from = i;
+    inf[i].step = nthread;
+    inf[i].ret = true;
+  }
+#ifdef __ZEDA_USE_PTHREAD
+  thread = zAlloc( pthread_t, nthread );
+  created = zAllocZero( bool, nthread );
+  if( thread && created ){
+    for( i=1; i<nthread; i++ )
+      created[i] = pthread_create( &thread[i], NULL, _zBinFileInflateThread, &inf[i] ) == 0;
+    _zBinFileInflateThread( &inf[0] );
+    for( i=1; i<nthread; i++ )
+      if( created[i] ) pthread_join( thread[i], NULL );
+      else _zBinFileInflateThread( &inf[i] );
+  } else
+#endif /* __ZEDA_USE_PTHREAD */
+  for( i=0; i<nthread; i++ ) _zBinFileInflateThread( &inf[i] );
+#ifdef __ZEDA_USE_PTHREAD
+  free( thread );
+  free( created );
+#endif /* __ZEDA_USE_PTHREAD */
+  for( *nbroken=0, i=0; i<nthread; i++ ){
+    if( !inf[i].ret ) ret = false;
+    *nbroken += inf[i].nbroken;
+  }
+  free( inf );
+  return ret;
+}
+
+/* read the whole compressed payload with a leading margin. */
+static ubyte *_zBinFileCompressedPayloadFRead(zBinFile *bf, size_t margin, size_t *size, int nthread)
+{
+  _zBinFileBlock *blk;
+  ubyte *comp = NULL, *raw = NULL, header[ZBINFILE_BLOCK_HEADER_MAXSIZE];
+  int32_t rawsize, compsize;
+  uint32_t crc;
+  int64_t nbroken;
+  size_t compall;
+
+  blk = (_zBinFileBlock *)bf->_blk;
+  if( bf->_write == _zBinFileBlockWrite || !blk->indexed ){
+    ZRUNERROR( ZEDA_ERR_ZBD_NOT_SEEKABLE );
+    return NULL;
+  }
+  *size = 0;
+  if( blk->nblock == 0 ) return zAlloc( ubyte, margin + 1 );
+  /* size of the last block */
+  if( fseek( bf->_fp, blk->ofs[blk->nblock-1], SEEK_SET ) != 0 ||
+      fread( header, 1, _zBinFileBlockHeaderSize(bf), bf->_fp ) < _zBinFileBlockHeaderSize(bf) ||
+      !_zBinFileBlockHeader( bf, header, &rawsize, &compsize, &crc ) ) return NULL;
+  *size = (size_t)( blk->nblock - 1 ) * bf->_blocksize + rawsize;
+  compall = blk->indexofs - blk->ofs[0];
+  if( !( comp = zAlloc( ubyte, compall ) ) || !( raw = zAlloc( ubyte, margin + *size ) ) ){
+    ZALLOCERROR();
+    goto FAILURE;
+  }
+  if( fseek( bf->_fp, blk->ofs[0], SEEK_SET ) != 0 ||
+      fread( comp, 1, compall, bf->_fp ) < compall ||
+      !_zBinFileInflateAll( bf, comp, raw + margin, nthread, &nbroken ) ){
+    ZRUNERROR( ZEDA_ERR_ZBD_INVALID_BLOCK );
+    goto FAILURE;
+  }
+  free( comp );
+  zBinFileSeek( bf, bf->_dataofs + *size );
+  return raw;
+
+ FAILURE:
+  free( comp );
+  free( raw );
+  return NULL;
+}
+
+/* read the whole payload with a leading margin. */
+static ubyte *_zBinFilePayloadFRead(zBinFile *bf, size_t margin, size_t *size, int nthread)
+{
+  ubyte *raw;
+  long filesize;
+
+  if( bf->_blk ) return _zBinFileCompressedPayloadFRead( bf, margin, size, nthread );
+  if( ( filesize = _zBinFileEnd( bf ) ) < bf->_dataofs ) return NULL;
+  *size = filesize - bf->_dataofs;
+  if( !( raw = zAlloc( ubyte, margin + *size + 1 ) ) ){
+    ZALLOCERROR();
+    return NULL;
+  }
+  if( fseek( bf->_fp, bf->_dataofs, SEEK_SET ) != 0 ||
+      fread( raw + margin, 1, *size, bf->_fp ) < *size ){
+    free( raw );
+    return NULL;
+  }
+  return raw;
+}
+
+/* read the whole payload of a binary file. */
+void *zBinFilePayloadFRead(zBinFile *bf, size_t *size, int nthread)
+{
+  return _zBinFilePayloadFRead( bf, 0, size, nthread );
+}
+
+/* verify checksums of all blocks of a binary file. */
+long zBinFileVerify(zBinFile *bf, int nthread)
+{
+  _zBinFileBlock *blk;
+  ubyte *comp;
+  size_t compall;
+  int64_t nbroken = -1;
+  long pos;
+
+  if( !zBinFileIsChecksummed( bf ) || !( blk = (_zBinFileBlock *)bf->_blk ) ||
+      bf->_write == _zBinFileBlockWrite || !blk->indexed ){
+    ZRUNERROR( ZEDA_ERR_ZBD_NOT_VERIFIABLE );
+    return -1;
+  }
+  if( blk->nblock == 0 ) return 0;
+  compall = blk->indexofs - blk->ofs[0];
+  if( !( comp = zAlloc( ubyte, compall ) ) ){
+    ZALLOCERROR();
+    return -1;
+  }
+  if( ( pos = ftell( bf->_fp ) ) < 0 ||
+      fseek( bf->_fp, blk->ofs[0], SEEK_SET ) != 0 ||
+      fread( comp, 1, compall, bf->_fp ) < compall ) goto TERMINATE;
+  _zBinFileInflateAll( bf, comp, NULL, nthread, &nbroken );
+  fseek( bf->_fp, pos, SEEK_SET ); /* blocks being read are kept */
+ TERMINATE:
+  free( comp );
+  return (long)nbroken;
+}
+
+/* encoded columns */
+
+/* write an encoded column. */
+static size_t _zBinFileColumnFWrite(zBinFile *bf, const void *val, size_t n, size_t (* compress)(const void*,size_t,void*,size_t))
+{
+  ubyte *buf;
+  int32_t num, size;
+
+  if( n == 0 || n > ZTS_COMPRESS_NUM_MAX ) return 0; /* size has to be in int32_t */
+  if( !( buf = zAlloc( ubyte, zTSCompressBound(n) ) ) ){
+    ZALLOCERROR();
+    return 0;
+  }
+  num = n;
+  if( ( size = compress( val, n, buf, zTSCompressBound(n) ) ) == 0 ||
+      bf->_fwrite_int32( bf, &num ) < 1 || bf->_fwrite_int32( bf, &size ) < 1 ||
+      bf->_write( bf, buf, 1, size ) < (size_t)size ) n = 0;
+  free( buf );
+  return n;
+}
+
+/* read an encoded column. */
+static size_t _zBinFileColumnFRead(zBinFile *bf, void *val, size_t n, size_t (* decompress)(const void*,size_t,void*,size_t))
+{
+  ubyte *buf;
+  int32_t num, size;
+
+  if( bf->_fread_int32( bf, &num ) < 1 || bf->_fread_int32( bf, &size ) < 1 ) return 0;
+  if( num <= 0 || size <= 0 ){
+    ZRUNERROR( ZEDA_ERR_ZBD_INVALID_COLUMN );
+    return 0;
+  }
+  if( !( buf = zAlloc( ubyte, size ) ) ){
+    ZALLOCERROR();
+    return 0;
+  }
+  if( (size_t)num < n ) n = num;
+  if( bf->_read( bf, buf, 1, size ) < (size_t)size || decompress( buf, size, val, n ) < n ){
+    ZRUNERROR( ZEDA_ERR_ZBD_INVALID_COLUMN );
+    n = 0;
+  }
+  free( buf );
+  return n;
+}
+
+/* adapters of the codecs. */
+static size_t _zBinFileDoubleCompress(const void *src, size_t n, void *dst, size_t dstsize)
+{
+  return zTSDoubleCompress( (const double *)src, n, dst, dstsize );
+}
+
+static size_t _zBinFileDoubleDecompress(const void *src, size_t srcsize, void *dst, size_t n)
+{
+  return zTSDoubleDecompress( src, srcsize, (double *)dst, n );
+}
+
+static size_t _zBinFileInt64Compress(const void *src, size_t n, void *dst, size_t dstsize)
+{
+  return zTSInt64Compress( (const int64_t *)src, n, dst, dstsize );
+}
+
+static size_t _zBinFileInt64Decompress(const void *src, size_t srcsize, void *dst, size_t n)
+{
+  return zTSInt64Decompress( src, srcsize, (int64_t *)dst, n );
+}
+
+/* write an encoded column of double-precision values. */
+size_t zBinFileDoubleColumnFWrite(zBinFile *bf, const double val[], size_t n)
+{
+  return _zBinFileColumnFWrite( bf, val, n, _zBinFileDoubleCompress );
+}
+
+/* read an encoded column of double-precision values. */
+size_t zBinFileDoubleColumnFRead(zBinFile *bf, double val[], size_t n)
+{
+  return _zBinFileColumnFRead( bf, val, n, _zBinFileDoubleDecompress );
+}
+
+/* write an encoded column of 64-bit integers. */
+size_t zBinFileInt64ColumnFWrite(zBinFile *bf, const int64_t val[], size_t n)
+{
+  return _zBinFileColumnFWrite( bf, val, n, _zBinFileInt64Compress );
+}
+
+/* read an encoded column of 64-bit integers. */
+size_t zBinFileInt64ColumnFRead(zBinFile *bf, int64_t val[], size_t n)
+{
+  return _zBinFileColumnFRead( bf, val, n, _zBinFileInt64Decompress );
+}
+
+/* asynchronous writer */
+
+#ifdef __ZEDA_USE_PTHREAD
+typedef struct{
+  ubyte **buf;      /* ring of buffers */
+  size_t *len;      /* sizes of data in buffers */
+  int nbuf;         /* number of buffers */
+  size_t bufsize;   /* size of a buffer */
+  int policy;       /* overflow policy */
+  /* producer */
+  int head;         /* buffer being filled */
+  bool owned;       /* whether the producer owns the head buffer */
+  size_t nreserved; /* number of free buffers reserved */
+  size_t fill;      /* size of data in the head buffer */
+  long base;        /* offset where the asynchronous writer started */
+  long accepted;    /* number of bytes accepted */
+  /* consumer */
+  int tail;         /* buffer to be drained */
+  /* shared under the mutex */
+  int nfull;        /* number of buffers waiting to be written */
+  int nfree;        /* number of free buffers */
+  size_t nwrite;    /* number of buffers drained */
+  bool stop;        /* stop request */
+  bool error;       /* write error */
+  size_t (* write)(struct _zBinFile*,const void*,size_t,size_t); /* lower writer */
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond_full;  /* signaled when a buffer is published */
+  pthread_cond_t cond_empty; /* signaled when a buffer is drained */
+  zBinFileAsyncStat stat;
+} _zBinFileAsync;
+
+/* drain buffers in the background. */
+static void *_zBinFileAsyncThread(void *arg)
+{
+  zBinFile *bf;
+  _zBinFileAsync *async;
+  bool error;
+
+  bf = (zBinFile *)arg;
+  async = (_zBinFileAsync *)bf->_async;
+  pthread_mutex_lock( &async->mutex );
+  while( 1 ){
+    while( async->nfull == 0 && !async->stop )
+      pthread_cond_wait( &async->cond_full, &async->mutex );
+    if( async->nfull == 0 ) break; /* stopped after all buffers are drained */
+    pthread_mutex_unlock( &async->mutex );
+    error = async->write( bf, async->buf[async->tail], 1, async->len[async->tail] ) < async->len[async->tail];
+    async->tail = ( async->tail + 1 ) % async->nbuf;
+    pthread_mutex_lock( &async->mutex );
+    if( error ) async->error = true;
+    async->nfull--;
+    async->nfree++;
+    async->nwrite++;
+    pthread_cond_signal( &async->cond_empty );
+  }
+  pthread_mutex_unlock( &async->mutex );
+  return NULL;
+}
+
+/* publish the head buffer to be written. */
+static void _zBinFileAsyncPublish(_zBinFileAsync *async)
+{
+  async->len[async->head] = async->fill;
+  pthread_mutex_lock( &async->mutex );
+  if( ++async->nfull > async->stat.maxdepth )
+    async->stat.maxdepth = async->nfull;
+  pthread_cond_signal( &async->cond_full );
+  pthread_mutex_unlock( &async->mutex );
+  async->head = ( async->head + 1 ) % async->nbuf;
+  async->owned = false;
+  async->fill = 0;
+}
+
+/* reserve free buffers to store data of a given size as a whole. */
+static bool _zBinFileAsyncReserve(_zBinFileAsync *async, size_t size)
+{
+  size_t room, n;
+  bool ret = false;
+
+  room = async->owned ? async->bufsize - async->fill : 0;
+  if( size <= room ) return true;
+  n = ( size - room - 1 ) / async->bufsize + 1;
+  if( n > (size_t)async->nbuf ) return false;
+  pthread_mutex_lock( &async->mutex );
+  if( (size_t)async->nfree >= n ){
+    async->nfree -= n;
+    ret = true;
+  }
+  pthread_mutex_unlock( &async->mutex );
+  if( ret ) async->nreserved = n;
+  return ret;
+}
+
+/* acquire a free buffer. */
+static void _zBinFileAsyncAcquire(_zBinFileAsync *async)
+{
+  if( async->nreserved > 0 )
+    async->nreserved--;
+  else{
+    pthread_mutex_lock( &async->mutex );
+    if( async->nfree == 0 ){
+      async->stat.nstall++;
+      while( async->nfree == 0 )
+        pthread_cond_wait( &async->cond_empty, &async->mutex );
+    }
+    async->nfree--;
+    pthread_mutex_unlock( &async->mutex );
+  }
+  async->owned = true;
+  async->fill = 0;
+}
+
+/* write data to the ring of buffers. */
+static size_t _zBinFileAsyncWrite(zBinFile *bf, const void *buf, size_t size, size_t n)
+{
+  _zBinFileAsync *async;
+  const ubyte *p;
+  size_t rest, m;
+
+  async = (_zBinFileAsync *)bf->_async;
+  rest = size * n;
+  if( async->owned && async->fill + rest > async->bufsize && async->fill > 0 )
+    _zBinFileAsyncPublish( async );
+  /* a write is discarded as a whole unless free buffers are reserved for it */
+  if( async->policy != ZBINFILE_ASYNC_BLOCK && !_zBinFileAsyncReserve( async, rest ) ){
+    async->stat.noverflow++;
+    async->stat.dropped += rest;
+    return async->policy == ZBINFILE_ASYNC_DROP ? n : 0;
+  }
+  for( p=(const ubyte *)buf; rest>0; p+=m, rest-=m ){
+    if( !async->owned ) _zBinFileAsyncAcquire( async );
+    m = _zMin( rest, async->bufsize - async->fill );
+    memcpy( async->buf[async->head] + async->fill, p, m );
+    async->accepted += m;
+    if( ( async->fill += m ) == async->bufsize ) _zBinFileAsyncPublish( async );
+  }
+  return n;
+}
+
+/* free the asynchronous writer. */
+static void _zBinFileAsyncFree(zBinFile *bf)
+{
+  _zBinFileAsync *async;
+  int i;
+
+  if( !( async = (_zBinFileAsync *)bf->_async ) ) return;
+  for( i=0; async->buf && i<async->nbuf; i++ ) free( async->buf[i] );
+  free( async->buf );
+  free( async->len );
+  zFree( bf->_async );
+}
+#endif /* __ZEDA_USE_PTHREAD */
+
+/* set a binary file to be written asynchronously. */
+bool zBinFileSetAsync(zBinFile *bf, int nbuf, size_t bufsize, int policy)
+{
+#ifdef __ZEDA_USE_PTHREAD
+  _zBinFileAsync *async;
+  int i;
+
+  if( bf->_async || nbuf < 1 || bufsize == 0 ) return false;
+  if( !( async = zAllocZero( _zBinFileAsync, 1 ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  async->base = zBinFileTell( bf );
+  bf->_async = async;
+  async->nbuf = async->stat.nbuf = nbuf;
+  async->bufsize = bufsize;
+  async->policy = policy;
+  if( !( async->buf = zAllocZero( ubyte*, nbuf ) ) || !( async->len = zAlloc( size_t, nbuf ) ) )
+    goto FAILURE;
+  for( i=0; i<nbuf; i++ )
+    if( !( async->buf[i] = zAlloc( ubyte, bufsize ) ) ) goto FAILURE;
+  async->write = bf->_write;
+  async->nfree = nbuf;
+  pthread_mutex_init( &async->mutex, NULL );
+  pthread_cond_init( &async->cond_full, NULL );
+  pthread_cond_init( &async->cond_empty, NULL );
+  if( pthread_create( &async->thread, NULL, _zBinFileAsyncThread, bf ) != 0 ){
+    ZRUNERROR( ZEDA_ERR_THREAD_CREATE );
+    pthread_mutex_destroy( &async->mutex );
+    pthread_cond_destroy( &async->cond_full );
+    pthread_cond_destroy( &async->cond_empty );
+    _zBinFileAsyncFree( bf );
+    return false;
+  }
+  bf->_write = _zBinFileAsyncWrite;
+  return true;
+
+ FAILURE:
+  ZALLOCERROR();
+  _zBinFileAsyncFree( bf );
+  return false;
+#else
+  return true; /* written synchronously */
+#endif /* __ZEDA_USE_PTHREAD */
+}
+
+/* statistics of the asynchronous writer. */
+bool zBinFileAsyncGetStat(zBinFile *bf, zBinFileAsyncStat *stat)
+{
+#ifdef __ZEDA_USE_PTHREAD
+  _zBinFileAsync *async;
+
+  if( !( async = (_zBinFileAsync *)bf->_async ) ) return false;
+  pthread_mutex_lock( &async->mutex );
+  *stat = async->stat;
+  stat->depth = async->nfull;
+  stat->nwrite = async->nwrite;
+  pthread_mutex_unlock( &async->mutex );
+  return true;
+#else
+  return false;
+#endif /* __ZEDA_USE_PTHREAD */
+}
+
+/* current position of the asynchronous writer. */
+long _zBinFileAsyncTell(zBinFile *bf)
+{
+#ifdef __ZEDA_USE_PTHREAD
+  _zBinFileAsync *async;
+
+  async = (_zBinFileAsync *)bf->_async;
+  return async->base + async->accepted;
+#else
+  return -1;
+#endif /* __ZEDA_USE_PTHREAD */
+}
+
+/* drain all buffers and stop the asynchronous writer. */
+bool _zBinFileAsyncDestroy(zBinFile *bf)
+{
+#ifdef __ZEDA_USE_PTHREAD
+  _zBinFileAsync *async;
+  bool ret;
+
+  if( !( async = (_zBinFileAsync *)bf->_async ) ) return true;
+  if( async->owned && async->fill > 0 ) _zBinFileAsyncPublish( async );
+  pthread_mutex_lock( &async->mutex );
+  async->stop = true;
+  pthread_cond_signal( &async->cond_full );
+  pthread_mutex_unlock( &async->mutex );
+  pthread_join( async->thread, NULL );
+  pthread_mutex_destroy( &async->mutex );
+  pthread_cond_destroy( &async->cond_full );
+  pthread_cond_destroy( &async->cond_empty );
+  bf->_write = async->write;
+  ret = !async->error;
+  _zBinFileAsyncFree( bf );
+  return ret;
+#else
+  return true;
+#endif /* __ZEDA_USE_PTHREAD */
+}
+
+/* schema of records */
+
+/* add a field to a schema of records. */
+bool zBinFileSchemaAddField(zBinFileSchema *schema, const char *name, int type, int count)
+{
+  zBinFileField field;
+  uint size;
+
+  if( type < ZBINFILE_TYPE_BYTE || type > ZBINFILE_TYPE_INT64_COLUMN || count < 0 ){
+    ZRUNERROR( ZEDA_ERR_ZBD_INVALID_FIELD, name );
+    return false;
+  }
+  if( !zNameSet( &field, name ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  field.type = type;
+  field.count = count;
+  size = zArraySize(schema);
+  zArrayAdd( schema, zBinFileField, &field );
+  if( zArraySize(schema) == size ){
+    zNameFree( &field );
+    return false;
+  }
+  return true;
+}
+
+/* destroy a schema of records. */
+void zBinFileSchemaDestroy(zBinFileSchema *schema)
+{
+  uint i;
+
+  for( i=0; i<zArraySize(schema); i++ )
+    zNameFree( zArrayElemNC(schema,i) );
+  zArrayFree( schema );
+}
+
+/* record index */
+
+/* set a flag to write the record index. */
+void zBinFileSetRecordIndex(zBinFile *bf, zBinFileSchema *schema)
+{
+  if( bf->version < 2 ) bf->version = 2; /* flags are available since version 2 */
+  bf->flags |= ZBINFILE_FLAG_RECORD;
+  bf->_schema = schema;
+}
+
+/* allocate a record index. */
+static _zBinFileRecord *_zBinFileRecordAlloc(zBinFile *bf)
+{
+  _zBinFileRecord *rec;
+
+  if( !( rec = zAlloc( _zBinFileRecord, 1 ) ) ){
+    ZALLOCERROR();
+    return NULL;
+  }
+  rec->ofs = NULL;
+  rec->key = NULL;
+  rec->nrec = rec->capacity = 0;
+  rec->footerofs = -1;
+  rec->writer = false;
+  zBinFileSchemaInit( &rec->schema );
+  return ( bf->_rec = rec );
+}
+
+/* create a record index to be written. */
+bool _zBinFileRecordWriterCreate(zBinFile *bf)
+{
+  _zBinFileRecord *rec;
+
+  if( !( rec = _zBinFileRecordAlloc( bf ) ) ) return false;
+  rec->writer = true;
+  return true;
+}
+
+/* mark the head of a record. */
+bool zBinFileRecordMark(zBinFile *bf, double key)
+{
+  _zBinFileRecord *rec;
+  int64_t *ofs;
+  double *k;
+  long pos;
+
+  if( !( rec = (_zBinFileRecord *)bf->_rec ) || !rec->writer ){
+    ZRUNERROR( ZEDA_ERR_ZBD_NO_RECORD_INDEX );
+    return false;
+  }
+  if( ( pos = zBinFileTell( bf ) ) < 0 ) return false;
+  if( rec->nrec == rec->capacity ){
+    ofs = zRealloc( rec->ofs, int64_t, rec->capacity > 0 ? rec->capacity*2 : 64 );
+    k = ofs ? zRealloc( rec->key, double, rec->capacity > 0 ? rec->capacity*2 : 64 ) : NULL;
+    if( ofs ) rec->ofs = ofs;
+    if( !ofs || !k ){
+      ZALLOCERROR();
+      return false;
+    }
+    rec->key = k;
+    rec->capacity = rec->capacity > 0 ? rec->capacity*2 : 64;
+  }
+  rec->ofs[rec->nrec] = pos;
+  rec->key[rec->nrec++] = key;
+  return true;
+}
+
+/* write the footer of records. */
+static bool _zBinFileRecordFooterFWrite(zBinFile *bf)
+{
+  _zBinFileRecord *rec;
+  zBinFileField *field;
+  long footerofs;
+  int64_t i, v;
+  int32_t len;
+
+  rec = (_zBinFileRecord *)bf->_rec;
+  if( ( footerofs = ftell( bf->_fp ) ) < 0 ||
+      _zBinFileRawInt64FWrite( bf, rec->nrec ) < 1 ) return false;
+  for( i=0; i<rec->nrec; i++ )
+    if( _zBinFileRawInt64FWrite( bf, rec->ofs[i] ) < 1 ) return false;
+  for( i=0; i<rec->nrec; i++ ){
+    memcpy( &v, &rec->key[i], sizeof(int64_t) );
+    if( _zBinFileRawInt64FWrite( bf, v ) < 1 ) return false;
+  }
+  if( _zBinFileRawInt32FWrite( bf, bf->_schema ? zArraySize(bf->_schema) : 0 ) < 1 ) return false;
+  for( i=0; bf->_schema && i<zArraySize(bf->_schema); i++ ){
+    field = zArrayElemNC( bf->_schema, i );
+    len = strlen( zName(field) );
+    if( _zBinFileRawInt32FWrite( bf, field->type ) < 1 ||
+        _zBinFileRawInt32FWrite( bf, field->count ) < 1 ||
+        _zBinFileRawInt32FWrite( bf, len ) < 1 ||
+        fwrite( zName(field), 1, len, bf->_fp ) < (size_t)len ) return false;
+  }
+  return _zBinFileRawInt64FWrite( bf, footerofs ) == 1 &&
+         fwrite( ZBINFILE_RECORD_ID, 1, 4, bf->_fp ) == 4;
+}
+
+/* parse the schema of records in the footer. */
+static bool _zBinFileRecordSchemaParse(zBinFile *bf, _zBinFileRecord *rec, const ubyte *p, const ubyte *end)
+{
+  int32_t nfield, type, count, len;
+  char *name;
+  bool ret;
+
+  if( end - p < (long)sizeof(int32_t) ) return false;
+  nfield = _zBinFileRawInt32( bf, p ); p += sizeof(int32_t);
+  for( ; nfield>0; nfield-- ){
+    if( end - p < (long)sizeof(int32_t)*3 ) return false;
+    type = _zBinFileRawInt32( bf, p );
+    count = _zBinFileRawInt32( bf, p + sizeof(int32_t) );
+    len = _zBinFileRawInt32( bf, p + sizeof(int32_t)*2 );
+    p += sizeof(int32_t)*3;
+    if( len < 0 || end - p < len ) return false;
+    if( !( name = zAlloc( char, len+1 ) ) ){
+      ZALLOCERROR();
+      return false;
+    }
+    memcpy( name, p, len );
+    name[len] = '\0';
+    p += len;
+    ret = zBinFileSchemaAddField( &rec->schema, name, type, count );
+    free( name );
+    if( !ret ) return false;
+  }
+  return p == end;
+}
+
+/* read the footer of records. */
+static bool _zBinFileRecordFooterFRead(zBinFile *bf, _zBinFileRecord *rec)
+{
+  ubyte trailer[ZBINFILE_RECORD_TRAILER_SIZE], *buf = NULL, *p;
+  long size, footerofs;
+  int64_t i, v;
+  bool ret = false;
+
+  if( ( size = zFileSize( bf->_fp ) ) < bf->_dataofs + (long)ZBINFILE_RECORD_TRAILER_SIZE ||
+      fseek( bf->_fp, size - ZBINFILE_RECORD_TRAILER_SIZE, SEEK_SET ) != 0 ||
+      fread( trailer, 1, ZBINFILE_RECORD_TRAILER_SIZE, bf->_fp ) < ZBINFILE_RECORD_TRAILER_SIZE ||
+      strncmp( (char *)trailer + sizeof(int64_t), ZBINFILE_RECORD_ID, 4 ) != 0 ) goto TERMINATE;
+  footerofs = _zBinFileRawInt64( bf, trailer );
+  size -= ZBINFILE_RECORD_TRAILER_SIZE;
+  if( footerofs < bf->_dataofs || size - footerofs < (long)sizeof(int64_t) ) goto TERMINATE;
+  if( !( buf = zAlloc( ubyte, size - footerofs ) ) ){
+    ZALLOCERROR();
+    goto TERMINATE;
+  }
+  if( fseek( bf->_fp, footerofs, SEEK_SET ) != 0 ||
+      fread( buf, 1, size - footerofs, bf->_fp ) < (size_t)( size - footerofs ) ) goto TERMINATE;
+  rec->nrec = _zBinFileRawInt64( bf, buf );
+  if( rec->nrec < 0 || rec->nrec > ( size - footerofs - (long)sizeof(int64_t) ) / (long)( sizeof(int64_t)*2 ) ) goto TERMINATE;
+  if( rec->nrec > 0 &&
+      ( !( rec->ofs = zAlloc( int64_t, rec->nrec ) ) || !( rec->key = zAlloc( double, rec->nrec ) ) ) ){
+    ZALLOCERROR();
+    goto TERMINATE;
+  }
+  rec->capacity = rec->nrec;
+  for( p=buf+sizeof(int64_t), i=0; i<rec->nrec; i++, p+=sizeof(int64_t) )
+    if( ( rec->ofs[i] = _zBinFileRawInt64( bf, p ) ) < bf->_dataofs ) goto TERMINATE;
+  for( i=0; i<rec->nrec; i++, p+=sizeof(int64_t) ){
+    v = _zBinFileRawInt64( bf, p );
+    memcpy( &rec->key[i], &v, sizeof(double) );
+  }
+  if( !_zBinFileRecordSchemaParse( bf, rec, p, buf + ( size - footerofs ) ) ) goto TERMINATE;
+  rec->footerofs = footerofs;
+  ret = true;
+ TERMINATE:
+  free( buf );
+  if( !ret ) ZRUNERROR( ZEDA_ERR_ZBD_INVALID_RECORD_INDEX );
+  fseek( bf->_fp, bf->_dataofs, SEEK_SET );
+  return ret;
+}
+
+/* read data of an uncompressed file not to exceed the footer. */
+static size_t _zBinFileRecordRead(zBinFile *bf, void *buf, size_t size, size_t n)
+{
+  _zBinFileRecord *rec;
+
+  rec = (_zBinFileRecord *)bf->_rec;
+  if( size == 0 || rec->cur >= rec->footerofs ) return 0;
+  if( size*n > (size_t)( rec->footerofs - rec->cur ) )
+    n = ( rec->footerofs - rec->cur ) / size;
+  n = fread( buf, size, n, bf->_fp );
+  rec->cur += size*n;
+  return n;
+}
+
+/* create a record index read from the footer. */
+bool _zBinFileRecordReaderCreate(zBinFile *bf)
+{
+  _zBinFileRecord *rec;
+
+  if( !( rec = _zBinFileRecordAlloc( bf ) ) ) return false;
+  if( !_zBinFileRecordFooterFRead( bf, rec ) ){
+    _zBinFileRecordDestroy( bf );
+    return false;
+  }
+  rec->cur = bf->_dataofs;
+  bf->_read = _zBinFileRecordRead; /* replaced by the block reader if compressed */
+  return true;
+}
+
+/* destroy the record index. */
+bool _zBinFileRecordDestroy(zBinFile *bf)
+{
+  _zBinFileRecord *rec;
+  bool ret = true;
+
+  if( !( rec = (_zBinFileRecord *)bf->_rec ) ) return true;
+  if( rec->writer ) ret = _zBinFileRecordFooterFWrite( bf );
+  free( rec->ofs );
+  free( rec->key );
+  zBinFileSchemaDestroy( &rec->schema );
+  zFree( bf->_rec );
+  return ret;
+}
+
+/* number of records of a binary file. */
+int64_t zBinFileRecordNum(zBinFile *bf)
+{
+  return bf->_rec ? ((_zBinFileRecord *)bf->_rec)->nrec : 0;
+}
+
+/* key of a record of a binary file. */
+double zBinFileRecordKey(zBinFile *bf, int64_t i)
+{
+  return i >= 0 && i < zBinFileRecordNum( bf ) ? ((_zBinFileRecord *)bf->_rec)->key[i] : 0;
+}
+
+/* move to the head of a record of a binary file. */
+bool zBinFileRecordSeek(zBinFile *bf, int64_t i)
+{
+  if( i < 0 || i >= zBinFileRecordNum( bf ) ){
+    ZRUNERROR( ZEDA_ERR_ZBD_INVALID_RECORD, (long)i );
+    return false;
+  }
+  return zBinFileSeek( bf, ((_zBinFileRecord *)bf->_rec)->ofs[i] );
+}
+
+/* find the first record with a key equal to or larger than a given key. */
+int64_t zBinFileRecordFind(zBinFile *bf, double key)
+{
+  _zBinFileRecord *rec;
+  int64_t lo, hi, mid;
+
+  if( !( rec = (_zBinFileRecord *)bf->_rec ) ) return 0;
+  for( lo=0, hi=rec->nrec; lo<hi; ){
+    mid = lo + ( hi - lo ) / 2;
+    if( rec->key[mid] < key ) lo = mid + 1; else hi = mid;
+  }
+  return lo;
+}
+
+/* schema of records of a binary file. */
+zBinFileSchema *zBinFileRecordSchema(zBinFile *bf)
+{
+  _zBinFileRecord *rec;
+
+  if( !( rec = (_zBinFileRecord *)bf->_rec ) ) return NULL;
+  return rec->writer ? bf->_schema : &rec->schema;
+}
+
+/* print a 64-bit integer value, for which C89 has no format. */
+static void _zBinFileInt64FPrint(FILE *fp, int64_t val)
+{
+  char buf[24], *p;
+  uint64_t u;
+
+  p = buf + sizeof(buf);
+  *--p = '\0';
+  u = val < 0 ? -(uint64_t)val : (uint64_t)val;
+  do{
+    *--p = '0' + u % 10;
+  } while( ( u /= 10 ) > 0 );
+  if( val < 0 ) *--p = '-';
+  fputs( p, fp );
+}
+
+/* print a record of a binary file according to its schema. */
+bool zBinFileRecordFPrint(FILE *fp, zBinFile *bf)
+{
+  zBinFileSchema *schema;
+  zBinFileField *field;
+  byte b;
+  int i;
+  long l;
+  float f;
+  double d;
+  void *col;
+  uint j;
+  int k, n;
+  bool ret = true, sep = false;
+
+  if( !( schema = zBinFileRecordSchema( bf ) ) ) return false;
+  for( j=0; j<zArraySize(schema) && ret; j++ ){
+    field = zArrayElemNC( schema, j );
+    if( field->type == ZBINFILE_TYPE_DOUBLE_COLUMN || field->type == ZBINFILE_TYPE_INT64_COLUMN ){
+      if( field->count == 0 ) continue;
+      if( !( col = zAlloc( int64_t, field->count ) ) ){
+        ZALLOCERROR();
+        return false;
+      }
+      n = field->type == ZBINFILE_TYPE_DOUBLE_COLUMN ?
+        zBinFileDoubleColumnFRead( bf, (double *)col, field->count ) :
+        zBinFileInt64ColumnFRead( bf, (int64_t *)col, field->count );
+      for( k=0; k<n; k++, sep=true ){
+        if( sep ) fputc( ',', fp );
+        if( field->type == ZBINFILE_TYPE_DOUBLE_COLUMN )
+          fprintf( fp, "%.17g", ((double *)col)[k] );
+        else
+          _zBinFileInt64FPrint( fp, ((int64_t *)col)[k] );
+      }
+      free( col );
+      if( n == 0 ) ret = false;
+      continue;
+    }
+    for( k=0; k<field->count; k++, sep=true ){
+      if( sep ) fputc( ',', fp );
+      switch( field->type ){
+      case ZBINFILE_TYPE_BYTE:
+        if( ( ret = bf->_read( bf, &b, 1, 1 ) == 1 ) ) fprintf( fp, "%d", b );
+        break;
+      case ZBINFILE_TYPE_INT:
+        if( ( ret = zBinFileIntNFRead( bf, &i, 1 ) == 1 ) ) fprintf( fp, "%d", i );
+        break;
+      case ZBINFILE_TYPE_LONG:
+        if( ( ret = zBinFileLongNFRead( bf, &l, 1 ) == 1 ) ) fprintf( fp, "%ld", l );
+        break;
+      case ZBINFILE_TYPE_FLOAT:
+        if( ( ret = zBinFileFloatNFRead( bf, &f, 1 ) == 1 ) ) fprintf( fp, "%.9g", f );
+        break;
+      case ZBINFILE_TYPE_DOUBLE:
+        if( ( ret = zBinFileDoubleNFRead( bf, &d, 1 ) == 1 ) ) fprintf( fp, "%.17g", d );
+        break;
+      default: ret = false;
+      }
+      if( !ret ) break;
+    }
+  }
+  fputc( '\n', fp );
+  return ret;
+}
+
+/* pad a binary file to an aligned offset. */
+size_t zBinFileAlignFWrite(zBinFile *bf, size_t align)
+{
+  long pos;
+  size_t size = 0;
+
+  if( align == 0 || ( pos = zBinFileTell( bf ) ) < 0 ) return 0;
+  for( ; ( pos + size ) % align != 0; size++ )
+    if( zBinFileByteFWrite( bf, 0 ) < 1 ) break;
+  return size;
+}
+
+/* memory-mapped reader of binary files */
+
+/* number of threads to decompress a compressed file. */
+#define ZBINFILE_MAP_THREAD_NUM 4
+
+/* load the whole of a binary file into the memory. */
+static bool _zBinFileMapLoad(zBinFileMap *map, FILE *fp)
+{
+  if( !( map->_buf = zAlloc( byte, map->_size ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  rewind( fp );
+  map->_mapped = false;
+  return fread( map->_buf, 1, map->_size, fp ) == map->_size;
+}
+
+/* map the whole of a binary file to the memory. */
+static bool _zBinFileMapMap(zBinFileMap *map, FILE *fp)
+{
+#ifndef __WINDOWS__
+  void *buf;
+
+  if( ( buf = mmap( NULL, map->_size, PROT_READ, MAP_PRIVATE, fileno( fp ), 0 ) ) == MAP_FAILED )
+    return false;
+  map->_buf = (byte *)buf;
+  map->_mapped = true;
+  return true;
+#else
+  return false;
+#endif /* __WINDOWS__ */
+}
+
+/* open a memory-mapped reader of a binary file. */
+zBinFileMap *zBinFileMapOpen(zBinFileMap *map, char filename[])
+{
+  zBinFileMap *ret = NULL;
+
+  map->_buf = NULL;
+  map->_size = map->_cur = 0;
+  map->_mapped = false;
+  map->_tmp = NULL;
+  map->_tmpsize = 0;
+  if( !zBinFileOpen( &map->bf, filename, "rb" ) ) return NULL;
+  if( !zBinFileHeaderFRead( &map->bf ) ) goto TERMINATE;
+  map->_cur = map->bf._dataofs;
+  if( map->bf._blk ){
+    if( ( map->_buf = (byte *)_zBinFilePayloadFRead( &map->bf, map->_cur, &map->_size, ZBINFILE_MAP_THREAD_NUM ) ) )
+      map->_size += map->_cur;
+    else
+      goto TERMINATE;
+  } else{
+    map->_size = _zBinFileEnd( &map->bf ); /* not to expose the footer */
+    if( !_zBinFileMapMap( map, map->bf._fp ) && !_zBinFileMapLoad( map, map->bf._fp ) ){
+      zBinFileMapClose( map );
+      goto TERMINATE;
+    }
+  }
+  ret = map;
+ TERMINATE:
+  zBinFileClose( &map->bf );
+  map->bf._fp = NULL;
+  return ret;
+}
+
+/* close a memory-mapped reader of a binary file. */
+void zBinFileMapClose(zBinFileMap *map)
+{
+#ifndef __WINDOWS__
+  if( map->_mapped )
+    munmap( map->_buf, map->_size );
+  else
+#endif /* __WINDOWS__ */
+    free( map->_buf );
+  zFree( map->_tmp );
+  map->_buf = NULL;
+  map->_size = map->_cur = map->_tmpsize = 0;
+  map->_mapped = false;
+}
+
+/* move the current position in a mapped binary file. */
+bool zBinFileMapSeek(zBinFileMap *map, size_t offset)
+{
+  if( offset > map->_size ) return false;
+  map->_cur = offset;
+  return true;
+}
+
+/* move the current position in a mapped binary file to an aligned offset. */
+bool zBinFileMapAlign(zBinFileMap *map, size_t align)
+{
+  if( align == 0 ) return true;
+  return zBinFileMapSeek( map, ( map->_cur + align - 1 ) / align * align );
+}
+
+/* buffer for converted values. */
+static void *_zBinFileMapTmp(zBinFileMap *map, size_t size)
+{
+  void *tmp;
+
+  if( size <= map->_tmpsize ) return map->_tmp;
+  if( !( tmp = zRealloc( map->_tmp, byte, size ) ) ){
+    ZALLOCERROR();
+    return NULL;
+  }
+  map->_tmpsize = size;
+  return map->_tmp = tmp;
+}
+
+/* check if a mapped binary file has an array from the current position. */
+#define _zBinFileMapHas(map,size,n) ( (n) <= ( (map)->_size - (map)->_cur ) / (size) )
+
+/* pointer to bytes in a mapped binary file. */
+const ubyte *zBinFileMapBytes(zBinFileMap *map, size_t n)
+{
+  const ubyte *p;
+
+  if( !_zBinFileMapHas( map, 1, n ) ) return NULL;
+  p = (const ubyte *)map->_buf + map->_cur;
+  map->_cur += n;
+  return p;
+}
+
+/* pointer to an array of fixed-size values in a mapped binary file. */
+static const void *_zBinFileMapArray(zBinFileMap *map, size_t size, size_t n)
+{
+  const byte *p;
+  void *tmp;
+
+  if( !_zBinFileMapHas( map, size, n ) ) return NULL;
+  p = map->_buf + map->_cur;
+  if( !_zBinFileEndianIsSame( &map->bf ) || (size_t)p % size != 0 ){
+    if( !( tmp = _zBinFileMapTmp( map, size*n ) ) ) return NULL;
+    memcpy( tmp, p, size*n );
+    if( !_zBinFileEndianIsSame( &map->bf ) )
+      _zBinFileEndianReverseArray( tmp, size, n );
+    p = (const byte *)tmp;
+  }
+  map->_cur += size*n;
+  return p;
+}
+
+/* an integer value of a given size in a mapped binary file. */
+static int64_t _zBinFileMapInt(zBinFile *bf, const byte *p, size_t size)
+{
+  union{
+    int16_t i16;
+    int32_t i32;
+    int64_t i64;
+  } val;
+
+  memcpy( &val, p, size );
+  if( !_zBinFileEndianIsSame( bf ) )
+    _zBinFileEndianReverseArray( &val, size, 1 );
+  switch( size ){
+  case 2: return val.i16;
+  case 4: return val.i32;
+  case 8: return val.i64;
+  default: ;
+  }
+  return 0;
+}
+
+/* pointer to an array of integer values in a mapped binary file. */
+#define ZBINFILE_DEF_MAP_INT_ARRAY( type, Type ) \
+const type *zBinFileMap##Type##Array(zBinFileMap *map, size_t n){\
+  const byte *p;\
+  type *val;\
+  size_t i, size;\
+  if( ( size = map->bf._size_##type ) == sizeof(type) )\
+    return (const type *)_zBinFileMapArray( map, size, n );\
+  if( !_zBinFileMapHas( map, size, n ) ||\
+      !( val = (type *)_zBinFileMapTmp( map, sizeof(type)*n ) ) ) return NULL;\
+  for( p=map->_buf+map->_cur, i=0; i<n; i++, p+=size )\
+    val[i] = _zBinFileMapInt( &map->bf, p, size );\
+  map->_cur += size*n;\
+  return val;\
+}
+
+ZBINFILE_DEF_MAP_INT_ARRAY( int, Int )
+ZBINFILE_DEF_MAP_INT_ARRAY( long, Long )
+
+const float *zBinFileMapFloatArray(zBinFileMap *map, size_t n){
+  return (const float *)_zBinFileMapArray( map, sizeof(float), n );
+}
+
+const double *zBinFileMapDoubleArray(zBinFileMap *map, size_t n){
+  return (const double *)_zBinFileMapArray( map, sizeof(double), n );
 }
@@ -6,6 +6,10 @@
 
 #include <zeda/zeda_bit.h>
 
+#ifdef __ZEDA_USE_PTHREAD
+#include <pthread.h>
+#endif /* __ZEDA_USE_PTHREAD */
+
 /* check type of endian of the current architecture. */
 int endian_check(void)
 {
@@ -27,32 +31,158 @@ int endian_check(void)
   return Z_ENDIAN_UNKNOWN;
 }
 
+#define _endian_reverse16(v) ( ( (v) << 8 & 0xff00 ) | ( (v) >> 8 & 0xff ) )
+
+#define _endian_reverse32(v) \
+  ( ( (v) << 24 & 0xff000000 ) |\
+    ( (v) <<  8 & 0x00ff0000 ) |\
+    ( (v) >>  8 & 0x0000ff00 ) |\
+    ( (v) >> 24 & 0x000000ff ) )
+
+#define _endian_reverse64(v) \
+  ( ( (v) << 56 & 0xff00000000000000 ) |\
+    ( (v) << 40 & 0x00ff000000000000 ) |\
+    ( (v) << 24 & 0x0000ff0000000000 ) |\
+    ( (v) <<  8 & 0x000000ff00000000 ) |\
+    ( (v) >>  8 & 0x00000000ff000000 ) |\
+    ( (v) >> 24 & 0x0000000000ff0000 ) |\
+    ( (v) >> 40 & 0x000000000000ff00 ) |\
+    ( (v) >> 56 & 0x00000000000000ff ) )
+
 /* convert 16-bit little/bit endian to/from big/little endian. */
 uint16_t endian_reverse16(uint16_t val)
 {
-  return ( val << 8 & 0xff00 ) | ( val >> 8 & 0xff );
+  return _endian_reverse16( val );
 }
 
 /* convert 32-bit little/bit endian to/from big/little endian. */
 uint32_t endian_reverse32(uint32_t val)
 {
-  return ( val << 24 & 0xff000000 ) |
-         ( val <<  8 & 0x00ff0000 ) |
-         ( val >>  8 & 0x0000ff00 ) |
-         ( val >> 24 & 0x000000ff );
+  return _endian_reverse32( val );
 }
 
 /* convert 64-bit little/bit endian to/from big/little endian. */
 uint64_t endian_reverse64(uint64_t val)
 {
-  return ( val << 56 & 0xff00000000000000 ) |
-         ( val << 40 & 0x00ff000000000000 ) |
-         ( val << 24 & 0x0000ff0000000000 ) |
-         ( val <<  8 & 0x000000ff00000000 ) |
-         ( val >>  8 & 0x00000000ff000000 ) |
-         ( val >> 24 & 0x0000000000ff0000 ) |
-         ( val >> 40 & 0x000000000000ff00 ) |
-         ( val >> 56 & 0x00000000000000ff );
+  return _endian_reverse64( val );
+}
+
+/* the following loops are simple enough for compilers to vectorize
+ * them with byte-shuffle instructions. */
+
+/* convert an array of 16-bit little/big endian values to big/little endian. */
+void endian_reverse16_array(void *buf, size_t n)
+{
+  uint16_t *p;
+  size_t i;
+
+  for( p=(uint16_t *)buf, i=0; i<n; i++ ) p[i] = _endian_reverse16( p[i] );
+}
+
+/* convert an array of 32-bit little/big endian values to big/little endian. */
+void endian_reverse32_array(void *buf, size_t n)
+{
+  uint32_t *p;
+  size_t i;
+
+  for( p=(uint32_t *)buf, i=0; i<n; i++ ) p[i] = _endian_reverse32( p[i] );
+}
+
+/* convert an array of 64-bit little/big endian values to big/little endian. */
+void endian_reverse64_array(void *buf, size_t n)
+{
+  uint64_t *p;
+  size_t i;
+
+  for( p=(uint64_t *)buf, i=0; i<n; i++ ) p[i] = _endian_reverse64( p[i] );
+}
+
+/* CRC-32C (Castagnoli) checksum */
+
+#define CRC32C_POLY 0x82f63b78U
+
+static uint32_t _crc32c_table[8][256];
+
+/* create slicing-by-8 tables. */
+static void _crc32c_table_init(void)
+{
+  uint32_t c;
+  int i, j;
+
+  for( i=0; i<256; i++ ){
+    for( c=i, j=0; j<8; j++ )
+      c = c & 1 ? ( c >> 1 ) ^ CRC32C_POLY : c >> 1;
+    _crc32c_table[0][i] = c;
+  }
+  for( i=0; i<256; i++ )
+    for( j=1; j<8; j++ )
+      _crc32c_table[j][i] = ( _crc32c_table[j-1][i] >> 8 ) ^ _crc32c_table[0][_crc32c_table[j-1][i] & 0xff];
+}
+
+/* CRC-32C with slicing-by-8 tables. */
+static uint32_t _crc32c_sw(uint32_t crc, const uint8_t *p, size_t size)
+{
+  uint32_t lo, hi;
+
+  for( ; size>=8; size-=8, p+=8 ){
+    lo = crc ^ ( (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24 );
+    hi = (uint32_t)p[4] | (uint32_t)p[5] << 8 | (uint32_t)p[6] << 16 | (uint32_t)p[7] << 24;
+    crc = _crc32c_table[7][lo & 0xff] ^ _crc32c_table[6][lo >> 8 & 0xff] ^
+          _crc32c_table[5][lo >> 16 & 0xff] ^ _crc32c_table[4][lo >> 24] ^
+          _crc32c_table[3][hi & 0xff] ^ _crc32c_table[2][hi >> 8 & 0xff] ^
+          _crc32c_table[1][hi >> 16 & 0xff] ^ _crc32c_table[0][hi >> 24];
+  }
+  for( ; size>0; size-- )
+    crc = ( crc >> 8 ) ^ _crc32c_table[0][( crc ^ *p++ ) & 0xff];
+  return crc;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define __ZEDA_CRC32C_SSE42
+/* CRC-32C with the SSE4.2 crc32 instruction. */
+__attribute__((target("sse4.2")))
+static uint32_t _crc32c_sse42(uint32_t crc, const uint8_t *p, size_t size)
+{
+  uint64_t c, v;
+
+  for( ; size>0 && ( (size_t)p & 7 ); size-- )
+    crc = __builtin_ia32_crc32qi( crc, *p++ );
+  for( c=crc; size>=8; size-=8, p+=8 ){
+    memcpy( &v, p, sizeof(uint64_t) );
+    c = __builtin_ia32_crc32di( c, v );
+  }
+  for( crc=(uint32_t)c; size>0; size-- )
+    crc = __builtin_ia32_crc32qi( crc, *p++ );
+  return crc;
+}
+#endif /* __ZEDA_CRC32C_SSE42 */
+
+static uint32_t (* _crc32c_func)(uint32_t, const uint8_t *, size_t) = NULL;
+
+/* choose an implementation of CRC-32C. */
+static void _crc32c_select(void)
+{
+#ifdef __ZEDA_CRC32C_SSE42
+  __builtin_cpu_init();
+  if( __builtin_cpu_supports( "sse4.2" ) ){
+    _crc32c_func = _crc32c_sse42;
+    return;
+  }
+#endif /* __ZEDA_CRC32C_SSE42 */
+  _crc32c_table_init();
+  _crc32c_func = _crc32c_sw;
+}
+
+/* update CRC-32C checksum. */
+uint32_t crc32c(uint32_t crc, const void *buf, size_t size)
+{
+#ifdef __ZEDA_USE_PTHREAD
+  static pthread_once_t once = PTHREAD_ONCE_INIT;
+  pthread_once( &once, _crc32c_select );
+#else
+  if( !_crc32c_func ) _crc32c_select();
+#endif /* __ZEDA_USE_PTHREAD */
+  return ~_crc32c_func( ~crc, (const uint8_t *)buf, size );
 }
 
 /* rotate a bit sequence. */
@@ -4,7 +4,19 @@
  * CSV file operations.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <zeda/zeda_csv.h>
+#include <sys/stat.h>
+#include <limits.h>
+
+#ifdef __ZEDA_USE_PTHREAD
+#include <pthread.h>
+#endif /* __ZEDA_USE_PTHREAD */
+
+#ifndef __WINDOWS__
+#include <sys/mman.h>
+#endif /* __WINDOWS__ */
 
 #ifndef __KERNEL__
 
@@ -18,14 +30,108 @@ char *zCSVGetLine(zCSV *csv)
   return ret;
 }
 
+/* get the next line of a CSV file skipping comments. */
+static char *_zCSVNextLine(zCSV *csv)
+{
+  while( zCSVGetLine( csv ) )
+    if( csv->buf[0] != '\%' ) return csv->buf;
+  return NULL;
+}
+
+/* size of a chunk to scan lines at once. */
+#define ZCSV_SCANBUFSIZ ( BUFSIZ * 8 )
+
+/* maximum byte size of a variable-length delta. */
+#define ZCSV_VARINT_MAX 10
+
+/* encode a variable-length delta. */
+static ubyte *_zCSVVarintEncode(ubyte *p, ulong val)
+{
+  for( ; val >= 0x80; val >>= 7 )
+    *p++ = (ubyte)( ( val & 0x7f ) | 0x80 );
+  *p++ = (ubyte)val;
+  return p;
+}
+
+/* decode a variable-length delta not to exceed the end of deltas. */
+static ulong _zCSVVarintDecode(ubyte **p, ubyte *end)
+{
+  ulong val = 0;
+  int shift;
+
+  for( shift=0; *p<end && shift<(int)sizeof(ulong)*8; shift+=7 ){
+    val |= (ulong)( **p & 0x7f ) << shift;
+    if( !( *(*p)++ & 0x80 ) ) break;
+  }
+  return val;
+}
+
+/* number of anchors of a sparse line index. */
+static int _zCSVAnchorNum(zCSV *csv)
+{
+  int nc;
+
+  nc = ( csv->nl + csv->stride - 1 ) / csv->stride;
+  return ( nc + ZCSV_ANCHOR_NUM - 1 ) / ZCSV_ANCHOR_NUM;
+}
+
+/* starting position of the k-th checkpoint of a sparse line index. */
+static long _zCSVCheckPoint(zCSV *csv, int k)
+{
+  ubyte *dp;
+  long pos;
+  int i;
+
+  pos = csv->pos[k/ZCSV_ANCHOR_NUM];
+  dp = csv->delta + csv->deltapos[k/ZCSV_ANCHOR_NUM];
+  for( i=k%ZCSV_ANCHOR_NUM; i>0; i-- )
+    pos += _zCSVVarintDecode( &dp, csv->delta + csv->deltasize );
+  return pos;
+}
+
+/* find the starting position of the n-th line after a line beginning at pos.
+ * the lines are scanned by chunk, and a newline is found by memchr(),
+ * which is vectorized in most of the standard C libraries. */
+static long _zCSVScanLine(FILE *fp, long pos, int n)
+{
+  char buf[ZCSV_SCANBUFSIZ], *p, *end;
+  size_t len;
+  bool bol = false;
+
+  if( n == 0 ) return pos;
+  fseek( fp, pos, SEEK_SET );
+  while( ( len = fread( buf, 1, ZCSV_SCANBUFSIZ, fp ) ) > 0 ){
+    for( p=buf, end=buf+len; p<end; ){
+      if( bol ){
+        if( *p != '\%' && --n == 0 ) return pos + ( p - buf );
+        bol = false;
+      }
+      if( !( p = (char *)memchr( p, '\n', end - p ) ) ) break;
+      p++;
+      bol = true;
+    }
+    pos += len;
+  }
+  return -1;
+}
+
 /* go to a specified line in a CSV file. */
 char *zCSVGoToLine(zCSV *csv, int i)
 {
+  long pos;
+
   if( i >= zCSVLineNum(csv) ){
     ZRUNERROR( ZEDA_ERR_CSV_INVALID_LINE, i );
     return NULL;
   }
-  fseek( csv->fp, csv->pos[i], SEEK_SET );
+  if( zCSVIsSparse(csv) ){
+    if( ( pos = _zCSVScanLine( csv->fp, _zCSVCheckPoint( csv, i / csv->stride ), i % csv->stride ) ) < 0 ){
+      ZRUNERROR( ZEDA_ERR_CSV_INVALID );
+      return NULL;
+    }
+  } else
+    pos = csv->pos[i];
+  fseek( csv->fp, pos, SEEK_SET );
   return zCSVGetLine( csv );
 }
 
@@ -104,7 +210,7 @@ bool zCSVGetDoubleN(zCSV *csv, double val[], int n)
 /* rewind the stream of a CSV file. */
 void zCSVRewind(zCSV *csv)
 {
-  fseek( csv->fp, csv->pos[0], SEEK_SET );
+  fseek( csv->fp, csv->pos && zCSVLineNum(csv) > 0 ? csv->pos[0] : 0, SEEK_SET ); /* no index for an empty file */
 }
 
 /* count the number of fields per line. */
@@ -112,20 +218,43 @@ static int _zCSVCountField(zCSV *csv)
 {
   char field[BUFSIZ];
 
+  if( zCSVLineNum(csv) == 0 ) return csv->nf = 0;
   zCSVRewind( csv );
+  zCSVGetLine( csv );
   for( csv->nf=0; !zCSVLineIsEmpty(csv); csv->nf++ )
     zCSVGetField( csv, field, BUFSIZ );
   zCSVRewind( csv );
   return csv->nf;
 }
 
+/* open a CSV file without indexing. */
+static zCSV *_zCSVFOpen(zCSV *csv, char filename[], int stride)
+{
+  if( !( csv->fp = zOpenFile( filename, (char *)"csv", (char *)"rt" ) ) )
+    return NULL;
+  csv->nl = csv->nf = 0;
+  csv->pos = NULL;
+  csv->stride = stride;
+  csv->delta = NULL;
+  csv->deltapos = NULL;
+  csv->deltasize = 0;
+  return csv;
+}
+
+/* finish opening a CSV file. */
+static zCSV *_zCSVOpenFinish(zCSV *csv)
+{
+  _zCSVCountField( csv );
+  memset( csv->buf, 0, BUFSIZ ); /* clear internal buffer */
+  return csv;
+}
+
 /* open a CSV file. */
 zCSV *zCSVOpen(zCSV *csv, char filename[])
 {
   int i;
 
-  if( !( csv->fp = zOpenFile( filename, (char *)"csv", (char *)"rt" ) ) )
-    return NULL;
+  if( !_zCSVFOpen( csv, filename, 1 ) ) return NULL;
   for( csv->nl=0; fgets( csv->buf, BUFSIZ, csv->fp ); )
     if( csv->buf[0] != '\%' ) csv->nl++;
   if( !( csv->pos = zAlloc( long, csv->nl ) ) ){
@@ -141,17 +270,1190 @@ zCSV *zCSVOpen(zCSV *csv, char filename[])
     }
     if( csv->buf[0] != '\%' ) i++;
   }
-  _zCSVCountField( csv );
-  memset( csv->buf, 0, BUFSIZ ); /* clear internal buffer */
+  return _zCSVOpenFinish( csv );
+}
+
+/* add a checkpoint to a sparse line index. */
+static bool _zCSVIndexAddCheckPoint(zCSV *csv, int k, long pos, long *prev, size_t *cap_a, size_t *cap_d)
+{
+  size_t a;
+  long *pp;
+  size_t *dpp;
+  ubyte *dp;
+
+  if( k % ZCSV_ANCHOR_NUM == 0 ){
+    if( ( a = k / ZCSV_ANCHOR_NUM ) >= *cap_a ){
+      *cap_a = *cap_a == 0 ? 16 : *cap_a * 2;
+      if( !( pp = zRealloc( csv->pos, long, *cap_a ) ) ||
+          ( csv->pos = pp, !( dpp = zRealloc( csv->deltapos, size_t, *cap_a ) ) ) ){
+        ZALLOCERROR();
+        return false;
+      }
+      csv->deltapos = dpp;
+    }
+    csv->pos[a] = pos;
+    csv->deltapos[a] = csv->deltasize;
+  } else{
+    if( csv->deltasize + ZCSV_VARINT_MAX > *cap_d ){
+      *cap_d = *cap_d == 0 ? BUFSIZ : *cap_d * 2;
+      if( !( dp = zRealloc( csv->delta, ubyte, *cap_d ) ) ){
+        ZALLOCERROR();
+        return false;
+      }
+      csv->delta = dp;
+    }
+    csv->deltasize = _zCSVVarintEncode( csv->delta + csv->deltasize, pos - *prev ) - csv->delta;
+  }
+  *prev = pos;
+  return true;
+}
+
+/* scan a CSV file and build a sparse line index. */
+static zCSV *_zCSVIndexBuild(zCSV *csv)
+{
+  char buf[ZCSV_SCANBUFSIZ], *p, *end;
+  size_t len, cap_a = 0, cap_d = 0;
+  long pos = 0, prev = 0;
+  bool bol = true;
+
+  csv->nl = 0;
+  csv->deltasize = 0;
+  rewind( csv->fp );
+  while( ( len = fread( buf, 1, ZCSV_SCANBUFSIZ, csv->fp ) ) > 0 ){
+    for( p=buf, end=buf+len; p<end; ){
+      if( bol ){
+        if( *p != '\%' ){
+          if( csv->nl % csv->stride == 0 &&
+              !_zCSVIndexAddCheckPoint( csv, csv->nl / csv->stride, pos + ( p - buf ), &prev, &cap_a, &cap_d ) )
+            return NULL;
+          csv->nl++;
+        }
+        bol = false;
+      }
+      if( !( p = (char *)memchr( p, '\n', end - p ) ) ) break;
+      p++;
+      bol = true;
+    }
+    pos += len;
+  }
   return csv;
 }
 
+/* open a CSV file with a sparse line index. */
+zCSV *zCSVOpenSparse(zCSV *csv, char filename[], int stride)
+{
+  if( stride <= 1 ) return zCSVOpen( csv, filename );
+  if( !_zCSVFOpen( csv, filename, stride ) ) return NULL;
+  if( !_zCSVIndexBuild( csv ) ){
+    zCSVClose( csv );
+    return NULL;
+  }
+  return _zCSVOpenFinish( csv );
+}
+
+/* size and modification time of a file, which tell if it is updated. */
+static bool _zCSVFileStamp(FILE *fp, int64_t *size, int64_t *mtime)
+{
+  struct stat st;
+
+  if( fstat( fileno( fp ), &st ) != 0 ) return false;
+  *size = st.st_size;
+#ifdef st_mtime /* timestamp in nanoseconds (POSIX.1-2008) */
+  *mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#else
+  *mtime = (int64_t)st.st_mtime * 1000000000;
+#endif /* st_mtime */
+  return true;
+}
+
+/* identifier of a sidecar file of a CSV line index. */
+#define ZCSV_INDEX_ID "CSVI"
+
+/* save the line index of a CSV file to a sidecar file. */
+bool zCSVIndexSave(zCSV *csv, char idxfile[])
+{
+  zBinFile bf;
+  int64_t size, mtime;
+  int i, na;
+  size_t k;
+
+  if( !zCSVIsSparse(csv) ){
+    ZRUNWARN( ZEDA_WARN_CSV_NOT_SPARSE );
+    return false;
+  }
+  if( !_zCSVFileStamp( csv->fp, &size, &mtime ) ) return false;
+  if( !zBinFileOpen( &bf, idxfile, "wb" ) ) return false;
+  zBinFileInfoSetThis( &bf );
+  zBinFileHeaderFWrite( &bf );
+  for( i=0; ZCSV_INDEX_ID[i]; i++ )
+    zBinFileByteFWrite( &bf, ZCSV_INDEX_ID[i] );
+  bf._fwrite_int64( &bf, &size );
+  bf._fwrite_int64( &bf, &mtime );
+  zBinFileIntFWrite( &bf, csv->nl );
+  zBinFileIntFWrite( &bf, csv->stride );
+  zBinFileLongFWrite( &bf, (long)csv->deltasize );
+  na = _zCSVAnchorNum( csv );
+  for( i=0; i<na; i++ ){
+    zBinFileLongFWrite( &bf, csv->pos[i] );
+    zBinFileLongFWrite( &bf, (long)csv->deltapos[i] );
+  }
+  for( k=0; k<csv->deltasize; k++ )
+    zBinFileByteFWrite( &bf, csv->delta[k] );
+  return zBinFileClose( &bf ) == 0;
+}
+
+/* check if a loaded line index is consistent with a CSV file of a given size. */
+static bool _zCSVIndexIsValid(zCSV *csv, int64_t size)
+{
+  ubyte *dp, *end;
+  long pos = -1;
+  ulong delta;
+  int nc, i, k;
+
+  nc = ( csv->nl + csv->stride - 1 ) / csv->stride;
+  dp = csv->delta;
+  end = csv->delta + csv->deltasize;
+  for( k=0; k<nc; k++ ){
+    if( k % ZCSV_ANCHOR_NUM == 0 ){ /* anchors are increasing and followed by their deltas */
+      i = k / ZCSV_ANCHOR_NUM;
+      if( csv->pos[i] <= pos || csv->deltapos[i] != (size_t)( dp - csv->delta ) ) return false;
+      pos = csv->pos[i];
+    } else{
+      if( dp >= end || ( delta = _zCSVVarintDecode( &dp, end ) ) == 0 || delta >= (ulong)( size - pos ) )
+        return false;
+      pos += delta;
+    }
+    if( pos >= size ) return false;
+  }
+  return dp == end;
+}
+
+/* load the line index of a CSV file from a sidecar file. */
+static bool _zCSVIndexLoad(zCSV *csv, char idxfile[])
+{
+  zBinFile bf;
+  FILE *fp;
+  int64_t size, mtime, val;
+  long deltasize, deltapos;
+  int i, na;
+  size_t k;
+  bool ret = false;
+
+  if( !_zCSVFileStamp( csv->fp, &size, &mtime ) ) return false;
+  if( !( fp = fopen( idxfile, "rb" ) ) ) return false;
+  zBinFileInit( &bf, fp );
+  if( !zBinFileHeaderFRead( &bf ) ) goto TERMINATE;
+  for( i=0; ZCSV_INDEX_ID[i]; i++ )
+    if( zBinFileByteFRead( &bf ) != ZCSV_INDEX_ID[i] ) goto TERMINATE;
+  /* the CSV file is supposed to be modified if either size or time differs */
+  if( bf._fread_int64( &bf, &val ) < 1 || val != size ||
+      bf._fread_int64( &bf, &val ) < 1 || val != mtime ) goto TERMINATE;
+  csv->nl = zBinFileIntFRead( &bf );
+  csv->stride = zBinFileIntFRead( &bf );
+  deltasize = zBinFileLongFRead( &bf );
+  /* every delta between checkpoints takes one to ZCSV_VARINT_MAX bytes */
+  if( csv->nl < 0 || csv->stride <= 1 || csv->stride > INT_MAX - csv->nl ||
+      deltasize < 0 || (size_t)deltasize > zFileSize( fp ) ||
+      deltasize / ZCSV_VARINT_MAX > csv->nl / csv->stride + 1 ) goto TERMINATE;
+  csv->deltasize = deltasize;
+  na = _zCSVAnchorNum( csv );
+  if( ( na > 0 && ( !( csv->pos = zAlloc( long, na ) ) || !( csv->deltapos = zAlloc( size_t, na ) ) ) ) ||
+      ( csv->deltasize > 0 && !( csv->delta = zAlloc( ubyte, csv->deltasize ) ) ) ){
+    ZALLOCERROR();
+    goto TERMINATE;
+  }
+  for( i=0; i<na; i++ ){
+    csv->pos[i] = zBinFileLongFRead( &bf );
+    if( ( deltapos = zBinFileLongFRead( &bf ) ) < 0 ) goto TERMINATE;
+    csv->deltapos[i] = deltapos;
+  }
+  for( k=0; k<csv->deltasize; k++ )
+    csv->delta[k] = zBinFileByteFRead( &bf );
+  ret = !feof( bf._fp ) && _zCSVIndexIsValid( csv, size );
+ TERMINATE:
+  zBinFileClose( &bf );
+  if( !ret ){
+    zFree( csv->pos );
+    zFree( csv->deltapos );
+    zFree( csv->delta );
+    csv->deltasize = 0;
+  }
+  return ret;
+}
+
+/* open a CSV file with a saved line index. */
+zCSV *zCSVOpenIndex(zCSV *csv, char filename[], char idxfile[])
+{
+  if( !_zCSVFOpen( csv, filename, ZCSV_DEFAULT_STRIDE ) ) return NULL;
+  if( !_zCSVIndexLoad( csv, idxfile ) ){
+    ZRUNWARN( ZEDA_WARN_CSV_INDEX_REBUILT, idxfile );
+    csv->stride = ZCSV_DEFAULT_STRIDE;
+    if( !_zCSVIndexBuild( csv ) ){
+      zCSVClose( csv );
+      return NULL;
+    }
+  }
+  return _zCSVOpenFinish( csv );
+}
+
 /* close a CSV file. */
 void zCSVClose(zCSV *csv)
 {
-  free( csv->pos );
+  zFree( csv->pos );
+  zFree( csv->delta );
+  zFree( csv->deltapos );
   fclose( csv->fp );
   csv->nl = csv->nf = 0;
 }
 
+/* ********************************************************** */
+/* buffered CSV writer
+ * ********************************************************** */
+
+/* maximum length of a formatted number. */
+#define ZCSV_NUM_MAX 32
+
+#ifdef __ZEDA_USE_PTHREAD
+/* background flusher of a CSV writer. */
+typedef struct{
+  FILE *fp;
+  char *buf;   /* spare buffer to be flushed */
+  size_t len;  /* length of data to be flushed (zero if idle) */
+  bool quit;
+  bool error;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} _zCSVFlusher;
+
+/* thread body of a background flusher. */
+static void *_zCSVFlusherRun(void *arg)
+{
+  _zCSVFlusher *fl;
+  bool error;
+
+  fl = (_zCSVFlusher *)arg;
+  pthread_mutex_lock( &fl->mutex );
+  while( 1 ){
+    while( fl->len == 0 && !fl->quit )
+      pthread_cond_wait( &fl->cond, &fl->mutex );
+    if( fl->len == 0 ) break;
+    pthread_mutex_unlock( &fl->mutex );
+    error = fwrite( fl->buf, 1, fl->len, fl->fp ) < fl->len;
+    pthread_mutex_lock( &fl->mutex );
+    if( error ) fl->error = true;
+    fl->len = 0;
+    pthread_cond_broadcast( &fl->cond );
+  }
+  pthread_mutex_unlock( &fl->mutex );
+  return NULL;
+}
+
+/* wait for a background flusher to be idle. */
+static bool _zCSVFlusherWait(_zCSVFlusher *fl)
+{
+  bool ret;
+
+  pthread_mutex_lock( &fl->mutex );
+  while( fl->len > 0 )
+    pthread_cond_wait( &fl->cond, &fl->mutex );
+  ret = !fl->error;
+  pthread_mutex_unlock( &fl->mutex );
+  return ret;
+}
+
+/* hand the output buffer of a CSV writer to a background flusher. */
+static bool _zCSVFlusherPost(zCSVWriter *w)
+{
+  _zCSVFlusher *fl;
+  char *buf;
+  bool ret;
+
+  fl = (_zCSVFlusher *)w->_flusher;
+  pthread_mutex_lock( &fl->mutex );
+  while( fl->len > 0 )
+    pthread_cond_wait( &fl->cond, &fl->mutex );
+  buf = fl->buf;
+  fl->buf = w->buf;
+  fl->len = w->len;
+  ret = !fl->error;
+  pthread_cond_broadcast( &fl->cond );
+  pthread_mutex_unlock( &fl->mutex );
+  w->buf = buf;
+  w->len = 0;
+  return ret;
+}
+
+/* create a background flusher of a CSV writer. */
+static bool _zCSVFlusherCreate(zCSVWriter *w)
+{
+  _zCSVFlusher *fl;
+
+  if( !( fl = zAlloc( _zCSVFlusher, 1 ) ) || !( fl->buf = zAlloc( char, w->size ) ) ){
+    ZALLOCERROR();
+    free( fl );
+    return false;
+  }
+  fl->fp = w->fp;
+  fl->len = 0;
+  fl->quit = fl->error = false;
+  pthread_mutex_init( &fl->mutex, NULL );
+  pthread_cond_init( &fl->cond, NULL );
+  if( pthread_create( &fl->thread, NULL, _zCSVFlusherRun, fl ) != 0 ){
+    ZRUNERROR( ZEDA_ERR_THREAD_CREATE );
+    pthread_mutex_destroy( &fl->mutex );
+    pthread_cond_destroy( &fl->cond );
+    free( fl->buf );
+    free( fl );
+    return false;
+  }
+  w->_flusher = fl;
+  return true;
+}
+
+/* terminate a background flusher of a CSV writer. */
+static void _zCSVFlusherDestroy(zCSVWriter *w)
+{
+  _zCSVFlusher *fl;
+
+  if( !( fl = (_zCSVFlusher *)w->_flusher ) ) return;
+  pthread_mutex_lock( &fl->mutex );
+  fl->quit = true;
+  pthread_cond_broadcast( &fl->cond );
+  pthread_mutex_unlock( &fl->mutex );
+  pthread_join( fl->thread, NULL );
+  pthread_mutex_destroy( &fl->mutex );
+  pthread_cond_destroy( &fl->cond );
+  free( fl->buf );
+  free( fl );
+  w->_flusher = NULL;
+}
+#endif /* __ZEDA_USE_PTHREAD */
+
+/* open a CSV file to be written. */
+zCSVWriter *zCSVWriterOpen(zCSVWriter *w, char filename[], size_t size)
+{
+  w->_flusher = NULL;
+  w->size = size > ZCSV_NUM_MAX ? size : ZCSV_WRITER_DEFAULT_BUFSIZ;
+  w->len = 0;
+  w->bol = true;
+  if( !( w->buf = zAlloc( char, w->size ) ) ){
+    ZALLOCERROR();
+    return NULL;
+  }
+  if( !( w->fp = fopen( filename, "w" ) ) ){
+    ZOPENERROR( filename );
+    zFree( w->buf );
+    return NULL;
+  }
+  return w;
+}
+
+/* open a CSV file to be written with a background flusher. */
+zCSVWriter *zCSVWriterOpenAsync(zCSVWriter *w, char filename[], size_t size)
+{
+  if( !zCSVWriterOpen( w, filename, size ) ) return NULL;
+#ifdef __ZEDA_USE_PTHREAD
+  if( !_zCSVFlusherCreate( w ) ){
+    zCSVWriterClose( w );
+    return NULL;
+  }
+#endif /* __ZEDA_USE_PTHREAD */
+  return w;
+}
+
+/* write out the output buffer of a CSV writer. */
+static bool _zCSVWriterDrain(zCSVWriter *w)
+{
+  size_t len;
+
+  if( w->len == 0 ) return true;
+#ifdef __ZEDA_USE_PTHREAD
+  if( w->_flusher ) return _zCSVFlusherPost( w );
+#endif /* __ZEDA_USE_PTHREAD */
+  len = w->len;
+  w->len = 0;
+  return fwrite( w->buf, 1, len, w->fp ) == len;
+}
+
+/* flush the output buffer of a CSV writer. */
+bool zCSVWriterFlush(zCSVWriter *w)
+{
+  bool ret;
+
+  ret = _zCSVWriterDrain( w );
+#ifdef __ZEDA_USE_PTHREAD
+  if( w->_flusher && !_zCSVFlusherWait( (_zCSVFlusher *)w->_flusher ) ) ret = false;
+#endif /* __ZEDA_USE_PTHREAD */
+  return fflush( w->fp ) == 0 && ret;
+}
+
+/* close a CSV file to be written. */
+void zCSVWriterClose(zCSVWriter *w)
+{
+  zCSVWriterFlush( w );
+#ifdef __ZEDA_USE_PTHREAD
+  _zCSVFlusherDestroy( w );
+#endif /* __ZEDA_USE_PTHREAD */
+  fclose( w->fp );
+  zFree( w->buf );
+  w->size = w->len = 0;
+}
+
+/* reserve a space in the output buffer of a CSV writer for a field. */
+static char *_zCSVWriterReserve(zCSVWriter *w, size_t len)
+{
+  if( w->len + len + 1 > w->size && !_zCSVWriterDrain( w ) ) return NULL;
+  if( w->bol )
+    w->bol = false;
+  else
+    w->buf[w->len++] = ',';
+  return w->buf + w->len;
+}
+
+/* format a long integer value. */
+static size_t _zCSVLongFormat(char *buf, long val)
+{
+  char tmp[ZCSV_NUM_MAX], *p;
+  ulong u;
+  size_t len;
+
+  p = tmp + ZCSV_NUM_MAX;
+  u = val < 0 ? -(ulong)val : (ulong)val;
+  do{
+    *--p = '0' + u % 10;
+  } while( ( u /= 10 ) > 0 );
+  if( val < 0 ) *--p = '-';
+  memcpy( buf, p, ( len = tmp + ZCSV_NUM_MAX - p ) );
+  return len;
+}
+
+/* format a double-precision floating-point value in the shortest
+ * string that is read back to the same value. */
+static size_t _zCSVDoubleFormat(char *buf, double val)
+{
+  int prec;
+  size_t len;
+
+  if( val > -1.0e15 && val < 1.0e15 && val >= LONG_MIN && val <= LONG_MAX && val == (double)(long)val ){
+    if( val == 0 && 1.0 / val < 0 ){ /* negative zero */
+      memcpy( buf, "-0", 2 );
+      return 2;
+    }
+    return _zCSVLongFormat( buf, (long)val );
+  }
+  /* a value of up to 15 digits is always printed back by %.15g */
+  for( prec=15; prec<17; prec++ ){
+    len = sprintf( buf, "%.*g", prec, val );
+    if( strtod( buf, NULL ) == val ) return len;
+  }
+  return sprintf( buf, "%.17g", val );
+}
+
+/* put a field to a CSV file. */
+bool zCSVWriterPutField(zCSVWriter *w, const char *field)
+{
+  size_t len;
+  char *p;
+
+  len = strlen( field );
+  if( len + 1 < w->size ){
+    if( !( p = _zCSVWriterReserve( w, len ) ) ) return false;
+    memcpy( p, field, len );
+    w->len += len;
+    return true;
+  }
+  /* too long field to be buffered */
+  if( !( p = _zCSVWriterReserve( w, 0 ) ) || !_zCSVWriterDrain( w ) ) return false;
+#ifdef __ZEDA_USE_PTHREAD
+  if( w->_flusher && !_zCSVFlusherWait( (_zCSVFlusher *)w->_flusher ) ) return false;
+#endif /* __ZEDA_USE_PTHREAD */
+  return fwrite( field, 1, len, w->fp ) == len;
+}
+
+/* put an integer value to a CSV file. */
+bool zCSVWriterPutInt(zCSVWriter *w, int val)
+{
+  return zCSVWriterPutLong( w, val );
+}
+
+/* put a long integer value to a CSV file. */
+bool zCSVWriterPutLong(zCSVWriter *w, long val)
+{
+  char *p;
+
+  if( !( p = _zCSVWriterReserve( w, ZCSV_NUM_MAX ) ) ) return false;
+  w->len += _zCSVLongFormat( p, val );
+  return true;
+}
+
+/* put a double-precision floating-point value to a CSV file. */
+bool zCSVWriterPutDouble(zCSVWriter *w, double val)
+{
+  char *p;
+
+  if( !( p = _zCSVWriterReserve( w, ZCSV_NUM_MAX ) ) ) return false;
+  w->len += _zCSVDoubleFormat( p, val );
+  return true;
+}
+
+/* terminate the current line of a CSV file. */
+bool zCSVWriterEndLine(zCSVWriter *w)
+{
+  if( w->len + 1 > w->size && !_zCSVWriterDrain( w ) ) return false;
+  w->buf[w->len++] = '\n';
+  w->bol = true;
+  return true;
+}
+
+/* put a row of integer values to a CSV file. */
+bool zCSVWriterPutIntRow(zCSVWriter *w, int val[], int n)
+{
+  int i;
+
+  for( i=0; i<n; i++ )
+    if( !zCSVWriterPutLong( w, val[i] ) ) return false;
+  return zCSVWriterEndLine( w );
+}
+
+/* put a row of double-precision floating-point values to a CSV file. */
+bool zCSVWriterPutDoubleRow(zCSVWriter *w, double val[], int n)
+{
+  int i;
+
+  for( i=0; i<n; i++ )
+    if( !zCSVWriterPutDouble( w, val[i] ) ) return false;
+  return zCSVWriterEndLine( w );
+}
+
+/* put a batch of typed columns to a CSV file. */
+bool zCSVWriterPutColumns(zCSVWriter *w, int nrow, int ncol, zCSVColumn col[])
+{
+  int i, j;
+  bool ret = true;
+
+  for( i=0; i<nrow; i++ ){
+    for( j=0; j<ncol; j++ ){
+      switch( col[j].type ){
+      case ZCSV_TYPE_INT:    ret = zCSVWriterPutLong( w, ((int *)col[j].data)[i] ); break;
+      case ZCSV_TYPE_LONG:   ret = zCSVWriterPutLong( w, ((long *)col[j].data)[i] ); break;
+      case ZCSV_TYPE_DOUBLE: ret = zCSVWriterPutDouble( w, ((double *)col[j].data)[i] ); break;
+      case ZCSV_TYPE_INT64:  ret = zCSVWriterPutLong( w, ((int64_t *)col[j].data)[i] ); break;
+      default:
+        ZRUNERROR( ZEDA_ERR_CSV_INVALID_TYPE, col[j].type );
+        return false;
+      }
+      if( !ret ) return false;
+    }
+    if( !zCSVWriterEndLine( w ) ) return false;
+  }
+  return true;
+}
+
+/* ********************************************************** */
+/* column projection and row filtering
+ * ********************************************************** */
+
+/* initialize a projection of columns of a CSV file. */
+zCSVProjection *zCSVProjectionInit(zCSVProjection *proj)
+{
+  zArrayInit( &proj->col );
+  zArrayInit( &proj->filter );
+  proj->_maxcol = -1;
+  proj->_need = NULL;
+  proj->_field = NULL;
+  return proj;
+}
+
+/* update the set of columns needed by a projection. */
+static bool _zCSVProjectionUpdate(zCSVProjection *proj, int col)
+{
+  ubyte *need;
+  char **field;
+
+  if( col < 0 ){
+    ZRUNERROR( ZEDA_ERR_CSV_INVALID_COL, col );
+    return false;
+  }
+  if( col > proj->_maxcol ){
+    if( !( need = zRealloc( proj->_need, ubyte, col+1 ) ) ){
+      ZALLOCERROR();
+      return false;
+    }
+    memset( need + proj->_maxcol + 1, 0, col - proj->_maxcol );
+    proj->_need = need;
+    if( !( field = zRealloc( proj->_field, char*, col+1 ) ) ){
+      ZALLOCERROR();
+      return false;
+    }
+    proj->_field = field;
+    proj->_maxcol = col;
+  }
+  proj->_need[col] = 1;
+  return true;
+}
+
+/* add a column to a projection. */
+bool zCSVProjectionAddColumn(zCSVProjection *proj, int col)
+{
+  uint n;
+
+  if( !_zCSVProjectionUpdate( proj, col ) ) return false;
+  n = zArraySize(&proj->col);
+  zArrayAdd( &proj->col, int, &col );
+  return zArraySize(&proj->col) > n;
+}
+
+/* add a range filter to a projection. */
+bool zCSVProjectionAddFilter(zCSVProjection *proj, int col, double min, double max)
+{
+  zCSVFilter filter;
+  uint n;
+
+  if( !_zCSVProjectionUpdate( proj, col ) ) return false;
+  filter.col = col;
+  filter.min = min;
+  filter.max = max;
+  n = zArraySize(&proj->filter);
+  zArrayAdd( &proj->filter, zCSVFilter, &filter );
+  return zArraySize(&proj->filter) > n;
+}
+
+/* destroy a projection of columns of a CSV file. */
+void zCSVProjectionDestroy(zCSVProjection *proj)
+{
+  zArrayFree( &proj->col );
+  zArrayFree( &proj->filter );
+  zFree( proj->_need );
+  zFree( proj->_field );
+  proj->_maxcol = -1;
+}
+
+/* locate fields needed by a projection in a line.
+ * unneeded fields are skipped by memchr(), which is vectorized in
+ * most of the standard C libraries. */
+static void _zCSVProjectionSplit(zCSVProjection *proj, char *line)
+{
+  char *p, *end, *c;
+  int i;
+
+  end = line + strlen( line );
+  for( p=line, i=0; i<=proj->_maxcol; i++ ){
+    c = p < end ? (char *)memchr( p, ',', end - p ) : NULL;
+    if( proj->_need[i] ){
+      proj->_field[i] = p;
+      if( c ) *c = '\0';
+    }
+    p = c ? c + 1 : end;
+  }
+}
+
+/* check if a line passes all filters of a projection. */
+static bool _zCSVProjectionMatch(zCSVProjection *proj)
+{
+  zCSVFilter *filter;
+  double val;
+  uint i;
+
+  for( i=0; i<zArraySize(&proj->filter); i++ ){
+    filter = zArrayElemNC( &proj->filter, i );
+    val = strtod( proj->_field[filter->col], NULL );
+    if( val < filter->min || val > filter->max ) return false;
+  }
+  return true;
+}
+
+/* get projected values of the next row that passes filters. */
+bool zCSVGetProjectedRow(zCSV *csv, zCSVProjection *proj, double val[])
+{
+  uint i;
+
+  while( _zCSVNextLine( csv ) ){
+    _zCSVProjectionSplit( proj, csv->buf );
+    if( !_zCSVProjectionMatch( proj ) ) continue;
+    for( i=0; i<zArraySize(&proj->col); i++ )
+      val[i] = strtod( proj->_field[*zArrayElemNC(&proj->col,i)], NULL );
+    csv->buf[0] = '\0';
+    return true;
+  }
+  csv->buf[0] = '\0';
+  return false;
+}
+
+/* ********************************************************** */
+/* binary columnar cache of CSV file
+ * ********************************************************** */
+
+/* identifier of a binary columnar cache file. */
+#define ZCSV_CACHE_ID "CSVC"
+
+/* alignment of arrays in a binary columnar cache file. */
+#define ZCSV_CACHE_ALIGN 8
+
+/* number of meta data per column in the footer: type, offset of values,
+ * number of dictionary entries, offset of entries, offset and size of pool. */
+#define ZCSV_CACHE_META_NUM 6
+
+/* dictionary of strings */
+typedef struct{
+  char *pool;      /* string pool */
+  size_t poolsize; /* size of the string pool */
+  size_t poolcap;  /* capacity of the string pool */
+  int64_t *ofs;    /* offsets of entries in the string pool */
+  int n;           /* number of entries */
+  int cap;         /* capacity of offsets */
+  int *table;      /* hash table of codes */
+  int tablesize;   /* size of the hash table (power of two) */
+} _zCSVDict;
+
+/* hash value of a string (FNV-1a). */
+static ulong _zCSVStrHash(const char *str)
+{
+  ulong h = 2166136261UL;
+
+  for( ; *str; str++ )
+    h = ( h ^ (ubyte)*str ) * 16777619UL;
+  return h;
+}
+
+/* extend the hash table of a dictionary. */
+static bool _zCSVDictRehash(_zCSVDict *dict)
+{
+  int *table, i, size;
+  ulong h;
+
+  size = dict->tablesize == 0 ? 64 : dict->tablesize * 2;
+  if( !( table = zAlloc( int, size ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  for( i=0; i<size; i++ ) table[i] = -1;
+  for( i=0; i<dict->n; i++ ){
+    for( h=_zCSVStrHash(dict->pool+dict->ofs[i])&(size-1); table[h]>=0; h=(h+1)&(size-1) );
+    table[h] = i;
+  }
+  free( dict->table );
+  dict->table = table;
+  dict->tablesize = size;
+  return true;
+}
+
+/* find a string in a dictionary, or add it if not found, and return its code. */
+static int _zCSVDictCode(_zCSVDict *dict, const char *str)
+{
+  ulong h;
+  size_t len;
+  char *pool;
+  int64_t *ofs;
+
+  if( 2 * ( dict->n + 1 ) > dict->tablesize && !_zCSVDictRehash( dict ) ) return -1;
+  for( h=_zCSVStrHash(str)&(dict->tablesize-1); dict->table[h]>=0; h=(h+1)&(dict->tablesize-1) )
+    if( strcmp( dict->pool + dict->ofs[dict->table[h]], str ) == 0 ) return dict->table[h];
+  len = strlen( str ) + 1;
+  if( dict->poolsize + len > dict->poolcap ){
+    dict->poolcap = ( dict->poolsize + len ) * 2;
+    if( !( pool = zRealloc( dict->pool, char, dict->poolcap ) ) ){
+      ZALLOCERROR();
+      return -1;
+    }
+    dict->pool = pool;
+  }
+  if( dict->n >= dict->cap ){
+    dict->cap = dict->cap == 0 ? 16 : dict->cap * 2;
+    if( !( ofs = zRealloc( dict->ofs, int64_t, dict->cap ) ) ){
+      ZALLOCERROR();
+      return -1;
+    }
+    dict->ofs = ofs;
+  }
+  memcpy( dict->pool + dict->poolsize, str, len );
+  dict->ofs[dict->n] = dict->poolsize;
+  dict->poolsize += len;
+  dict->table[h] = dict->n;
+  return dict->n++;
+}
+
+/* free a dictionary of strings. */
+static void _zCSVDictFree(_zCSVDict *dict)
+{
+  free( dict->pool );
+  free( dict->ofs );
+  free( dict->table );
+}
+
+/* cut out the next field from a line in place. */
+static char *_zCSVNextField(char **p)
+{
+  char *field, *c;
+
+  field = *p;
+  if( ( c = strchr( field, ',' ) ) ){
+    *c = '\0';
+    *p = c + 1;
+  } else
+    *p = field + strlen( field );
+  return field;
+}
+
+/* type of a field. */
+static int _zCSVFieldType(char *field)
+{
+  char *end;
+
+  if( !*field ) return ZCSV_TYPE_INT64; /* empty field is compatible with any type */
+  strtol( field, &end, 10 );
+  if( !*end ) return ZCSV_TYPE_INT64;
+  strtod( field, &end );
+  if( !*end ) return ZCSV_TYPE_DOUBLE;
+  return ZCSV_TYPE_STRING;
+}
+
+/* byte size of a value of a column. */
+static size_t _zCSVCacheElemSize(int type)
+{
+  return type == ZCSV_TYPE_STRING ? sizeof(int32_t) : sizeof(int64_t);
+}
+
+/* write an array to a binary columnar cache file with a padding. */
+static bool _zCSVCacheWriteArray(FILE *fp, void *data, size_t size, size_t nmemb)
+{
+  long pad;
+
+  if( fwrite( data, size, nmemb, fp ) < nmemb ) return false;
+  for( pad=ftell(fp)%ZCSV_CACHE_ALIGN; pad>0 && pad<ZCSV_CACHE_ALIGN; pad++ )
+    fputc( 0, fp );
+  return !ferror( fp );
+}
+
+/* write a 64-bit integer value to a binary columnar cache file. */
+static void _zCSVCacheWriteInt64(zBinFile *bf, int64_t val)
+{
+  bf->_fwrite_int64( bf, &val );
+}
+
+/* read a 64-bit integer value from a binary columnar cache file. */
+static int64_t _zCSVCacheReadInt64(zBinFile *bf)
+{
+  int64_t val;
+
+  return bf->_fread_int64( bf, &val ) > 0 ? val : -1;
+}
+
+/* scan the types of columns of a CSV file. */
+static void _zCSVCacheScanType(zCSV *csv, int type[])
+{
+  char *p, *field;
+  int i, j, t;
+
+  for( j=0; j<csv->nf; j++ ) type[j] = ZCSV_TYPE_INT64;
+  zCSVRewind( csv );
+  for( i=0; i<csv->nl && ( p = _zCSVNextLine( csv ) ); i++ )
+    for( j=0; j<csv->nf; j++ ){
+      t = _zCSVFieldType( ( field = _zCSVNextField( &p ) ) );
+      if( t == ZCSV_TYPE_STRING || ( t == ZCSV_TYPE_DOUBLE && type[j] == ZCSV_TYPE_INT64 ) )
+        type[j] = t;
+    }
+}
+
+/* fill the columns of a CSV file. */
+static bool _zCSVCacheFill(zCSV *csv, int type[], void *data[], _zCSVDict dict[])
+{
+  char *p, *field;
+  int i, j, code;
+
+  zCSVRewind( csv );
+  for( i=0; i<csv->nl; i++ ){
+    if( !( p = _zCSVNextLine( csv ) ) ){
+      ZRUNERROR( ZEDA_ERR_CSV_INVALID );
+      return false;
+    }
+    for( j=0; j<csv->nf; j++ ){
+      field = _zCSVNextField( &p );
+      switch( type[j] ){
+      case ZCSV_TYPE_INT64:  ((int64_t *)data[j])[i] = strtol( field, NULL, 10 ); break;
+      case ZCSV_TYPE_DOUBLE: ((double *)data[j])[i] = strtod( field, NULL ); break;
+      default:
+        if( ( code = _zCSVDictCode( &dict[j], field ) ) < 0 ) return false;
+        ((int32_t *)data[j])[i] = code;
+      }
+    }
+  }
+  return true;
+}
+
+/* write columns of a CSV file to a binary columnar cache file. */
+static bool _zCSVCacheWrite(zCSV *csv, char filename[], int type[], void *data[], _zCSVDict dict[])
+{
+  zBinFile bf;
+  int64_t *meta, footer, size, mtime;
+  int i, j;
+  bool ret = false;
+
+  if( !_zCSVFileStamp( csv->fp, &size, &mtime ) ) return false;
+  if( !( meta = zAllocZero( int64_t, csv->nf*ZCSV_CACHE_META_NUM+1 ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  if( !zBinFileOpen( &bf, filename, "wb" ) ) goto TERMINATE;
+  zBinFileInfoSetThis( &bf );
+  zBinFileHeaderFWrite( &bf );
+  if( !_zCSVCacheWriteArray( bf._fp, (void *)ZCSV_CACHE_ID, 1, strlen(ZCSV_CACHE_ID) ) ) goto TERMINATE;
+  for( j=0; j<csv->nf; j++ ){
+    meta[j*ZCSV_CACHE_META_NUM  ] = type[j];
+    meta[j*ZCSV_CACHE_META_NUM+1] = ftell( bf._fp );
+    if( !_zCSVCacheWriteArray( bf._fp, data[j], _zCSVCacheElemSize(type[j]), csv->nl ) ) goto TERMINATE;
+    if( type[j] != ZCSV_TYPE_STRING ) continue;
+    meta[j*ZCSV_CACHE_META_NUM+2] = dict[j].n;
+    meta[j*ZCSV_CACHE_META_NUM+3] = ftell( bf._fp );
+    if( !_zCSVCacheWriteArray( bf._fp, dict[j].ofs, sizeof(int64_t), dict[j].n ) ) goto TERMINATE;
+    meta[j*ZCSV_CACHE_META_NUM+4] = ftell( bf._fp );
+    meta[j*ZCSV_CACHE_META_NUM+5] = dict[j].poolsize;
+    if( !_zCSVCacheWriteArray( bf._fp, dict[j].pool, 1, dict[j].poolsize ) ) goto TERMINATE;
+  }
+  /* footer */
+  footer = ftell( bf._fp );
+  _zCSVCacheWriteInt64( &bf, size );
+  _zCSVCacheWriteInt64( &bf, mtime );
+  _zCSVCacheWriteInt64( &bf, csv->nl );
+  _zCSVCacheWriteInt64( &bf, csv->nf );
+  for( i=0; i<csv->nf*ZCSV_CACHE_META_NUM; i++ )
+    _zCSVCacheWriteInt64( &bf, meta[i] );
+  _zCSVCacheWriteInt64( &bf, footer );
+  ret = !ferror( bf._fp );
+ TERMINATE:
+  if( bf._fp && zBinFileClose( &bf ) != 0 ) ret = false;
+  free( meta );
+  return ret;
+}
+
+/* convert a CSV file to a binary columnar cache file. */
+bool zCSVCacheCreate(zCSV *csv, char filename[])
+{
+  int *type, j;
+  void **data;
+  _zCSVDict *dict;
+  bool ret = false;
+
+  type = zAlloc( int, csv->nf );
+  data = zAlloc( void*, csv->nf );
+  dict = zAllocZero( _zCSVDict, csv->nf );
+  if( csv->nf > 0 && ( !type || !data || !dict ) ){
+    ZALLOCERROR();
+    goto TERMINATE;
+  }
+  _zCSVCacheScanType( csv, type );
+  for( j=0; j<csv->nf; j++ )
+    if( csv->nl > 0 && !( data[j] = calloc( csv->nl, _zCSVCacheElemSize(type[j]) ) ) ){
+      ZALLOCERROR();
+      goto TERMINATE;
+    }
+  ret = _zCSVCacheFill( csv, type, data, dict ) &&
+        _zCSVCacheWrite( csv, filename, type, data, dict );
+ TERMINATE:
+  for( j=0; j<csv->nf; j++ ){
+    if( data ) free( data[j] );
+    if( dict ) _zCSVDictFree( &dict[j] );
+  }
+  free( type );
+  free( data );
+  free( dict );
+  zCSVRewind( csv );
+  memset( csv->buf, 0, BUFSIZ );
+  return ret;
+}
+
+/* read the whole of a binary columnar cache file into the memory. */
+static bool _zCSVCacheReadAll(zCSVCache *cache, FILE *fp)
+{
+  if( !( cache->_buf = zAlloc( byte, cache->_size ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  rewind( fp );
+  cache->_mapped = false;
+  return fread( cache->_buf, 1, cache->_size, fp ) == cache->_size;
+}
+
+/* map a binary columnar cache file to the memory. */
+static bool _zCSVCacheMap(zCSVCache *cache, FILE *fp)
+{
+#ifndef __WINDOWS__
+  void *map;
+
+  if( cache->_size == 0 ||
+      ( map = mmap( NULL, cache->_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno( fp ), 0 ) ) == MAP_FAILED )
+    return false;
+  cache->_buf = (byte *)map;
+  cache->_mapped = true;
+  return true;
+#else
+  return false;
+#endif /* __WINDOWS__ */
+}
+
+/* check if a region is within a binary columnar cache file. */
+#define _zCSVCacheRegionIsValid(ofs,size,limit) ( (ofs) >= 0 && (ofs) % ZCSV_CACHE_ALIGN == 0 && (ofs) + (int64_t)(size) <= (limit) )
+
+/* read the footer of a binary columnar cache file. */
+static int64_t *_zCSVCacheReadFooter(zCSVCache *cache, zBinFile *bf)
+{
+  int64_t footer, nrow, ncol, *meta, *m;
+  int i, j;
+
+  if( cache->_size < sizeof(int64_t) ) return NULL;
+  fseek( bf->_fp, cache->_size - sizeof(int64_t), SEEK_SET );
+  footer = _zCSVCacheReadInt64( bf );
+  if( footer < 0 || footer > (int64_t)cache->_size ) return NULL;
+  fseek( bf->_fp, footer, SEEK_SET );
+  cache->_srcsize = _zCSVCacheReadInt64( bf );
+  cache->_srcmtime = _zCSVCacheReadInt64( bf );
+  nrow = _zCSVCacheReadInt64( bf );
+  ncol = _zCSVCacheReadInt64( bf );
+  /* every row has at least a 4-byte cell in every column, and every column has its meta in the footer */
+  if( nrow < 0 || nrow > INT_MAX || ncol < 0 || ncol > INT_MAX ||
+      ( ncol > 0 && nrow > footer / ( (int64_t)sizeof(int32_t) * ncol ) ) ||
+      ncol > ( (int64_t)cache->_size - footer ) / ( (int64_t)sizeof(int64_t)*ZCSV_CACHE_META_NUM ) ||
+      footer + (int64_t)sizeof(int64_t)*( ncol*ZCSV_CACHE_META_NUM + 5 ) != (int64_t)cache->_size )
+    return NULL;
+  cache->nrow = nrow;
+  cache->ncol = ncol;
+  if( !( meta = zAlloc( int64_t, cache->ncol*ZCSV_CACHE_META_NUM+1 ) ) ){
+    ZALLOCERROR();
+    return NULL;
+  }
+  for( i=0; i<cache->ncol*ZCSV_CACHE_META_NUM; i++ )
+    meta[i] = _zCSVCacheReadInt64( bf );
+  for( j=0; j<cache->ncol; j++ ){
+    m = meta + j*ZCSV_CACHE_META_NUM;
+    if( ( m[0] != ZCSV_TYPE_INT64 && m[0] != ZCSV_TYPE_DOUBLE && m[0] != ZCSV_TYPE_STRING ) ||
+        !_zCSVCacheRegionIsValid( m[1], _zCSVCacheElemSize(m[0])*cache->nrow, footer ) ||
+        ( m[0] == ZCSV_TYPE_STRING &&
+          ( m[2] < 0 || m[2] > INT_MAX || !_zCSVCacheRegionIsValid( m[3], sizeof(int64_t)*m[2], footer ) ||
+            m[5] < 0 || !_zCSVCacheRegionIsValid( m[4], m[5], footer ) ||
+            ( m[2] > 0 && m[5] == 0 ) ) ) ){
+      free( meta );
+      return NULL;
+    }
+  }
+  return meta;
+}
+
+/* check if codes and a dictionary of a string column are within the string pool. */
+static bool _zCSVCacheDictIsValid(zCSVCacheColumn *col, int nrow, int64_t poolsize)
+{
+  int i;
+
+  if( col->ndict > 0 && col->dictpool[poolsize-1] != '\0' ) return false;
+  for( i=0; i<col->ndict; i++ )
+    if( col->dictofs[i] < 0 || col->dictofs[i] >= poolsize ) return false;
+  for( i=0; i<nrow; i++ )
+    if( ((int32_t *)col->data)[i] < 0 || ((int32_t *)col->data)[i] >= col->ndict ) return false;
+  return true;
+}
+
+/* load a binary columnar cache file. */
+zCSVCache *zCSVCacheLoad(zCSVCache *cache, char filename[])
+{
+  zBinFile bf;
+  int64_t *meta = NULL, *m;
+  int i, j;
+  bool swap;
+
+  cache->nrow = cache->ncol = 0;
+  cache->col = NULL;
+  cache->_buf = NULL;
+  cache->_mapped = false;
+  if( !zBinFileOpen( &bf, filename, "rb" ) ) return NULL;
+  if( !zBinFileHeaderFRead( &bf ) ) goto FAILURE;
+  for( i=0; ZCSV_CACHE_ID[i]; i++ )
+    if( zBinFileByteFRead( &bf ) != ZCSV_CACHE_ID[i] ) goto FAILURE;
+  cache->_size = zFileSize( bf._fp );
+  if( !( meta = _zCSVCacheReadFooter( cache, &bf ) ) ) goto FAILURE;
+  if( cache->ncol > 0 && !( cache->col = zAlloc( zCSVCacheColumn, cache->ncol ) ) ){
+    ZALLOCERROR();
+    goto FAILURE;
+  }
+  swap = bf._endian_type != endian_check();
+  if( ( swap || !_zCSVCacheMap( cache, bf._fp ) ) && !_zCSVCacheReadAll( cache, bf._fp ) )
+    goto FAILURE;
+  for( j=0; j<cache->ncol; j++ ){
+    m = meta + j*ZCSV_CACHE_META_NUM;
+    cache->col[j].type = m[0];
+    cache->col[j].data = cache->_buf + m[1];
+    cache->col[j].ndict = 0;
+    cache->col[j].dictofs = NULL;
+    cache->col[j].dictpool = NULL;
+    if( m[0] == ZCSV_TYPE_STRING ){
+      cache->col[j].ndict = m[2];
+      cache->col[j].dictofs = (int64_t *)( cache->_buf + m[3] );
+      cache->col[j].dictpool = (char *)( cache->_buf + m[4] );
+    }
+    if( swap ){
+      if( m[0] == ZCSV_TYPE_STRING ){
+        endian_reverse32_array( cache->col[j].data, cache->nrow );
+        endian_reverse64_array( cache->col[j].dictofs, cache->col[j].ndict );
+      } else
+        endian_reverse64_array( cache->col[j].data, cache->nrow );
+    }
+    if( m[0] == ZCSV_TYPE_STRING && !_zCSVCacheDictIsValid( &cache->col[j], cache->nrow, m[5] ) )
+      goto FAILURE;
+  }
+  free( meta );
+  zBinFileClose( &bf );
+  return cache;
+
+ FAILURE:
+  ZRUNERROR( ZEDA_ERR_CSV_INVALID_CACHE, filename );
+  free( meta );
+  zBinFileClose( &bf );
+  zCSVCacheClose( cache );
+  return NULL;
+}
+
+/* open a CSV file via its binary columnar cache. */
+zCSVCache *zCSVCacheOpen(zCSVCache *cache, char csvfile[], char cachefile[])
+{
+  zCSV csv;
+  FILE *fp;
+  int64_t size, mtime;
+  bool ret;
+
+  /* only the size and the modification time of the CSV file are checked */
+  if( !( fp = fopen( csvfile, "r" ) ) ){
+    ZOPENERROR( csvfile );
+    return NULL;
+  }
+  ret = _zCSVFileStamp( fp, &size, &mtime );
+  fclose( fp );
+  if( ret && ( fp = fopen( cachefile, "rb" ) ) ){
+    fclose( fp );
+    if( zCSVCacheLoad( cache, cachefile ) ){
+      if( cache->_srcsize == size && cache->_srcmtime == mtime ) return cache;
+      zCSVCacheClose( cache );
+    }
+  }
+  /* parse the CSV file only to rebuild the cache */
+  if( !zCSVOpenSparse( &csv, csvfile, ZCSV_DEFAULT_STRIDE ) ) return NULL;
+  ret = zCSVCacheCreate( &csv, cachefile );
+  zCSVClose( &csv );
+  return ret ? zCSVCacheLoad( cache, cachefile ) : NULL;
+}
+
+/* close a binary columnar cache of a CSV file. */
+void zCSVCacheClose(zCSVCache *cache)
+{
+  if( cache->_buf ){
+#ifndef __WINDOWS__
+    if( cache->_mapped )
+      munmap( cache->_buf, cache->_size );
+    else
+#endif /* __WINDOWS__ */
+      free( cache->_buf );
+  }
+  zFree( cache->col );
+  cache->_buf = NULL;
+  cache->_mapped = false;
+  cache->nrow = cache->ncol = 0;
+}
+
 #endif /* __KERNEL__ */
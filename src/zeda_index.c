@@ -161,6 +161,24 @@ zIndex zIndexCreateFromList(zIntList *list)
 }
 
 #ifndef __KERNEL__
+/* compare two integers for sorting. */
+static int _zIndexCmp(void *v1, void *v2, void *priv)
+{
+  return *(int *)v1 < *(int *)v2 ? -1 : *(int *)v1 > *(int *)v2 ? 1 : 0;
+}
+
+/* sort an integer vector by radix sort. */
+zIndex zIndexRadixSort(zIndex idx)
+{
+  switch( sizeof(int) ){
+  case 4: return zRadixSortInt32( (int32_t*)zArrayBuf(idx), zArraySize(idx) ) ? idx : NULL;
+  case 8: return zRadixSortInt64( (int64_t*)zArrayBuf(idx), zArraySize(idx) ) ? idx : NULL;
+  default: /* no radix sort for the size of int */
+    zQuickSort( zArrayBuf(idx), zArraySize(idx), sizeof(int), _zIndexCmp, NULL );
+  }
+  return idx;
+}
+
 /* scan an integer vector from a file. */
 zIndex zIndexFScan(FILE *fp)
 {
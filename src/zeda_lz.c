@@ -0,0 +1,130 @@
+/* ZEDA - Elementary Data and Algorithms
+ * Copyright (C) 1998 Tomomichi Sugihara (Zhidao)
+ *
+ * zeda_lz - LZ-style fast block compression.
+ */
+
+#include <zeda/zeda_lz.h>
+
+/* number of bits of the hash table. */
+#define ZLZ_HASH_BIT 12
+
+/* hash value of four bytes. */
+static uint _zLZHash(const ubyte *p)
+{
+  uint32_t v;
+
+  v = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+  return (uint)( ( v * 2654435761U ) >> ( 32 - ZLZ_HASH_BIT ) ) & ( ( 1 << ZLZ_HASH_BIT ) - 1 );
+}
+
+/* put an extended length. */
+static ubyte *_zLZPutLen(ubyte *op, ubyte *oend, size_t len)
+{
+  for( ; len>=0xff; len-=0xff ){
+    if( op >= oend ) return NULL;
+    *op++ = 0xff;
+  }
+  if( op >= oend ) return NULL;
+  *op++ = (ubyte)len;
+  return op;
+}
+
+/* put a sequence of literals and a match. */
+static ubyte *_zLZPutSequence(ubyte *op, ubyte *oend, const ubyte *lit, size_t litlen, size_t offset, size_t matchlen)
+{
+  ubyte *token;
+
+  if( op >= oend ) return NULL;
+  token = op++;
+  *token = ( litlen < 0xf ? litlen : 0xf ) << 4;
+  if( litlen >= 0xf && !( op = _zLZPutLen( op, oend, litlen - 0xf ) ) ) return NULL;
+  if( litlen > (size_t)( oend - op ) ) return NULL;
+  memcpy( op, lit, litlen );
+  op += litlen;
+  if( matchlen == 0 ) return op; /* the last sequence */
+  if( oend - op < 2 ) return NULL;
+  *op++ = offset & 0xff;
+  *op++ = offset >> 8 & 0xff;
+  matchlen -= ZLZ_MINMATCH;
+  *token |= matchlen < 0xf ? matchlen : 0xf;
+  if( matchlen >= 0xf && !( op = _zLZPutLen( op, oend, matchlen - 0xf ) ) ) return NULL;
+  return op;
+}
+
+/* compress a block of data. */
+size_t zLZCompress(const void *src, size_t srcsize, void *dst, size_t dstsize)
+{
+  uint32_t table[1<<ZLZ_HASH_BIT];
+  const ubyte *base, *ip, *anchor, *iend, *ref;
+  ubyte *op, *oend;
+  size_t len;
+  uint h;
+
+  base = anchor = ip = (const ubyte *)src;
+  iend = base + srcsize;
+  op = (ubyte *)dst;
+  oend = op + dstsize;
+  memset( table, 0, sizeof(table) );
+  while( iend - ip >= ZLZ_MINMATCH ){
+    h = _zLZHash( ip );
+    ref = base + table[h];
+    table[h] = ip - base;
+    if( ref >= ip || ip - ref > ZLZ_MAXOFFSET || memcmp( ref, ip, ZLZ_MINMATCH ) != 0 ){
+      ip++;
+      continue;
+    }
+    for( len=ZLZ_MINMATCH; ip+len<iend && ref[len]==ip[len]; len++ );
+    if( !( op = _zLZPutSequence( op, oend, anchor, ip - anchor, ip - ref, len ) ) ) return 0;
+    anchor = ( ip += len );
+  }
+  if( !( op = _zLZPutSequence( op, oend, anchor, iend - anchor, 0, 0 ) ) ) return 0;
+  return op - (ubyte *)dst;
+}
+
+/* get an extended length. */
+static const ubyte *_zLZGetLen(const ubyte *ip, const ubyte *iend, size_t *len)
+{
+  do{
+    if( ip >= iend ) return NULL;
+    *len += *ip;
+  } while( *ip++ == 0xff );
+  return ip;
+}
+
+/* decompress a block of data. */
+size_t zLZDecompress(const void *src, size_t srcsize, void *dst, size_t dstsize)
+{
+  const ubyte *ip, *iend, *ref;
+  ubyte *op, *oend;
+  size_t len, offset;
+  ubyte token;
+
+  ip = (const ubyte *)src;
+  iend = ip + srcsize;
+  op = (ubyte *)dst;
+  oend = op + dstsize;
+  while( ip < iend ){
+    token = *ip++;
+    /* literals */
+    if( ( len = token >> 4 ) == 0xf && !( ip = _zLZGetLen( ip, iend, &len ) ) ) return 0;
+    if( len > (size_t)( iend - ip ) || len > (size_t)( oend - op ) ) return 0;
+    memcpy( op, ip, len );
+    op += len;
+    if( ( ip += len ) == iend ) break; /* the last sequence */
+    /* match */
+    if( iend - ip < 2 ) return 0;
+    offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+    ip += 2;
+    if( offset == 0 || offset > (size_t)( op - (ubyte *)dst ) ) return 0;
+    if( ( len = token & 0xf ) == 0xf && !( ip = _zLZGetLen( ip, iend, &len ) ) ) return 0;
+    if( ( len += ZLZ_MINMATCH ) > (size_t)( oend - op ) ) return 0;
+    ref = op - offset;
+    if( offset >= len ){
+      memcpy( op, ref, len );
+      op += len;
+    } else
+      while( len-- > 0 ) *op++ = *ref++;
+  }
+  return op - (ubyte *)dst;
+}
@@ -4,10 +4,27 @@
  * zeda_stream - generalized I/O stream.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <zeda/zeda_stream.h>
+#include <zeda/zeda_bit.h>
+#include <zeda/zeda_lz.h>
 
 #ifndef __KERNEL__
 
+#include <errno.h>
+
+#ifndef __WINDOWS__
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif /* __WINDOWS__ */
+
+#ifdef __ZEDA_USE_PTHREAD
+#include <pthread.h>
+#endif /* __ZEDA_USE_PTHREAD */
+
 /* abstracts of standard UNIX file */
 
 void zStreamRewindFile(zStream *str)
@@ -54,6 +71,8 @@ void zStreamAttachFile(zStream *str, FILE *fp)
   str->read   = zStreamReadFile;
   str->write  = zStreamWriteFile;
   str->close  = zStreamCloseFile;
+  str->_buf   = NULL;
+  str->_prefetch = NULL;
 }
 
 /* zStreamOpenFile
@@ -80,13 +99,14 @@ void zStreamRewindBuf(zStream *str)
 
 int zStreamSeekBuf(zStream *str, long offset)
 {
+  if( offset < 0 || offset > (long)str->src.mem.size ) return -1;
   str->src.mem.cur = str->src.mem.buf + offset;
-  return ( str->src.mem.cur - str->src.mem.buf ) > (int)str->src.mem.size ? -1 : 0;
+  return 0;
 }
 
 long zStreamTellBuf(zStream *str)
 {
-  return (long)str->src.mem.cur;
+  return (long)( str->src.mem.cur - str->src.mem.buf );
 }
 
 size_t zStreamReadBuf(zStream *str, byte *dest, size_t size, size_t nmemb)
@@ -98,19 +118,22 @@ size_t zStreamReadBuf(zStream *str, byte *dest, size_t size, size_t nmemb)
   if( ( rs = size * nmemb ) > rm ) rs = rm;
   memcpy( dest, str->src.mem.cur, rs );
   str->src.mem.cur += rs;
-  return rs;
+  return rs / size;
 }
 
 size_t zStreamWriteBuf(zStream *str, byte *src, size_t size, size_t nmemb)
 {
   size_t rs, rm;
 
+  if( size == 0 ) return 0;
   rm = str->src.mem.size - ( str->src.mem.cur - str->src.mem.buf );
-  if( rm <= 0 ) return 0;
-  if( ( rs = size * nmemb ) > rm ) rs = rm;
+  if( ( rs = size * nmemb ) > rm ){
+    ZRUNWARN( ZEDA_WARN_STREAM_FULL );
+    rs = rm - rm % size; /* only whole data cells are written */
+  }
   memcpy( str->src.mem.cur, src, rs );
   str->src.mem.cur += rs;
-  return rs;
+  return rs / size;
 }
 
 int zStreamCloseBuf(zStream *str)
@@ -126,7 +149,7 @@ void zStreamAttachMem(zStream *str, byte *mem, size_t size)
   /* stream source */
   str->src.mem.buf = mem;
   str->src.mem.cur = mem;
-  str->src.mem.size = size;
+  str->src.mem.size = str->src.mem.capacity = size;
   /* methods */
   str->rewind = zStreamRewindBuf;
   str->seek   = zStreamSeekBuf;
@@ -134,6 +157,8 @@ void zStreamAttachMem(zStream *str, byte *mem, size_t size)
   str->read   = zStreamReadBuf;
   str->write  = zStreamWriteBuf;
   str->close  = zStreamCloseBuf;
+  str->_buf   = NULL;
+  str->_prefetch = NULL;
 }
 
 /* zStreamOpenMem
@@ -143,12 +168,1348 @@ zStream *zStreamOpenMem(zStream *str, size_t size)
 {
   byte *buf;
 
-  if( !( buf = (byte *)calloc( size, 1 ) ) ){
+  if( !( buf = zAlloc( byte, size ) ) && size > 0 ){
+    ZALLOCERROR();
+    return NULL;
+  }
+  zStreamAttachMem( str, buf, size );
+  return str;
+}
+
+/* abstracts of memory-mapped file */
+
+size_t zStreamWriteReadOnly(zStream *str, byte *src, size_t size, size_t nmemb)
+{
+  return 0;
+}
+
+int zStreamCloseMmap(zStream *str)
+{
+#ifndef __WINDOWS__
+  return munmap( str->src.mem.buf, str->src.mem.size );
+#else
+  return 0;
+#endif /* __WINDOWS__ */
+}
+
+/* load the whole of a file into the memory, if it cannot be mapped. */
+static bool _zStreamMmapLoad(zStream *str, FILE *fp, size_t size)
+{
+  byte *buf;
+
+  if( !( buf = zAlloc( byte, size ) ) ){
     ZALLOCERROR();
-    return str;
+    return false;
+  }
+  rewind( fp );
+  if( fread( buf, 1, size, fp ) != size ){
+    free( buf );
+    return false;
   }
   zStreamAttachMem( str, buf, size );
+  return true;
+}
+
+/* zStreamOpenMmap
+ * - memory-mapping of a file and attachment to stream.
+ */
+zStream *zStreamOpenMmap(zStream *str, char filename[], char *mode, size_t size)
+{
+  FILE *fp;
+  bool rw, ret = false;
+#ifndef __WINDOWS__
+  void *buf;
+#endif /* __WINDOWS__ */
+
+  rw = strchr( mode, 'w' ) || strchr( mode, '+' );
+  if( !( fp = fopen( filename, !rw ? "rb" : strchr( mode, 'w' ) ? "w+b" : "r+b" ) ) ){
+    ZOPENERROR( filename );
+    return NULL;
+  }
+  if( !rw || size == 0 ) size = zFileSize( fp );
+  if( size == 0 ){ /* nothing to be mapped */
+    zStreamAttachMem( str, NULL, 0 );
+    ret = true;
+    goto TERMINATE;
+  }
+#ifndef __WINDOWS__
+  if( rw && ftruncate( fileno( fp ), size ) != 0 ){
+    ZRUNERROR( ZEDA_ERR_STREAM_MMAP_FAILED, filename );
+    goto TERMINATE;
+  }
+  if( ( buf = mmap( NULL, size, rw ? PROT_READ | PROT_WRITE : PROT_READ, rw ? MAP_SHARED : MAP_PRIVATE, fileno( fp ), 0 ) ) != MAP_FAILED ){
+    zStreamAttachMem( str, (byte *)buf, size );
+    str->close = zStreamCloseMmap;
+    ret = true;
+    goto TERMINATE;
+  }
+#endif /* __WINDOWS__ */
+  if( rw ){ /* writing back a loaded memory is not supported */
+    ZRUNERROR( ZEDA_ERR_STREAM_MMAP_FAILED, filename );
+    goto TERMINATE;
+  }
+  ret = _zStreamMmapLoad( str, fp, size );
+ TERMINATE:
+  fclose( fp );
+  if( ret && !rw ) str->write = zStreamWriteReadOnly;
+  return ret ? str : NULL;
+}
+
+/* read buffer */
+
+typedef struct{
+  byte *buf;        /* buffer, including a room for putback */
+  size_t size;      /* size of the buffer */
+  size_t cur, len;  /* current position and end of data in the buffer */
+  /* methods of the underlying source */
+  void (* rewind)(zStream *str);
+  int (* seek)(zStream *str, long offset);
+  long (* tell)(zStream *str);
+  size_t (* read)(zStream *str, byte *dest, size_t size, size_t nmemb);
+  size_t (* write)(zStream *str, byte *src, size_t size, size_t nmemb);
+  int (* close)(zStream *str);
+} _zStreamBuffer;
+
+#define _zStreamBuf(str) ( (_zStreamBuffer *)(str)->_buf )
+
+/* refill the buffer, keeping the last characters for putback. */
+static bool _zStreamBufferFill(zStream *str)
+{
+  _zStreamBuffer *sb;
+  size_t keep, n;
+
+  sb = _zStreamBuf( str );
+  keep = _zMin( sb->cur, ZSTREAM_PUTBACK );
+  memmove( sb->buf, sb->buf + sb->cur - keep, keep );
+  sb->cur = sb->len = keep;
+  n = sb->read( str, sb->buf + keep, 1, sb->size - keep );
+  sb->len += n;
+  return n > 0;
+}
+
+/* discard buffered data, moving the underlying source to the current position. */
+static void _zStreamBufferSync(zStream *str)
+{
+  _zStreamBuffer *sb;
+
+  sb = _zStreamBuf( str );
+  if( sb->cur < sb->len )
+    sb->seek( str, sb->tell( str ) - (long)( sb->len - sb->cur ) );
+  sb->cur = sb->len = 0;
+}
+
+static void _zStreamRewindBuffered(zStream *str)
+{
+  _zStreamBuf(str)->cur = _zStreamBuf(str)->len = 0;
+  _zStreamBuf(str)->rewind( str );
+}
+
+static int _zStreamSeekBuffered(zStream *str, long offset)
+{
+  _zStreamBuf(str)->cur = _zStreamBuf(str)->len = 0;
+  return _zStreamBuf(str)->seek( str, offset );
+}
+
+static long _zStreamTellBuffered(zStream *str)
+{
+  return _zStreamBuf(str)->tell( str ) - (long)( _zStreamBuf(str)->len - _zStreamBuf(str)->cur );
+}
+
+static size_t _zStreamReadBuffered(zStream *str, byte *dest, size_t size, size_t nmemb)
+{
+  _zStreamBuffer *sb;
+  size_t rest, m;
+
+  sb = _zStreamBuf( str );
+  if( size == 0 ) return 0;
+  for( rest=size*nmemb; rest>0; dest+=m, rest-=m ){
+    if( sb->cur == sb->len ){
+      if( rest >= sb->size / 2 ){ /* large read bypasses the buffer */
+        rest -= sb->read( str, dest, 1, rest );
+        break;
+      }
+      if( !_zStreamBufferFill( str ) ) break;
+    }
+    m = _zMin( rest, sb->len - sb->cur );
+    memcpy( dest, sb->buf + sb->cur, m );
+    sb->cur += m;
+  }
+  return ( size * nmemb - rest ) / size;
+}
+
+static size_t _zStreamWriteBuffered(zStream *str, byte *src, size_t size, size_t nmemb)
+{
+  _zStreamBufferSync( str );
+  return _zStreamBuf(str)->write( str, src, size, nmemb );
+}
+
+static int _zStreamCloseBuffered(zStream *str)
+{
+  int (* close)(zStream *);
+
+  close = _zStreamBuf(str)->close;
+  zStreamUnsetBuffer( str );
+  return close( str );
+}
+
+/* put a read buffer on a stream. */
+bool zStreamSetBuffer(zStream *str, size_t size)
+{
+  _zStreamBuffer *sb;
+
+  if( str->_buf ) return true;
+  if( size == 0 ) size = ZSTREAM_BUFSIZ;
+  if( !( sb = zAlloc( _zStreamBuffer, 1 ) ) ||
+      !( sb->buf = zAlloc( byte, size + ZSTREAM_PUTBACK ) ) ){
+    ZALLOCERROR();
+    free( sb );
+    return false;
+  }
+  sb->size = size + ZSTREAM_PUTBACK;
+  sb->cur = sb->len = 0;
+  sb->rewind = str->rewind; str->rewind = _zStreamRewindBuffered;
+  sb->seek   = str->seek;   str->seek   = _zStreamSeekBuffered;
+  sb->tell   = str->tell;   str->tell   = _zStreamTellBuffered;
+  sb->read   = str->read;   str->read   = _zStreamReadBuffered;
+  sb->write  = str->write;  str->write  = _zStreamWriteBuffered;
+  sb->close  = str->close;  str->close  = _zStreamCloseBuffered;
+  str->_buf = sb;
+  return true;
+}
+
+/* remove the read buffer from a stream. */
+void zStreamUnsetBuffer(zStream *str)
+{
+  _zStreamBuffer *sb;
+
+  if( !( sb = _zStreamBuf( str ) ) ) return;
+  _zStreamBufferSync( str );
+  str->rewind = sb->rewind;
+  str->seek   = sb->seek;
+  str->tell   = sb->tell;
+  str->read   = sb->read;
+  str->write  = sb->write;
+  str->close  = sb->close;
+  free( sb->buf );
+  zFree( str->_buf );
+}
+
+/* read a character from a stream. */
+int zStreamGetc(zStream *str)
+{
+  _zStreamBuffer *sb;
+
+  if( !( sb = _zStreamBuf( str ) ) ){
+    if( !zStreamSetBuffer( str, 0 ) ) return EOF;
+    sb = _zStreamBuf( str );
+  }
+  if( sb->cur == sb->len && !_zStreamBufferFill( str ) ) return EOF;
+  return (ubyte)sb->buf[sb->cur++];
+}
+
+/* peek the next character of a stream. */
+int zStreamPeek(zStream *str)
+{
+  int c;
+
+  if( ( c = zStreamGetc( str ) ) != EOF ) _zStreamBuf(str)->cur--;
+  return c;
+}
+
+/* push a character back to a stream. */
+int zStreamUngetc(zStream *str, int c)
+{
+  _zStreamBuffer *sb;
+
+  if( c == EOF || !( sb = _zStreamBuf( str ) ) ) return EOF;
+  if( sb->cur == 0 ){
+    if( sb->len >= sb->size ) return EOF;
+    memmove( sb->buf + 1, sb->buf, sb->len++ );
+    sb->cur++;
+  }
+  sb->buf[--sb->cur] = (byte)c;
+  return c;
+}
+
+static bool _zStreamIsMem(zStream *str);
+
+/* read-ahead prefetcher */
+
+#ifdef __ZEDA_USE_PTHREAD
+typedef struct{
+  byte **buf;       /* ring of buffers */
+  size_t *len;      /* sizes of data in buffers */
+  int nbuf;         /* number of buffers */
+  size_t size;      /* size of each buffer */
+  int head;         /* buffer to be filled next by the helper thread */
+  int tail;         /* buffer being consumed */
+  int fill;         /* number of filled buffers */
+  size_t cur;       /* current position in the consumed buffer */
+  bool hold;        /* whether the consumer holds a filled buffer */
+  long pos;         /* current position of the stream */
+  bool eof, stop, running;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond_fill, cond_empty;
+  /* methods of the underlying source */
+  void (* rewind)(zStream *str);
+  int (* seek)(zStream *str, long offset);
+  long (* tell)(zStream *str);
+  size_t (* read)(zStream *str, byte *dest, size_t size, size_t nmemb);
+  size_t (* write)(zStream *str, byte *src, size_t size, size_t nmemb);
+  int (* close)(zStream *str);
+} _zStreamPrefetcher;
+
+#define _zStreamPf(str) ( (_zStreamPrefetcher *)(str)->_prefetch )
+
+/* helper thread to fill buffers ahead of the consumer. */
+static void *_zStreamPrefetchThread(void *arg)
+{
+  zStream *str;
+  _zStreamPrefetcher *pf;
+  int i;
+  size_t n;
+
+  str = (zStream *)arg;
+  pf = _zStreamPf( str );
+  pthread_mutex_lock( &pf->mutex );
+  while( 1 ){
+    while( pf->fill == pf->nbuf && !pf->stop )
+      pthread_cond_wait( &pf->cond_empty, &pf->mutex );
+    if( pf->stop ) break;
+    i = pf->head;
+    pthread_mutex_unlock( &pf->mutex );
+    n = pf->read( str, pf->buf[i], 1, pf->size );
+    pthread_mutex_lock( &pf->mutex );
+    if( pf->stop ) break;
+    pf->len[i] = n;
+    pf->head = ( pf->head + 1 ) % pf->nbuf;
+    pf->fill++;
+    if( n < pf->size ) pf->eof = true;
+    pthread_cond_signal( &pf->cond_fill );
+    if( pf->eof ) break;
+  }
+  pthread_mutex_unlock( &pf->mutex );
+  return NULL;
+}
+
+/* start the helper thread from the current position of the underlying source. */
+static bool _zStreamPrefetchStart(zStream *str)
+{
+  _zStreamPrefetcher *pf;
+
+  pf = _zStreamPf( str );
+  pf->pos = pf->tell( str );
+  pf->head = pf->tail = pf->fill = 0;
+  pf->cur = 0;
+  pf->hold = pf->eof = pf->stop = false;
+  if( pthread_create( &pf->thread, NULL, _zStreamPrefetchThread, str ) != 0 ){
+    ZRUNERROR( ZEDA_ERR_THREAD_CREATE );
+    return ( pf->running = false );
+  }
+  return ( pf->running = true );
+}
+
+/* stop the helper thread, moving the underlying source to the current position. */
+static void _zStreamPrefetchStop(zStream *str)
+{
+  _zStreamPrefetcher *pf;
+
+  pf = _zStreamPf( str );
+  if( !pf->running ) return;
+  pthread_mutex_lock( &pf->mutex );
+  pf->stop = true;
+  pthread_cond_broadcast( &pf->cond_empty );
+  pthread_mutex_unlock( &pf->mutex );
+  pthread_join( pf->thread, NULL );
+  pf->running = false;
+  pf->seek( str, pf->pos );
+}
+
+static void _zStreamRewindPrefetched(zStream *str)
+{
+  _zStreamPrefetchStop( str );
+  _zStreamPf(str)->rewind( str );
+  _zStreamPrefetchStart( str );
+}
+
+static int _zStreamSeekPrefetched(zStream *str, long offset)
+{
+  int ret;
+
+  _zStreamPrefetchStop( str );
+  ret = _zStreamPf(str)->seek( str, offset );
+  _zStreamPrefetchStart( str );
+  return ret;
+}
+
+static long _zStreamTellPrefetched(zStream *str)
+{
+  return _zStreamPf(str)->running ? _zStreamPf(str)->pos : _zStreamPf(str)->tell( str );
+}
+
+static size_t _zStreamReadPrefetched(zStream *str, byte *dest, size_t size, size_t nmemb)
+{
+  _zStreamPrefetcher *pf;
+  size_t rest, m;
+
+  pf = _zStreamPf( str );
+  if( size == 0 ) return 0;
+  if( !pf->running ) return pf->read( str, dest, size, nmemb );
+  for( rest=size*nmemb; rest>0; dest+=m, rest-=m, pf->pos+=m ){
+    if( !pf->hold || pf->cur == pf->len[pf->tail] ){
+      pthread_mutex_lock( &pf->mutex );
+      if( pf->hold ){ /* release the consumed buffer */
+        pf->tail = ( pf->tail + 1 ) % pf->nbuf;
+        pf->fill--;
+        pf->cur = 0;
+        pthread_cond_signal( &pf->cond_empty );
+      }
+      while( pf->fill == 0 && !pf->eof )
+        pthread_cond_wait( &pf->cond_fill, &pf->mutex );
+      pf->hold = pf->fill > 0;
+      pthread_mutex_unlock( &pf->mutex );
+      if( !pf->hold ) break; /* end of the stream */
+      m = 0;
+      continue;
+    }
+    m = _zMin( rest, pf->len[pf->tail] - pf->cur );
+    memcpy( dest, pf->buf[pf->tail] + pf->cur, m );
+    pf->cur += m;
+  }
+  return ( size * nmemb - rest ) / size;
+}
+
+static size_t _zStreamWritePrefetched(zStream *str, byte *src, size_t size, size_t nmemb)
+{
+  size_t ret;
+
+  _zStreamPrefetchStop( str );
+  ret = _zStreamPf(str)->write( str, src, size, nmemb );
+  _zStreamPrefetchStart( str );
+  return ret;
+}
+
+static int _zStreamClosePrefetched(zStream *str)
+{
+  int (* close)(zStream *);
+
+  close = _zStreamPf(str)->close;
+  zStreamUnsetPrefetch( str );
+  return close( str );
+}
+
+/* destroy a prefetcher. */
+static void _zStreamPrefetcherDestroy(_zStreamPrefetcher *pf)
+{
+  int i;
+
+  if( pf->buf )
+    for( i=0; i<pf->nbuf; i++ ) free( pf->buf[i] );
+  free( pf->buf );
+  free( pf->len );
+  free( pf );
+}
+#endif /* __ZEDA_USE_PTHREAD */
+
+/* put a read-ahead prefetcher on a stream. */
+bool zStreamSetPrefetch(zStream *str, int nbuf, size_t size)
+{
+#ifdef __ZEDA_USE_PTHREAD
+  _zStreamPrefetcher *pf;
+  int i;
+#endif /* __ZEDA_USE_PTHREAD */
+
+  if( nbuf <= 1 ) nbuf = ZSTREAM_PREFETCH_NUM;
+  if( size == 0 ) size = ZSTREAM_PREFETCH_BUFSIZ;
+  if( str->_prefetch || _zStreamIsMem( str ) ) return true; /* nothing to be prefetched */
+  zStreamUnsetBuffer( str );
+#if defined(POSIX_FADV_SEQUENTIAL)
+  if( str->read == zStreamReadFile )
+    posix_fadvise( fileno( str->src.fp ), 0, 0, POSIX_FADV_SEQUENTIAL );
+#elif defined(F_RDAHEAD) /* no posix_fadvise() on macOS */
+  if( str->read == zStreamReadFile )
+    fcntl( fileno( str->src.fp ), F_RDAHEAD, 1 );
+#endif /* POSIX_FADV_SEQUENTIAL */
+#ifdef __ZEDA_USE_PTHREAD
+  if( !( pf = zAlloc( _zStreamPrefetcher, 1 ) ) ||
+      !( pf->buf = zAlloc( byte*, nbuf ) ) ||
+      !( pf->len = zAlloc( size_t, nbuf ) ) ) goto FAILURE;
+  pf->nbuf = nbuf;
+  pf->size = size;
+  for( i=0; i<nbuf; i++ )
+    if( !( pf->buf[i] = zAlloc( byte, size ) ) ) goto FAILURE;
+  pthread_mutex_init( &pf->mutex, NULL );
+  pthread_cond_init( &pf->cond_fill, NULL );
+  pthread_cond_init( &pf->cond_empty, NULL );
+  pf->rewind = str->rewind; str->rewind = _zStreamRewindPrefetched;
+  pf->seek   = str->seek;   str->seek   = _zStreamSeekPrefetched;
+  pf->tell   = str->tell;   str->tell   = _zStreamTellPrefetched;
+  pf->read   = str->read;   str->read   = _zStreamReadPrefetched;
+  pf->write  = str->write;  str->write  = _zStreamWritePrefetched;
+  pf->close  = str->close;  str->close  = _zStreamClosePrefetched;
+  str->_prefetch = pf;
+  if( !_zStreamPrefetchStart( str ) ){
+    zStreamUnsetPrefetch( str );
+    return false;
+  }
+  return true;
+
+ FAILURE:
+  ZALLOCERROR();
+  if( pf ) _zStreamPrefetcherDestroy( pf );
+  return false;
+#else
+  return zStreamSetBuffer( str, nbuf * size ); /* synchronous read in large chunks */
+#endif /* __ZEDA_USE_PTHREAD */
+}
+
+/* remove the read-ahead prefetcher from a stream. */
+void zStreamUnsetPrefetch(zStream *str)
+{
+#ifdef __ZEDA_USE_PTHREAD
+  _zStreamPrefetcher *pf;
+
+  if( !( pf = _zStreamPf( str ) ) ) return;
+  zStreamUnsetBuffer( str );
+  _zStreamPrefetchStop( str );
+  str->rewind = pf->rewind;
+  str->seek   = pf->seek;
+  str->tell   = pf->tell;
+  str->read   = pf->read;
+  str->write  = pf->write;
+  str->close  = pf->close;
+  pthread_mutex_destroy( &pf->mutex );
+  pthread_cond_destroy( &pf->cond_fill );
+  pthread_cond_destroy( &pf->cond_empty );
+  _zStreamPrefetcherDestroy( pf );
+  str->_prefetch = NULL;
+#else
+  zStreamUnsetBuffer( str );
+#endif /* __ZEDA_USE_PTHREAD */
+}
+
+/* zero-copy access */
+
+/* check if a stream is attached to a memory space. */
+static bool _zStreamIsMem(zStream *str)
+{
+  return ( str->_buf ? _zStreamBuf(str)->tell : str->tell ) == zStreamTellBuf;
+}
+
+/* check if a stream is a mapped file. */
+bool zStreamIsMapped(zStream *str)
+{
+  return ( str->_buf ? _zStreamBuf(str)->close : str->close ) == zStreamCloseMmap;
+}
+
+/* advise the access pattern of a mapped file. */
+bool zStreamAdvise(zStream *str, int advice)
+{
+#ifndef __WINDOWS__
+  static const int _advice[] = {
+    POSIX_MADV_NORMAL, POSIX_MADV_SEQUENTIAL, POSIX_MADV_RANDOM, POSIX_MADV_WILLNEED,
+  };
+
+  if( !zStreamIsMapped( str ) || advice < ZSTREAM_ADVICE_NORMAL || advice > ZSTREAM_ADVICE_WILLNEED )
+    return false;
+  return posix_madvise( str->src.mem.buf, str->src.mem.size, _advice[advice] ) == 0;
+#else
+  return false;
+#endif /* __WINDOWS__ */
+}
+
+/* view bytes at the current position of a stream without copying them. */
+const byte *zStreamView(zStream *str, size_t len)
+{
+  byte *p;
+
+  if( !_zStreamIsMem( str ) ) return NULL;
+  if( str->_buf ) _zStreamBufferSync( str );
+  if( len > str->src.mem.size - ( str->src.mem.cur - str->src.mem.buf ) ) return NULL;
+  p = str->src.mem.cur;
+  str->src.mem.cur += len;
+  return p;
+}
+
+/* abstracts of growable memory buffer */
+
+/* enlarge a growable memory buffer. */
+static bool _zStreamGrowBuf(zStream *str, size_t capacity)
+{
+  byte *buf;
+  size_t ofs;
+
+  if( capacity <= str->src.mem.capacity ) return true;
+  ofs = str->src.mem.cur - str->src.mem.buf;
+  if( !( buf = zRealloc( str->src.mem.buf, byte, capacity ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  str->src.mem.buf = buf;
+  str->src.mem.cur = buf + ofs;
+  str->src.mem.capacity = capacity;
+  return true;
+}
+
+size_t zStreamWriteGrowBuf(zStream *str, byte *src, size_t size, size_t nmemb)
+{
+  size_t rs, ofs, capacity;
+
+  if( ( rs = size * nmemb ) == 0 ) return 0;
+  ofs = str->src.mem.cur - str->src.mem.buf;
+  if( ofs + rs > str->src.mem.capacity ){
+    for( capacity=zMax(str->src.mem.capacity,ZSTREAM_MEM_MINSIZE); capacity<ofs+rs; capacity<<=1 );
+    if( !_zStreamGrowBuf( str, capacity ) ) return 0;
+  }
+  memcpy( str->src.mem.cur, src, rs );
+  str->src.mem.cur += rs;
+  if( ofs + rs > str->src.mem.size ) str->src.mem.size = ofs + rs;
+  return nmemb;
+}
+
+/* zStreamOpenGrowMem
+ * - growable memory allocation and attachment to stream.
+ */
+zStream *zStreamOpenGrowMem(zStream *str, size_t capacity)
+{
+  zStreamAttachMem( str, NULL, 0 );
+  str->write = zStreamWriteGrowBuf;
+  if( !_zStreamGrowBuf( str, capacity ) ) return NULL;
+  return str;
+}
+
+/* reserve a capacity of a growable memory stream. */
+bool zStreamReserve(zStream *str, size_t capacity)
+{
+  if( ( str->_buf ? _zStreamBuf(str)->write : str->write ) != zStreamWriteGrowBuf )
+    return capacity <= str->src.mem.size && _zStreamIsMem( str );
+  return _zStreamGrowBuf( str, capacity );
+}
+
+/* detach the memory buffer from a stream. */
+byte *zStreamDetachBuf(zStream *str, size_t *size)
+{
+  byte *buf;
+
+  if( !_zStreamIsMem( str ) || zStreamIsMapped( str ) ) return NULL;
+  zStreamUnsetBuffer( str );
+  buf = str->src.mem.buf;
+  if( size ) *size = str->src.mem.size;
+  str->src.mem.buf = str->src.mem.cur = NULL;
+  str->src.mem.size = str->src.mem.capacity = 0;
+  return buf;
+}
+
+/* batched asynchronous read */
+
+/* read a range of a file requested. */
+static void _zStreamAIORead(zStreamAIOReq *req)
+{
+  bool allocated = false;
+#ifndef __WINDOWS__
+  int fd;
+  struct stat st;
+  ssize_t n;
+#else
+  FILE *fp;
+  long filesize;
+#endif /* __WINDOWS__ */
+  size_t size;
+
+  req->len = 0;
+  req->error = 0;
+#ifndef __WINDOWS__
+  if( ( fd = open( req->filename, O_RDONLY ) ) < 0 ){
+    req->error = errno;
+    return;
+  }
+  if( ( size = req->size ) == 0 ){
+    if( fstat( fd, &st ) != 0 ){
+      req->error = errno;
+      goto TERMINATE;
+    }
+    size = st.st_size > req->offset ? st.st_size - req->offset : 0;
+  }
+#else
+  if( !( fp = fopen( req->filename, "rb" ) ) ){
+    req->error = errno;
+    return;
+  }
+  if( ( size = req->size ) == 0 ){
+    filesize = zFileSize( fp );
+    size = filesize > req->offset ? filesize - req->offset : 0;
+  }
+  if( fseek( fp, req->offset, SEEK_SET ) != 0 ){
+    req->error = errno;
+    goto TERMINATE;
+  }
+#endif /* __WINDOWS__ */
+  if( !req->buf && size > 0 ){
+    if( !( req->buf = zAlloc( byte, size ) ) ){
+      req->error = ENOMEM;
+      goto TERMINATE;
+    }
+    allocated = true;
+  }
+#ifndef __WINDOWS__
+  while( req->len < size ){
+    if( ( n = pread( fd, req->buf + req->len, size - req->len, req->offset + req->len ) ) < 0 ){
+      if( errno == EINTR ) continue;
+      req->error = errno;
+      break;
+    }
+    if( n == 0 ) break; /* end of file */
+    req->len += n;
+  }
+#else
+  req->len = fread( req->buf, 1, size, fp );
+  if( ferror( fp ) ) req->error = EIO;
+#endif /* __WINDOWS__ */
+  if( req->error != 0 && allocated ){
+    free( req->buf );
+    req->buf = NULL;
+    req->len = 0;
+  }
+ TERMINATE:
+#ifndef __WINDOWS__
+  close( fd );
+#else
+  fclose( fp );
+#endif /* __WINDOWS__ */
+}
+
+typedef struct{
+  zStreamAIOReq *sq_head, *sq_tail; /* submission queue */
+  zStreamAIOReq *cq_head, *cq_tail; /* completion queue */
+  int depth;        /* maximum number of requests in flight */
+  int inflight;     /* number of requests submitted and not reaped yet */
+#ifdef __ZEDA_USE_PTHREAD
+  int nthread;
+  bool stop;
+  pthread_t *thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond_submit, cond_complete;
+#endif /* __ZEDA_USE_PTHREAD */
+} _zStreamAIO;
+
+/* enqueue a request. */
+static void _zStreamAIOEnqueue(zStreamAIOReq **head, zStreamAIOReq **tail, zStreamAIOReq *req)
+{
+  req->_next = NULL;
+  if( *tail )
+    (*tail)->_next = req;
+  else
+    *head = req;
+  *tail = req;
+}
+
+/* dequeue a request. */
+static zStreamAIOReq *_zStreamAIODequeue(zStreamAIOReq **head, zStreamAIOReq **tail)
+{
+  zStreamAIOReq *req;
+
+  if( ( req = *head ) && !( *head = req->_next ) ) *tail = NULL;
+  return req;
+}
+
+#ifdef __ZEDA_USE_PTHREAD
+/* worker thread to serve submitted requests. */
+static void *_zStreamAIOThread(void *arg)
+{
+  _zStreamAIO *aio;
+  zStreamAIOReq *req;
+
+  aio = (_zStreamAIO *)arg;
+  pthread_mutex_lock( &aio->mutex );
+  while( 1 ){
+    while( !aio->sq_head && !aio->stop )
+      pthread_cond_wait( &aio->cond_submit, &aio->mutex );
+    if( !( req = _zStreamAIODequeue( &aio->sq_head, &aio->sq_tail ) ) ) break;
+    pthread_mutex_unlock( &aio->mutex );
+    _zStreamAIORead( req );
+    pthread_mutex_lock( &aio->mutex );
+    _zStreamAIOEnqueue( &aio->cq_head, &aio->cq_tail, req );
+    pthread_cond_signal( &aio->cond_complete );
+  }
+  pthread_mutex_unlock( &aio->mutex );
   return NULL;
 }
+#endif /* __ZEDA_USE_PTHREAD */
+
+/* initialize a batched asynchronous reader. */
+bool zStreamAIOInit(zStreamAIO *aio, int nthread, int depth)
+{
+  _zStreamAIO *a;
+
+  if( nthread <= 0 ) nthread = ZSTREAM_AIO_THREAD_NUM;
+  if( depth <= 0 ) depth = ZSTREAM_AIO_DEPTH;
+  if( !( a = zAlloc( _zStreamAIO, 1 ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  a->sq_head = a->sq_tail = a->cq_head = a->cq_tail = NULL;
+  a->depth = depth;
+  a->inflight = 0;
+#ifdef __ZEDA_USE_PTHREAD
+  if( !( a->thread = zAlloc( pthread_t, nthread ) ) ){
+    ZALLOCERROR();
+    free( a );
+    return false;
+  }
+  a->stop = false;
+  pthread_mutex_init( &a->mutex, NULL );
+  pthread_cond_init( &a->cond_submit, NULL );
+  pthread_cond_init( &a->cond_complete, NULL );
+  for( a->nthread=0; a->nthread<nthread; a->nthread++ )
+    if( pthread_create( &a->thread[a->nthread], NULL, _zStreamAIOThread, a ) != 0 ){
+      ZRUNERROR( ZEDA_ERR_THREAD_CREATE );
+      break;
+    }
+  aio->_aio = a;
+  if( a->nthread == 0 ){
+    zStreamAIODestroy( aio );
+    return false;
+  }
+#else
+  aio->_aio = a;
+#endif /* __ZEDA_USE_PTHREAD */
+  return true;
+}
+
+/* destroy a batched asynchronous reader. */
+void zStreamAIODestroy(zStreamAIO *aio)
+{
+  _zStreamAIO *a;
+#ifdef __ZEDA_USE_PTHREAD
+  int i;
+#endif /* __ZEDA_USE_PTHREAD */
+
+  if( !( a = (_zStreamAIO *)aio->_aio ) ) return;
+#ifdef __ZEDA_USE_PTHREAD
+  pthread_mutex_lock( &a->mutex );
+  a->stop = true;
+  pthread_cond_broadcast( &a->cond_submit );
+  pthread_mutex_unlock( &a->mutex );
+  for( i=0; i<a->nthread; i++ )
+    pthread_join( a->thread[i], NULL );
+  pthread_mutex_destroy( &a->mutex );
+  pthread_cond_destroy( &a->cond_submit );
+  pthread_cond_destroy( &a->cond_complete );
+  free( a->thread );
+#endif /* __ZEDA_USE_PTHREAD */
+  zFree( aio->_aio );
+}
+
+/* submit a read request to a batched asynchronous reader. */
+bool zStreamAIOSubmit(zStreamAIO *aio, zStreamAIOReq *req)
+{
+  _zStreamAIO *a;
+
+  a = (_zStreamAIO *)aio->_aio;
+#ifdef __ZEDA_USE_PTHREAD
+  pthread_mutex_lock( &a->mutex );
+  if( a->inflight >= a->depth ){ /* queue full */
+    pthread_mutex_unlock( &a->mutex );
+    return false;
+  }
+  a->inflight++;
+  _zStreamAIOEnqueue( &a->sq_head, &a->sq_tail, req );
+  pthread_cond_signal( &a->cond_submit );
+  pthread_mutex_unlock( &a->mutex );
+#else
+  if( a->inflight >= a->depth ) return false;
+  a->inflight++;
+  _zStreamAIORead( req );
+  _zStreamAIOEnqueue( &a->cq_head, &a->cq_tail, req );
+#endif /* __ZEDA_USE_PTHREAD */
+  return true;
+}
+
+/* reap a completed request from a batched asynchronous reader. */
+static zStreamAIOReq *_zStreamAIOReap(zStreamAIO *aio, bool wait)
+{
+  _zStreamAIO *a;
+  zStreamAIOReq *req;
+
+  a = (_zStreamAIO *)aio->_aio;
+#ifdef __ZEDA_USE_PTHREAD
+  pthread_mutex_lock( &a->mutex );
+  while( wait && !a->cq_head && a->inflight > 0 )
+    pthread_cond_wait( &a->cond_complete, &a->mutex );
+#endif /* __ZEDA_USE_PTHREAD */
+  if( ( req = _zStreamAIODequeue( &a->cq_head, &a->cq_tail ) ) )
+    a->inflight--;
+#ifdef __ZEDA_USE_PTHREAD
+  pthread_mutex_unlock( &a->mutex );
+#endif /* __ZEDA_USE_PTHREAD */
+  return req;
+}
+
+/* wait for a request to be completed. */
+zStreamAIOReq *zStreamAIOWait(zStreamAIO *aio)
+{
+  return _zStreamAIOReap( aio, true );
+}
+
+/* check if a request has been completed. */
+zStreamAIOReq *zStreamAIOPoll(zStreamAIO *aio)
+{
+  return _zStreamAIOReap( aio, false );
+}
+
+/* count requests submitted and not reaped yet. */
+int zStreamAIOPending(zStreamAIO *aio)
+{
+  _zStreamAIO *a;
+  int n;
+
+  a = (_zStreamAIO *)aio->_aio;
+#ifdef __ZEDA_USE_PTHREAD
+  pthread_mutex_lock( &a->mutex );
+#endif /* __ZEDA_USE_PTHREAD */
+  n = a->inflight;
+#ifdef __ZEDA_USE_PTHREAD
+  pthread_mutex_unlock( &a->mutex );
+#endif /* __ZEDA_USE_PTHREAD */
+  return n;
+}
+
+/* filter streams */
+
+typedef struct{
+  zStream **sink;   /* streams wrapped by tee */
+  int nsink;
+  int endian;       /* byte order of the sink */
+  uint32_t crc;     /* checksum of data passed */
+  size_t nread, nwrite; /* bytes passed */
+  double start;     /* time when the filter is opened */
+  byte *blk;        /* block of raw data */
+  byte *comp;       /* block of compressed data */
+  size_t blksize;   /* capacity of blk */
+  size_t cur, len;  /* current position and end of data in blk */
+  bool writing;     /* whether the filter is used for writing */
+} _zStreamFilter;
+
+#define _zStreamFlt(str)  ( (_zStreamFilter *)(str)->src.filter.state )
+#define _zStreamSink(str) ( (str)->src.filter.sink )
+
+/* current time in second. */
+static double _zStreamFilterTime(void)
+{
+#ifndef __WINDOWS__
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+#else
+  return (double)time( NULL );
+#endif /* __WINDOWS__ */
+}
+
+static void _zStreamRewindFilter(zStream *str)
+{
+  zStreamRewind( _zStreamSink(str) );
+}
+
+static int _zStreamSeekFilter(zStream *str, long offset)
+{
+  return zStreamSeek( _zStreamSink(str), offset );
+}
+
+static long _zStreamTellFilter(zStream *str)
+{
+  return zStreamTell( _zStreamSink(str) );
+}
+
+static int _zStreamCloseFilter(zStream *str)
+{
+  _zStreamFilter *flt;
+
+  if( ( flt = _zStreamFlt( str ) ) ){
+    free( flt->blk );
+    free( flt->comp );
+    free( flt );
+  }
+  str->src.filter.state = NULL;
+  return 0;
+}
+
+/* open a filter stream wrapping a sink. */
+static zStream *_zStreamFilterOpen(zStream *str, zStream *sink, size_t blksize)
+{
+  _zStreamFilter *flt;
+
+  if( !( flt = zAlloc( _zStreamFilter, 1 ) ) ||
+      ( blksize > 0 && !( flt->blk = zAlloc( byte, blksize ) ) ) ){
+    ZALLOCERROR();
+    free( flt );
+    return NULL;
+  }
+  flt->sink = NULL;
+  flt->nsink = 1;
+  flt->endian = Z_ENDIAN_UNKNOWN;
+  flt->crc = 0;
+  flt->nread = flt->nwrite = 0;
+  flt->start = _zStreamFilterTime();
+  flt->blksize = blksize;
+  flt->cur = flt->len = 0;
+  flt->writing = false;
+  str->src.filter.sink = sink;
+  str->src.filter.state = flt;
+  str->rewind = _zStreamRewindFilter;
+  str->seek   = _zStreamSeekFilter;
+  str->tell   = _zStreamTellFilter;
+  str->close  = _zStreamCloseFilter;
+  str->_buf = NULL;
+  str->_prefetch = NULL;
+  return str;
+}
+
+/* byte order conversion */
+
+/* reverse byte order of data cells. */
+static void _zStreamEndianReverse(byte *buf, size_t size, size_t nmemb)
+{
+  switch( size ){
+  case 2: endian_reverse16_array( buf, nmemb ); break;
+  case 4: endian_reverse32_array( buf, nmemb ); break;
+  case 8: endian_reverse64_array( buf, nmemb ); break;
+  default: ;
+  }
+}
+
+#define _zStreamEndianIsReversed(str,size) \
+  ( _zStreamFlt(str)->endian != endian_check() && ( (size) == 2 || (size) == 4 || (size) == 8 ) )
+
+static size_t _zStreamReadEndian(zStream *str, byte *dest, size_t size, size_t nmemb)
+{
+  size_t n;
+
+  n = zStreamRead( _zStreamSink(str), dest, size, nmemb );
+  if( _zStreamEndianIsReversed( str, size ) )
+    _zStreamEndianReverse( dest, size, n );
+  return n;
+}
+
+static size_t _zStreamWriteEndian(zStream *str, byte *src, size_t size, size_t nmemb)
+{
+  _zStreamFilter *flt;
+  size_t n, m, ret = 0;
+
+  if( !_zStreamEndianIsReversed( str, size ) )
+    return zStreamWrite( _zStreamSink(str), src, size, nmemb );
+  flt = _zStreamFlt( str );
+  for( ; nmemb>0; nmemb-=n, src+=n*size, ret+=m ){
+    n = _zMin( nmemb, flt->blksize / size );
+    memcpy( flt->blk, src, n * size );
+    _zStreamEndianReverse( flt->blk, size, n );
+    if( ( m = zStreamWrite( _zStreamSink(str), flt->blk, size, n ) ) < n ) return ret + m;
+  }
+  return ret;
+}
+
+/* open a byte order conversion filter. */
+zStream *zStreamOpenEndianFilter(zStream *str, zStream *sink, int endian)
+{
+  if( !_zStreamFilterOpen( str, sink, ZSTREAM_FILTER_BLKSIZ ) ) return NULL;
+  _zStreamFlt(str)->endian = endian;
+  str->read  = _zStreamReadEndian;
+  str->write = _zStreamWriteEndian;
+  return str;
+}
+
+/* checksumming */
+
+static size_t _zStreamReadCRC(zStream *str, byte *dest, size_t size, size_t nmemb)
+{
+  size_t n;
+
+  n = zStreamRead( _zStreamSink(str), dest, size, nmemb );
+  _zStreamFlt(str)->crc = crc32c( _zStreamFlt(str)->crc, dest, n * size );
+  return n;
+}
+
+static size_t _zStreamWriteCRC(zStream *str, byte *src, size_t size, size_t nmemb)
+{
+  size_t n;
+
+  n = zStreamWrite( _zStreamSink(str), src, size, nmemb );
+  _zStreamFlt(str)->crc = crc32c( _zStreamFlt(str)->crc, src, n * size );
+  return n;
+}
+
+/* open a checksumming filter. */
+zStream *zStreamOpenCRCFilter(zStream *str, zStream *sink)
+{
+  if( !_zStreamFilterOpen( str, sink, 0 ) ) return NULL;
+  str->read  = _zStreamReadCRC;
+  str->write = _zStreamWriteCRC;
+  return str;
+}
+
+/* closing method of a filter, looking through a read buffer. */
+#define _zStreamFilterCloseMethod(str) ( (str)->_buf ? _zStreamBuf(str)->close : (str)->close )
+
+/* checksum of data passed through a checksumming filter. */
+uint32_t zStreamFilterCRC(zStream *str)
+{
+  return _zStreamFilterCloseMethod( str ) == _zStreamCloseFilter ? _zStreamFlt(str)->crc : 0;
+}
+
+/* block-wise compression */
+
+#define ZSTREAM_LZ_HEADER_SIZE 8
+
+/* store a 32-bit unsigned integer in little endian. */
+static void _zStreamLZPut32(byte *p, size_t val)
+{
+  p[0] = val & 0xff; p[1] = ( val >> 8 ) & 0xff; p[2] = ( val >> 16 ) & 0xff; p[3] = ( val >> 24 ) & 0xff;
+}
+
+/* restore a 32-bit unsigned integer stored in little endian. */
+static size_t _zStreamLZGet32(byte *p)
+{
+  ubyte *u = (ubyte *)p;
+  return (size_t)u[0] | (size_t)u[1] << 8 | (size_t)u[2] << 16 | (size_t)u[3] << 24;
+}
+
+/* compress and write the current block. */
+static bool _zStreamLZFlush(zStream *str)
+{
+  _zStreamFilter *flt;
+  size_t compsize, size;
+
+  flt = _zStreamFlt( str );
+  if( flt->len == 0 ) return true;
+  compsize = zLZCompress( flt->blk, flt->len, flt->comp + ZSTREAM_LZ_HEADER_SIZE, flt->len );
+  if( compsize == 0 || compsize >= flt->len ){ /* incompressible block stored raw */
+    memcpy( flt->comp + ZSTREAM_LZ_HEADER_SIZE, flt->blk, flt->len );
+    compsize = flt->len;
+  }
+  _zStreamLZPut32( flt->comp, flt->len );
+  _zStreamLZPut32( flt->comp + 4, compsize );
+  size = ZSTREAM_LZ_HEADER_SIZE + compsize;
+  flt->len = 0;
+  return zStreamWrite( _zStreamSink(str), flt->comp, 1, size ) == size;
+}
+
+/* read and decompress the next block. */
+static bool _zStreamLZFill(zStream *str)
+{
+  _zStreamFilter *flt;
+  byte header[ZSTREAM_LZ_HEADER_SIZE], *p;
+  size_t rawsize, compsize;
+
+  flt = _zStreamFlt( str );
+  flt->cur = flt->len = 0;
+  if( zStreamRead( _zStreamSink(str), header, 1, ZSTREAM_LZ_HEADER_SIZE ) != ZSTREAM_LZ_HEADER_SIZE )
+    return false;
+  rawsize = _zStreamLZGet32( header );
+  compsize = _zStreamLZGet32( header + 4 );
+  if( compsize > rawsize || rawsize > ZSTREAM_LZ_BLKSIZ_MAX ) goto FAILURE;
+  if( rawsize > flt->blksize ){ /* written with a larger block */
+    if( !( p = zRealloc( flt->blk, byte, rawsize ) ) ) goto FAILURE;
+    flt->blk = p;
+    if( !( p = zRealloc( flt->comp, byte, rawsize ) ) ) goto FAILURE;
+    flt->comp = p;
+    flt->blksize = rawsize;
+  }
+  if( compsize == rawsize ){
+    if( zStreamRead( _zStreamSink(str), flt->blk, 1, rawsize ) != rawsize ) goto FAILURE;
+  } else{
+    if( zStreamRead( _zStreamSink(str), flt->comp, 1, compsize ) != compsize ||
+        zLZDecompress( flt->comp, compsize, flt->blk, rawsize ) != rawsize ) goto FAILURE;
+  }
+  flt->len = rawsize;
+  return true;
+ FAILURE:
+  ZRUNERROR( ZEDA_ERR_STREAM_INVALID_BLOCK );
+  return false;
+}
+
+static void _zStreamRewindLZ(zStream *str)
+{
+  if( _zStreamFlt(str)->writing ) _zStreamLZFlush( str );
+  _zStreamFlt(str)->cur = _zStreamFlt(str)->len = 0;
+  _zStreamFlt(str)->nread = _zStreamFlt(str)->nwrite = 0;
+  zStreamRewind( _zStreamSink(str) );
+}
+
+static int _zStreamSeekLZ(zStream *str, long offset)
+{
+  return offset == zStreamTell( str ) ? 0 : -1;
+}
+
+static long _zStreamTellLZ(zStream *str)
+{
+  return (long)( _zStreamFlt(str)->writing ? _zStreamFlt(str)->nwrite : _zStreamFlt(str)->nread );
+}
+
+static size_t _zStreamReadLZ(zStream *str, byte *dest, size_t size, size_t nmemb)
+{
+  _zStreamFilter *flt;
+  size_t rest, m;
+
+  flt = _zStreamFlt( str );
+  if( size == 0 || flt->writing ) return 0;
+  for( rest=size*nmemb; rest>0; dest+=m, rest-=m ){
+    if( flt->cur == flt->len && !_zStreamLZFill( str ) ) break;
+    m = _zMin( rest, flt->len - flt->cur );
+    memcpy( dest, flt->blk + flt->cur, m );
+    flt->cur += m;
+    flt->nread += m;
+  }
+  return ( size * nmemb - rest ) / size;
+}
+
+static size_t _zStreamWriteLZ(zStream *str, byte *src, size_t size, size_t nmemb)
+{
+  _zStreamFilter *flt;
+  size_t rest, m;
+
+  flt = _zStreamFlt( str );
+  if( size == 0 || flt->nread > 0 ) return 0;
+  flt->writing = true;
+  for( rest=size*nmemb; rest>0; src+=m, rest-=m ){
+    if( flt->len == flt->blksize && !_zStreamLZFlush( str ) ) break;
+    m = _zMin( rest, flt->blksize - flt->len );
+    memcpy( flt->blk + flt->len, src, m );
+    flt->len += m;
+    flt->nwrite += m;
+  }
+  return ( size * nmemb - rest ) / size;
+}
+
+static int _zStreamCloseLZ(zStream *str)
+{
+  int ret = 0;
+
+  if( _zStreamFlt(str)->writing && !_zStreamLZFlush( str ) ) ret = EOF;
+  _zStreamCloseFilter( str );
+  return ret;
+}
+
+/* open a block-wise compression filter. */
+zStream *zStreamOpenLZFilter(zStream *str, zStream *sink, size_t blksize)
+{
+  if( blksize == 0 ) blksize = ZSTREAM_FILTER_BLKSIZ;
+  if( blksize > ZSTREAM_LZ_BLKSIZ_MAX ) blksize = ZSTREAM_LZ_BLKSIZ_MAX;
+  if( !_zStreamFilterOpen( str, sink, blksize ) ) return NULL;
+  if( !( _zStreamFlt(str)->comp = zAlloc( byte, ZSTREAM_LZ_HEADER_SIZE + blksize ) ) ){
+    ZALLOCERROR();
+    _zStreamCloseFilter( str );
+    return NULL;
+  }
+  str->rewind = _zStreamRewindLZ;
+  str->seek   = _zStreamSeekLZ;
+  str->tell   = _zStreamTellLZ;
+  str->read   = _zStreamReadLZ;
+  str->write  = _zStreamWriteLZ;
+  str->close  = _zStreamCloseLZ;
+  return str;
+}
+
+/* tee */
+
+static void _zStreamRewindTee(zStream *str)
+{
+  int i;
+
+  for( i=0; i<_zStreamFlt(str)->nsink; i++ )
+    zStreamRewind( _zStreamFlt(str)->sink[i] );
+}
+
+static int _zStreamSeekTee(zStream *str, long offset)
+{
+  int i, ret = 0;
+
+  for( i=0; i<_zStreamFlt(str)->nsink; i++ )
+    if( zStreamSeek( _zStreamFlt(str)->sink[i], offset ) != 0 ) ret = -1;
+  return ret;
+}
+
+static size_t _zStreamReadTee(zStream *str, byte *dest, size_t size, size_t nmemb)
+{
+  size_t n;
+  int i;
+
+  n = zStreamRead( _zStreamSink(str), dest, size, nmemb );
+  for( i=1; i<_zStreamFlt(str)->nsink; i++ )
+    zStreamWrite( _zStreamFlt(str)->sink[i], dest, size, n );
+  return n;
+}
+
+static size_t _zStreamWriteTee(zStream *str, byte *src, size_t size, size_t nmemb)
+{
+  size_t n, ret = nmemb;
+  int i;
+
+  for( i=0; i<_zStreamFlt(str)->nsink; i++ )
+    if( ( n = zStreamWrite( _zStreamFlt(str)->sink[i], src, size, nmemb ) ) < ret ) ret = n;
+  return ret;
+}
+
+/* open a tee filter. */
+zStream *zStreamOpenTeeFilter(zStream *str, zStream *sink[], int nsink)
+{
+  if( nsink <= 0 ) return NULL;
+  if( !_zStreamFilterOpen( str, sink[0], 0 ) ) return NULL;
+  _zStreamFlt(str)->sink = sink;
+  _zStreamFlt(str)->nsink = nsink;
+  str->rewind = _zStreamRewindTee;
+  str->seek   = _zStreamSeekTee;
+  str->read   = _zStreamReadTee;
+  str->write  = _zStreamWriteTee;
+  return str;
+}
+
+/* counting */
+
+static size_t _zStreamReadCount(zStream *str, byte *dest, size_t size, size_t nmemb)
+{
+  size_t n;
+
+  n = zStreamRead( _zStreamSink(str), dest, size, nmemb );
+  _zStreamFlt(str)->nread += n * size;
+  return n;
+}
+
+static size_t _zStreamWriteCount(zStream *str, byte *src, size_t size, size_t nmemb)
+{
+  size_t n;
+
+  n = zStreamWrite( _zStreamSink(str), src, size, nmemb );
+  _zStreamFlt(str)->nwrite += n * size;
+  return n;
+}
+
+/* open a counting filter. */
+zStream *zStreamOpenCountFilter(zStream *str, zStream *sink)
+{
+  if( !_zStreamFilterOpen( str, sink, 0 ) ) return NULL;
+  str->read  = _zStreamReadCount;
+  str->write = _zStreamWriteCount;
+  return str;
+}
+
+/* statistics of data passed through a filter. */
+bool zStreamFilterGetStat(zStream *str, zStreamFilterStat *stat)
+{
+  _zStreamFilter *flt;
+  int (* close)(zStream *);
+
+  close = _zStreamFilterCloseMethod( str );
+  if( close != _zStreamCloseFilter && close != _zStreamCloseLZ ) return false;
+  flt = _zStreamFlt( str );
+  stat->nread = flt->nread;
+  if( str->_buf ) /* not consumed yet */
+    stat->nread -= _zStreamBuf(str)->len - _zStreamBuf(str)->cur;
+  stat->nwrite = flt->nwrite;
+  stat->elapsed = _zStreamFilterTime() - flt->start;
+  stat->read_rate = stat->elapsed > 0 ? stat->nread / stat->elapsed : 0;
+  stat->write_rate = stat->elapsed > 0 ? stat->nwrite / stat->elapsed : 0;
+  return true;
+}
 
 #endif /* __KERNEL__ */
@@ -667,6 +667,211 @@ bool zFPostCheckKey(FILE *fp)
   return false;
 }
 
+/* tokenizers of a stream */
+
+/* skip certain charactors in a stream. */
+char zStreamSkipIncludedChar(zStream *str, char *s)
+{
+  int c;
+
+  do{
+    if( ( c = zStreamGetc( str ) ) == EOF ) return (char)0;
+  } while( zIsIncludedChar( c, s ) );
+  zStreamUngetc( str, c );
+  return c;
+}
+
+/* skip whitespaces in a stream. */
+char zStreamSkipWS(zStream *str)
+{
+  int c;
+
+  do{
+    if( ( c = zStreamGetc( str ) ) == EOF ) return (char)0;
+  } while( zIsWS(c) );
+  zStreamUngetc( str, c );
+  return c;
+}
+
+/* skip delimiters in a stream. */
+char zStreamSkipDelimiter(zStream *str)
+{
+  return zStreamSkipIncludedChar( str, zdelimiter );
+}
+
+/* skip comments in a stream. */
+char zStreamSkipComment(zStream *str)
+{
+  int c;
+
+  while( 1 ){
+    if( !zStreamSkipDelimiter( str ) ) return (char)0;
+    if( ( c = zStreamGetc( str ) ) != zcommentident ){
+      zStreamUngetc( str, c );
+      return c;
+    }
+    while( ( c = zStreamGetc( str ) ) != '\n' )
+      if( c == EOF ) return (char)0;
+  }
+  return 0; /* never reaches this statement */
+}
+
+/* get a quoted string from a stream. */
+static char *_zStreamString(zStream *str, char *tkn, size_t size)
+{
+  uint i;
+  int c;
+
+  if( size <= 1 ) return NULL;
+  size--; /* for the null charactor */
+  for( i=0; ( c = zStreamGetc( str ) ) != EOF; i++ ){
+    if( i >= size ){
+      ZRUNWARN( ZEDA_WARN_TOOLNG_STR );
+      break;
+    }
+    if( zIsQuotation( c ) && ( i == 0 || tkn[i-1] != '\\' ) ) break;
+    tkn[i] = c;
+  }
+  tkn[i] = '\0';
+  return tkn;
+}
+
+/* get a token in a stream. */
+char *zStreamToken(zStream *str, char *tkn, size_t size)
+{
+  uint i;
+  int c;
+
+  *tkn = '\0'; /* initialize buffer */
+  if( !zStreamSkipComment( str ) ) return NULL;
+  c = zStreamGetc( str );
+  if( zIsQuotation( c ) )
+    return _zStreamString( str, tkn, size );
+  *tkn = c;
+  size--;
+  for( i=1; ( c = zStreamGetc( str ) ) != EOF; i++ ){
+    if( i >= size ){
+      ZRUNWARN( ZEDA_WARN_TOOLNG_TKN );
+      zStreamUngetc( str, c );
+      i = _zMax( size, 0 );
+      break;
+    }
+    if( zIsDelimiter( c ) ){
+      zStreamUngetc( str, c );
+      break;
+    }
+    tkn[i] = c;
+  }
+  tkn[i] = '\0';
+  return tkn;
+}
+
+/* get a token that represents an integer number from a stream. */
+char *zStreamIntToken(zStream *str, char *tkn, size_t size)
+{
+  uint i;
+  int c;
+
+  size--;
+  for( i=0; ; i++ ){
+    if( i >= size ){
+      ZRUNWARN( ZEDA_WARN_TOOLNG_NUM );
+      i = _zMax( size, 0 );
+      break;
+    }
+    if( ( c = zStreamGetc( str ) ) == EOF ) break;
+    if( !isdigit( c ) ){
+      zStreamUngetc( str, c );
+      break;
+    }
+    tkn[i] = c;
+  }
+  tkn[i] = '\0';
+  return tkn;
+}
+
+/* get a token that represents an unsigned real number from a stream. */
+static char *_zStreamUnsignedToken(zStream *str, char *tkn, size_t size)
+{
+  size_t len;
+
+  if( ( len = strlen( zStreamIntToken( str, tkn, size ) ) ) < size - 1 ){
+    if( zStreamPeek( str ) == '.' && size - len > 1 ){
+      tkn[len] = zStreamGetc( str );
+      zStreamIntToken( str, tkn+len+1, size-len-1 );
+    }
+  }
+  return tkn;
+}
+
+/* get a token that represents a signed real number from a stream. */
+static char *_zStreamSignedToken(zStream *str, char *tkn, size_t size)
+{
+  int c;
+
+  c = zStreamGetc( str );
+  if( c != '+' && c != '-' ){
+    zStreamUngetc( str, c );
+    return _zStreamUnsignedToken( str, tkn, size );
+  }
+  if( size > 1 && *_zStreamUnsignedToken( str, tkn+1, size-1 ) )
+    *tkn = c;
+  else{
+    zStreamUngetc( str, c );
+    *tkn = '\0';
+  }
+  return tkn;
+}
+
+/* get a token that represents a number from a stream. */
+char *zStreamNumToken(zStream *str, char *tkn, size_t size)
+{
+  int c;
+  size_t len;
+
+  if( !*_zStreamSignedToken( str, tkn, size ) ) return tkn;
+  if( ( len = strlen( tkn ) + 1 ) >= size ) return tkn;
+  if( ( c = zStreamGetc( str ) ) == 'e' || c == 'E' ){
+    if( !*_zStreamSignedToken( str, tkn+len, size-len ) )
+      zStreamUngetc( str, c );
+    else
+      tkn[len-1] = c;
+  } else
+    zStreamUngetc( str, c );
+  return tkn;
+}
+
+/* get an integer value from a stream. */
+char *zStreamInt(zStream *str, int *val)
+{
+  char buf[BUFSIZ], *ret;
+  if( ( ret = zStreamToken( str, buf, BUFSIZ ) ) ) *val = atoi( buf );
+  return ret;
+}
+
+/* get a double-precision floating-point value from a stream. */
+char *zStreamDouble(zStream *str, double *val)
+{
+  char buf[BUFSIZ], *ret;
+  if( ( ret = zStreamToken( str, buf, BUFSIZ ) ) ) *val = atof( buf );
+  return ret;
+}
+
+/* check if the last token in a stream is a key. */
+bool zStreamPostCheckKey(zStream *str)
+{
+  int c;
+
+  while( ( c = zStreamGetc( str ) ) != EOF ){
+    if( c == zkeyident ) return true;
+    if( !zIsDelimiter( c ) ){
+      zStreamUngetc( str, c );
+      break;
+    }
+  }
+  return false;
+}
+
 #ifndef __KERNEL__
 /* indent. */
 void zFIndent(FILE *fp, int n)
@@ -0,0 +1,231 @@
+/* ZEDA - Elementary Data and Algorithms
+ * Copyright (C) 1998 Tomomichi Sugihara (Zhidao)
+ *
+ * zeda_tscodec - compression of time series of numbers.
+ */
+
+#include <zeda/zeda_tscodec.h>
+
+/* bit stream */
+typedef struct{
+  ubyte *cur, *end;
+  uint64_t acc; /* accumulated bits */
+  int nacc;     /* number of accumulated bits */
+  bool err;
+} _zTSBitStream;
+
+static void _zTSBitStreamInit(_zTSBitStream *bs, const void *buf, size_t size)
+{
+  bs->cur = (ubyte *)buf;
+  bs->end = bs->cur + size;
+  bs->acc = 0;
+  bs->nacc = 0;
+  bs->err = false;
+}
+
+/* put at most 32 bits. */
+static void _zTSPutBits32(_zTSBitStream *bs, uint32_t val, int nbit)
+{
+  if( nbit == 0 ) return;
+  bs->acc = bs->acc << nbit | ( val & ( 0xffffffffU >> ( 32 - nbit ) ) );
+  for( bs->nacc+=nbit; bs->nacc>=8; bs->nacc-=8 ){
+    if( bs->cur >= bs->end ){
+      bs->err = true;
+      return;
+    }
+    *bs->cur++ = (ubyte)( bs->acc >> ( bs->nacc - 8 ) );
+  }
+}
+
+/* put at most 64 bits. */
+static void _zTSPutBits(_zTSBitStream *bs, uint64_t val, int nbit)
+{
+  if( nbit > 32 ){
+    _zTSPutBits32( bs, (uint32_t)( val >> 32 ), nbit - 32 );
+    nbit = 32;
+  }
+  _zTSPutBits32( bs, (uint32_t)val, nbit );
+}
+
+/* flush remaining bits. */
+static size_t _zTSPutFlush(_zTSBitStream *bs, void *buf)
+{
+  if( bs->nacc > 0 ) _zTSPutBits32( bs, 0, 8 - bs->nacc );
+  return bs->err ? 0 : (size_t)( bs->cur - (ubyte *)buf );
+}
+
+/* get at most 32 bits. */
+static uint32_t _zTSGetBits32(_zTSBitStream *bs, int nbit)
+{
+  if( nbit == 0 ) return 0;
+  for( ; bs->nacc<nbit; bs->nacc+=8 ){
+    if( bs->cur >= bs->end ){
+      bs->err = true;
+      return 0;
+    }
+    bs->acc = bs->acc << 8 | *bs->cur++;
+  }
+  bs->nacc -= nbit;
+  return (uint32_t)( bs->acc >> bs->nacc ) & ( 0xffffffffU >> ( 32 - nbit ) );
+}
+
+/* get at most 64 bits. */
+static uint64_t _zTSGetBits(_zTSBitStream *bs, int nbit)
+{
+  uint64_t val = 0;
+
+  if( nbit > 32 ){
+    val = (uint64_t)_zTSGetBits32( bs, nbit - 32 ) << 32;
+    nbit = 32;
+  }
+  return val | _zTSGetBits32( bs, nbit );
+}
+
+/* number of leading zeros of a nonzero value. */
+static int _zTSLeadingZeros(uint64_t val)
+{
+#ifdef __GNUC__
+  return __builtin_clzll( val );
+#else
+  int n;
+  for( n=0; !( val & (uint64_t)1 << 63 ); val<<=1 ) n++;
+  return n;
+#endif
+}
+
+/* number of trailing zeros of a nonzero value. */
+static int _zTSTrailingZeros(uint64_t val)
+{
+#ifdef __GNUC__
+  return __builtin_ctzll( val );
+#else
+  int n;
+  for( n=0; !( val & 1 ); val>>=1 ) n++;
+  return n;
+#endif
+}
+
+/* compress a time series of double-precision floating-point values. */
+size_t zTSDoubleCompress(const double *src, size_t n, void *dst, size_t dstsize)
+{
+  _zTSBitStream bs;
+  uint64_t val, prev, x;
+  int lead, trail, plead = 0xff, ptrail = 0;
+  size_t i;
+
+  _zTSBitStreamInit( &bs, dst, dstsize );
+  if( n == 0 ) return 0;
+  memcpy( &prev, &src[0], sizeof(uint64_t) );
+  _zTSPutBits( &bs, prev, 64 );
+  for( i=1; i<n && !bs.err; i++ ){
+    memcpy( &val, &src[i], sizeof(uint64_t) );
+    if( ( x = val ^ prev ) == 0 ){
+      _zTSPutBits32( &bs, 0, 1 );
+      continue;
+    }
+    prev = val;
+    if( ( lead = _zTSLeadingZeros( x ) ) > 31 ) lead = 31;
+    trail = _zTSTrailingZeros( x );
+    if( plead != 0xff && lead >= plead && trail >= ptrail ){ /* reuse the window */
+      _zTSPutBits32( &bs, 0x2, 2 );
+      _zTSPutBits( &bs, x >> ptrail, 64 - plead - ptrail );
+    } else{
+      _zTSPutBits32( &bs, 0x3, 2 );
+      _zTSPutBits32( &bs, lead, 5 );
+      _zTSPutBits32( &bs, ( 64 - lead - trail ) & 0x3f, 6 ); /* 64 is stored as 0 */
+      _zTSPutBits( &bs, x >> trail, 64 - lead - trail );
+      plead = lead;
+      ptrail = trail;
+    }
+  }
+  return _zTSPutFlush( &bs, dst );
+}
+
+/* decompress a time series of double-precision floating-point values. */
+size_t zTSDoubleDecompress(const void *src, size_t srcsize, double *dst, size_t n)
+{
+  _zTSBitStream bs;
+  uint64_t val;
+  int lead = -1, len = 0, trail = 0;
+  size_t i;
+
+  _zTSBitStreamInit( &bs, src, srcsize );
+  if( n == 0 ) return 0;
+  val = _zTSGetBits( &bs, 64 );
+  for( i=0; !bs.err; ){
+    memcpy( &dst[i], &val, sizeof(double) );
+    if( ++i == n ) break;
+    if( _zTSGetBits32( &bs, 1 ) == 0 ) continue;
+    if( _zTSGetBits32( &bs, 1 ) == 1 ){
+      lead = _zTSGetBits32( &bs, 5 );
+      if( ( len = _zTSGetBits32( &bs, 6 ) ) == 0 ) len = 64;
+      if( ( trail = 64 - lead - len ) < 0 ) break;
+    } else
+    if( lead < 0 ) break; /* no window to be reused */
+    val ^= _zTSGetBits( &bs, len ) << trail;
+  }
+  return i;
+}
+
+/* compress a time series of 64-bit integers. */
+size_t zTSInt64Compress(const int64_t *src, size_t n, void *dst, size_t dstsize)
+{
+  _zTSBitStream bs;
+  uint64_t delta, pdelta;
+  int64_t dod;
+  size_t i;
+
+  _zTSBitStreamInit( &bs, dst, dstsize );
+  if( n == 0 ) return 0;
+  _zTSPutBits( &bs, (uint64_t)src[0], 64 );
+  if( n > 1 ) _zTSPutBits( &bs, pdelta = (uint64_t)src[1] - (uint64_t)src[0], 64 );
+  for( i=2; i<n && !bs.err; i++, pdelta=delta ){
+    delta = (uint64_t)src[i] - (uint64_t)src[i-1];
+    if( ( dod = (int64_t)( delta - pdelta ) ) == 0 )
+      _zTSPutBits32( &bs, 0, 1 );
+    else if( dod >= -63 && dod <= 64 ){
+      _zTSPutBits32( &bs, 0x2, 2 );
+      _zTSPutBits32( &bs, (uint32_t)( dod + 63 ), 7 );
+    } else if( dod >= -255 && dod <= 256 ){
+      _zTSPutBits32( &bs, 0x6, 3 );
+      _zTSPutBits32( &bs, (uint32_t)( dod + 255 ), 9 );
+    } else if( dod >= -2047 && dod <= 2048 ){
+      _zTSPutBits32( &bs, 0xe, 4 );
+      _zTSPutBits32( &bs, (uint32_t)( dod + 2047 ), 12 );
+    } else{
+      _zTSPutBits32( &bs, 0xf, 4 );
+      _zTSPutBits( &bs, (uint64_t)dod, 64 );
+    }
+  }
+  return _zTSPutFlush( &bs, dst );
+}
+
+/* decompress a time series of 64-bit integers. */
+size_t zTSInt64Decompress(const void *src, size_t srcsize, int64_t *dst, size_t n)
+{
+  _zTSBitStream bs;
+  uint64_t val, delta;
+  size_t i;
+
+  _zTSBitStreamInit( &bs, src, srcsize );
+  if( n == 0 ) return 0;
+  val = _zTSGetBits( &bs, 64 );
+  if( bs.err ) return 0;
+  dst[0] = (int64_t)val;
+  if( n == 1 ) return 1;
+  delta = _zTSGetBits( &bs, 64 );
+  for( i=1; !bs.err; ){
+    dst[i] = (int64_t)( val += delta );
+    if( ++i == n ) break;
+    if( _zTSGetBits32( &bs, 1 ) == 0 ) continue;
+    if( _zTSGetBits32( &bs, 1 ) == 0 )
+      delta += (uint64_t)_zTSGetBits32( &bs, 7 ) - 63;
+    else if( _zTSGetBits32( &bs, 1 ) == 0 )
+      delta += (uint64_t)_zTSGetBits32( &bs, 9 ) - 255;
+    else if( _zTSGetBits32( &bs, 1 ) == 0 )
+      delta += (uint64_t)_zTSGetBits32( &bs, 12 ) - 2047;
+    else
+      delta += _zTSGetBits( &bs, 64 );
+  }
+  return i;
+}
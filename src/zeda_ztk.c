@@ -236,14 +236,13 @@ bool _ZTKParse(ZTK *ztk, char *path)
   return ret;
 }
 
-/* scan and parse a file stream into a tag-and-key list of a ZTK format processor. */
-bool ZTKParseFP(ZTK *ztk, FILE *fp)
+/* scan and parse a stream into a tag-and-key list of a ZTK format processor. */
+bool ZTKParseStream(ZTK *ztk, zStream *str)
 {
   char buf[BUFSIZ];
   bool ret = true;
 
-  while( !feof( fp ) ){
-    if( !zFToken( fp, buf, BUFSIZ ) ) break;
+  while( zStreamToken( str, buf, BUFSIZ ) ){
     if( zTokenIsTag( buf ) ){
       zExtractTag( buf, buf );
       if( !_ZTKParseTag( ztk, buf ) ){
@@ -252,12 +251,12 @@ bool ZTKParseFP(ZTK *ztk, FILE *fp)
       }
     } else{ /* might be a key or a value */
       if( strcmp( buf, "include" ) == 0 ){ /* include a file */
-        _ZTKParse( ztk, zFToken(fp,buf,BUFSIZ) );
+        _ZTKParse( ztk, zStreamToken(str,buf,BUFSIZ) );
         continue;
       }
       if( !ztk->tf_cp )
         if( !_ZTKParseTag( ztk, (char *)"" ) ) continue; /* tagged field unactivated. */
-      if( zFPostCheckKey( fp ) ){ /* token is a key. */
+      if( zStreamPostCheckKey( str ) ){ /* token is a key. */
         if( !( ztk->kf_cp = ZTKKeyFieldListNew( &ztk->tf_cp->data.kflist, buf ) ) ){
           ret = false;
           break;
@@ -279,6 +278,18 @@ bool ZTKParseFP(ZTK *ztk, FILE *fp)
   return ret;
 }
 
+/* scan and parse a file stream into a tag-and-key list of a ZTK format processor. */
+bool ZTKParseFP(ZTK *ztk, FILE *fp)
+{
+  zStream str;
+  bool ret;
+
+  zStreamAttachFile( &str, fp );
+  ret = ZTKParseStream( ztk, &str );
+  zStreamUnsetBuffer( &str ); /* put the file position back to the end of the last token */
+  return ret;
+}
+
 /* scan and parse a file into a tag-and-key list of a ZTK format processor. */
 bool ZTKParse(ZTK *ztk, char *path)
 {
@@ -1,6 +1,20 @@
 #include <zeda/zeda.h>
 
 zArrayClass( int_array_t, int );
+zArraySortDef( int_array_t, int, *a < *b )
+
+typedef struct{
+  double key;
+  int id;
+} rec_t;
+zArrayClass( rec_array_t, rec_t );
+zArraySortDef( rec_array_t, rec_t, a->key > b->key || ( a->key == b->key && a->id < b->id ) )
+
+zArrayClass( int_set_t, int );
+zArrayFlatSetDef( int_set_t, int, *a < *b )
+
+zArrayFlatMapClass( int_map_t, int, double );
+zArrayFlatMapDef( int_map_t, int, double, *a < *b )
 
 int cmp(void *v1, void *v2, void *dummy)
 {
@@ -46,11 +60,461 @@ int assert_insertsort(int n)
   return 1;
 }
 
+int assert_vector(int n)
+{
+  int i;
+  int_array_t array, array2;
+  int val, buf[5] = { -1, -2, -3, -4, -5 };
+  uint nrealloc = 0, capacity;
+
+  zArrayInit( &array );
+  for( i=0; i<n; i++ ){
+    capacity = zArrayCapacity(&array);
+    zArrayAdd( &array, int, &i );
+    if( zArrayCapacity(&array) != capacity ) nrealloc++;
+  }
+  if( zArraySize(&array) != n || zArrayCapacity(&array) < n || nrealloc > 12 ) return 0;
+  for( i=0; i<n; i++ )
+    if( *zArrayElem(&array,i) != i ) return 0;
+  /* bulk insertion and erasure */
+  zArrayInsertRange( &array, int, 10, buf, 5 );
+  if( zArraySize(&array) != n+5 || *zArrayElemNC(&array,9) != 9 || *zArrayElemNC(&array,10) != -1 ||
+      *zArrayElemNC(&array,14) != -5 || *zArrayElemNC(&array,15) != 10 ) return 0;
+  zArrayEraseRange( &array, int, 10, 5 );
+  for( i=0; i<n; i++ )
+    if( *zArrayElemNC(&array,i) != i ) return 0;
+  val = -1;
+  zArrayInsert( &array, int, 0, &val );
+  zArrayDelete( &array, int, n );
+  if( zArraySize(&array) != n || *zArrayElemNC(&array,0) != -1 || *zArrayHead(&array) != n-2 ) return 0;
+  /* reservation and shrink */
+  capacity = zArrayCapacity(&array);
+  zArrayReserve( &array, int, 4*n );
+  if( zArrayCapacity(&array) != 4*n || zArraySize(&array) != n ) return 0;
+  zArrayReserve( &array, int, n );
+  if( zArrayCapacity(&array) != 4*n ) return 0;
+  zArrayShrinkToFit( &array, int );
+  if( zArrayCapacity(&array) != n || *zArrayElemNC(&array,1) != 0 ) return 0;
+  /* append */
+  zArrayAlloc( &array2, int, 3 );
+  for( i=0; i<3; i++ ) *zArrayElemNC(&array2,i) = 100 + i;
+  zArrayAppend( &array, &array2, int );
+  if( zArraySize(&array) != n+3 || *zArrayHead(&array) != 102 ) return 0;
+  zArrayEraseRange( &array, int, 0, zArraySize(&array) );
+  zArrayShrinkToFit( &array, int );
+  if( zArraySize(&array) != 0 || zArrayCapacity(&array) != 0 || zArrayBuf(&array) ) return 0;
+  zArrayFree( &array2 );
+  return 1;
+}
+
+int assert_sortdef(int n, int pattern)
+{
+  int i, *count;
+  int_array_t array;
+  bool ret = true;
+
+  zArrayAlloc( &array, int, n );
+  count = zAlloc( int, 2*n+1 );
+  for( i=0; i<n; i++ ){
+    switch( pattern ){
+    case 0:  *zArrayElemNC(&array,i) = zRandI(-n,n); break; /* random */
+    case 1:  *zArrayElemNC(&array,i) = i; break; /* sorted */
+    case 2:  *zArrayElemNC(&array,i) = n - i; break; /* reversed */
+    case 3:  *zArrayElemNC(&array,i) = 7; break; /* all equal */
+    case 4:  *zArrayElemNC(&array,i) = i < n/2 ? i : n - i; break; /* organ pipe */
+    default: *zArrayElemNC(&array,i) = zRandI(-n,n);
+    }
+    count[*zArrayElemNC(&array,i)+n]++;
+  }
+  if( pattern == 5 ) /* heap sort fallback */
+    _int_array_tIntroSort( zArrayBuf(&array), n, 0 );
+  else
+    int_array_tSort( &array );
+  for( i=0; i<n; i++ ){
+    if( i > 0 && *zArrayElemNC(&array,i-1) > *zArrayElemNC(&array,i) ) ret = false;
+    count[*zArrayElemNC(&array,i)+n]--;
+  }
+  for( i=0; i<=2*n; i++ )
+    if( count[i] != 0 ) ret = false;
+  free( count );
+  zArrayFree( &array );
+  return ret;
+}
+
+int assert_sortdef_struct(int n)
+{
+  int i;
+  rec_array_t array;
+  bool ret = true;
+
+  zArrayAlloc( &array, rec_t, n );
+  for( i=0; i<n; i++ ){
+    zArrayElemNC(&array,i)->key = zRandI(0,10);
+    zArrayElemNC(&array,i)->id = i;
+  }
+  rec_array_tSort( &array );
+  for( i=1; i<n; i++ ){
+    if( zArrayElemNC(&array,i-1)->key < zArrayElemNC(&array,i)->key ) ret = false;
+    if( zArrayElemNC(&array,i-1)->key == zArrayElemNC(&array,i)->key &&
+        zArrayElemNC(&array,i-1)->id > zArrayElemNC(&array,i)->id ) ret = false;
+  }
+  zArrayFree( &array );
+  return ret;
+}
+
+int cmp_rec(void *v1, void *v2, void *dummy)
+{
+  if( ((rec_t*)v1)->key > ((rec_t*)v2)->key ) return 1;
+  if( ((rec_t*)v1)->key < ((rec_t*)v2)->key ) return -1;
+  return 0;
+}
+
+bool assert_parallelsort(int n, int nthread, size_t cutoff)
+{
+  int i;
+  int_array_t array, array2;
+  bool ret = true;
+
+  zArrayAlloc( &array, int, n );
+  zArrayAlloc( &array2, int, n );
+  for( i=0; i<n; i++ )
+    *zArrayElemNC(&array,i) = *zArrayElemNC(&array2,i) = zRandI(-1000,1000);
+  if( !zParallelSort( zArrayBuf(&array), n, sizeof(int), cmp, NULL, nthread, cutoff ) ) ret = false;
+  zArrayQuickSort( &array2, cmp, NULL );
+  for( i=0; i<n; i++ )
+    if( *zArrayElemNC(&array,i) != *zArrayElemNC(&array2,i) ) ret = false;
+  zArrayFree( &array );
+  zArrayFree( &array2 );
+  return ret;
+}
+
+bool assert_parallelsort_determinism(int n)
+{
+  int i, nthread;
+  rec_array_t array, array2;
+  bool ret = true;
+
+  zArrayAlloc( &array, rec_t, n );
+  zArrayAlloc( &array2, rec_t, n );
+  for( i=0; i<n; i++ ){
+    zArrayElemNC(&array,i)->key = zRandI(0,10); /* many equal keys */
+    zArrayElemNC(&array,i)->id = i;
+  }
+  memcpy( zArrayBuf(&array2), zArrayBuf(&array), sizeof(rec_t)*n );
+  zParallelSort( zArrayBuf(&array2), n, sizeof(rec_t), cmp_rec, NULL, 1, 100 );
+  for( nthread=2; nthread<=8; nthread+=3 ){
+    rec_array_t array3;
+    zArrayAlloc( &array3, rec_t, n );
+    memcpy( zArrayBuf(&array3), zArrayBuf(&array), sizeof(rec_t)*n );
+    zParallelSort( zArrayBuf(&array3), n, sizeof(rec_t), cmp_rec, NULL, nthread, 100 );
+    if( memcmp( zArrayBuf(&array3), zArrayBuf(&array2), sizeof(rec_t)*n ) != 0 ) ret = false;
+    zArrayFree( &array3 );
+  }
+  zArrayFree( &array );
+  zArrayFree( &array2 );
+  return ret;
+}
+
+int cmp_double(void *v1, void *v2, void *dummy)
+{
+  if( *(double*)v1 > *(double*)v2 ) return 1;
+  if( *(double*)v1 < *(double*)v2 ) return -1;
+  return 0;
+}
+
+bool assert_radixsort(int n)
+{
+  int32_t *i32;
+  int64_t *i64;
+  float *f;
+  double *d;
+  int i;
+  bool ret = true;
+
+  i32 = zAlloc( int32_t, n );
+  i64 = zAlloc( int64_t, n );
+  f = zAlloc( float, n );
+  d = zAlloc( double, n );
+  for( i=0; i<n; i++ ){
+    i32[i] = zRandI( -0x3fffffff, 0x3fffffff );
+    i64[i] = (int64_t)i32[i] * zRandI( -0x3fffffff, 0x3fffffff );
+    d[i] = zRandF( -1.0e3, 1.0e3 );
+    f[i] = d[i];
+  }
+  if( n > 2 ){
+    d[0] = -0.0; d[1] = 0.0; d[2] = 1.0e300;
+  }
+  if( !zRadixSortInt32( i32, n ) || !zRadixSortInt64( i64, n ) ||
+      !zRadixSortFloat( f, n ) || !zRadixSortDouble( d, n ) ) ret = false;
+  for( i=1; i<n; i++ )
+    if( i32[i-1] > i32[i] || i64[i-1] > i64[i] || f[i-1] > f[i] || d[i-1] > d[i] ) ret = false;
+  if( n > 2 && d[n-1] != 1.0e300 ) ret = false;
+  free( i32 );
+  free( i64 );
+  free( f );
+  free( d );
+  return ret;
+}
+
+uint64_t rec_key(void *rec, void *dummy)
+{
+  return zRadixKeyDouble( ((rec_t*)rec)->key );
+}
+
+bool assert_radixsort_key(int n)
+{
+  rec_array_t array, array2;
+  size_t *perm;
+  int i;
+  bool ret = true;
+
+  zArrayAlloc( &array, rec_t, n );
+  zArrayAlloc( &array2, rec_t, n );
+  perm = zAlloc( size_t, n );
+  for( i=0; i<n; i++ ){
+    zArrayElemNC(&array,i)->key = zRandI( -10, 10 ) * 0.5;
+    zArrayElemNC(&array,i)->id = i;
+  }
+  memcpy( zArrayBuf(&array2), zArrayBuf(&array), sizeof(rec_t)*n );
+  if( !zRadixSortPerm( zArrayBuf(&array), n, sizeof(rec_t), rec_key, NULL, 8, perm ) ) ret = false;
+  if( !zRadixSortKey( zArrayBuf(&array2), n, sizeof(rec_t), rec_key, NULL, 8, NULL ) ) ret = false;
+  for( i=0; i<n; i++ )
+    if( zArrayElemNC(&array2,i)->id != (int)perm[i] ) ret = false;
+  for( i=1; i<n; i++ ){
+    if( zArrayElemNC(&array2,i-1)->key > zArrayElemNC(&array2,i)->key ) ret = false;
+    if( zArrayElemNC(&array2,i-1)->key == zArrayElemNC(&array2,i)->key &&
+        zArrayElemNC(&array2,i-1)->id > zArrayElemNC(&array2,i)->id ) ret = false; /* stability */
+  }
+  zArrayFree( &array );
+  zArrayFree( &array2 );
+  free( perm );
+  return ret;
+}
+
+bool assert_flatset(int n)
+{
+  int_set_t set, set2;
+  bool *exist;
+  int i, val;
+  bool ret = true;
+
+  zArrayInit( &set );
+  exist = zAlloc( bool, n );
+  for( i=0; i<n; i++ ){ /* insertion */
+    val = zRandI( 0, n-1 );
+    if( !int_set_tInsert( &set, &val ) || *int_set_tInsert( &set, &val ) != val ) ret = false;
+    exist[val] = true;
+  }
+  for( i=1; i<zArraySize(&set); i++ )
+    if( *zArrayElemNC(&set,i-1) >= *zArrayElemNC(&set,i) ) ret = false;
+  for( i=0; i<n; i++ ){
+    if( ( int_set_tFind( &set, &i ) != NULL ) != exist[i] ) ret = false;
+    val = int_set_tLowerBound( &set, &i );
+    if( val < zArraySize(&set) && *zArrayElemNC(&set,val) < i ) ret = false;
+    if( val > 0 && *zArrayElemNC(&set,val-1) >= i ) ret = false;
+    if( int_set_tUpperBound( &set, &i ) != val + ( exist[i] ? 1 : 0 ) ) ret = false;
+  }
+  /* bulk build */
+  zArrayAlloc( &set2, int, n );
+  for( i=0; i<n; i++ )
+    *zArrayElemNC(&set2,i) = zRandI( 0, n-1 );
+  int_set_tBuild( &set2 );
+  for( i=1; i<zArraySize(&set2); i++ )
+    if( *zArrayElemNC(&set2,i-1) >= *zArrayElemNC(&set2,i) ) ret = false;
+  /* erasure */
+  for( i=0; i<n; i+=2 )
+    if( int_set_tErase( &set, &i ) != exist[i] ) ret = false;
+  for( i=0; i<n; i++ )
+    if( ( int_set_tFind( &set, &i ) != NULL ) != ( exist[i] && i % 2 == 1 ) ) ret = false;
+  zArrayFree( &set );
+  zArrayFree( &set2 );
+  free( exist );
+  return ret;
+}
+
+bool assert_flatmap(void)
+{
+  int_map_t map;
+  int key;
+  double val, *vp;
+  bool ret = true;
+
+  zArrayInit( &map );
+  for( key=10; key>0; key-- ){
+    val = key * 0.5;
+    int_map_tSet( &map, &key, &val );
+  }
+  key = 3; val = -1;
+  int_map_tSet( &map, &key, &val ); /* overwrite */
+  if( zArraySize(&map) != 10 ) ret = false;
+  for( key=1; key<=10; key++ ){
+    if( !( vp = int_map_tGet( &map, &key ) ) ) ret = false;
+    else if( *vp != ( key == 3 ? -1 : key * 0.5 ) ) ret = false;
+    if( zArrayElemNC(&map,key-1)->key != key ) ret = false;
+  }
+  key = 11;
+  if( int_map_tGet( &map, &key ) ) ret = false;
+  zArrayFree( &map );
+  return ret;
+}
+
+bool assert_mergesort(int n, bool use_scratch)
+{
+  rec_array_t array;
+  rec_t *scratch;
+  int i;
+  bool ret = true;
+
+  zArrayAlloc( &array, rec_t, n );
+  scratch = use_scratch ? zAlloc( rec_t, n ) : NULL;
+  for( i=0; i<n; i++ ){
+    zArrayElemNC(&array,i)->key = zRandI( 0, 10 );
+    zArrayElemNC(&array,i)->id = i;
+  }
+  if( !zMergeSort( zArrayBuf(&array), n, sizeof(rec_t), cmp_rec, NULL, scratch ) ) ret = false;
+  for( i=1; i<n; i++ ){
+    if( zArrayElemNC(&array,i-1)->key > zArrayElemNC(&array,i)->key ) ret = false;
+    if( zArrayElemNC(&array,i-1)->key == zArrayElemNC(&array,i)->key &&
+        zArrayElemNC(&array,i-1)->id > zArrayElemNC(&array,i)->id ) ret = false;
+  }
+  zArrayMergeSort( &array, cmp_rec, NULL ); /* already sorted */
+  for( i=1; i<n; i++ )
+    if( zArrayElemNC(&array,i-1)->id > zArrayElemNC(&array,i)->id &&
+        zArrayElemNC(&array,i-1)->key == zArrayElemNC(&array,i)->key ) ret = false;
+  zArrayFree( &array );
+  zFree( scratch );
+  return ret;
+}
+
+#define NRUN 7
+
+bool assert_mergesorted(void)
+{
+  rec_t *src[NRUN], *dest;
+  size_t nmemb[NRUN], n = 0;
+  int i, j, k = 0;
+  bool ret = true;
+
+  for( i=0; i<NRUN; i++ ){
+    nmemb[i] = i == 3 ? 0 : zRandI( 1, 1000 );
+    src[i] = zAlloc( rec_t, nmemb[i] );
+    for( j=0; j<nmemb[i]; j++ ){
+      src[i][j].key = zRandI( 0, 100 );
+      src[i][j].id = k++;
+    }
+    zMergeSort( src[i], nmemb[i], sizeof(rec_t), cmp_rec, NULL, NULL );
+    n += nmemb[i];
+  }
+  dest = zAlloc( rec_t, n );
+  if( !zMergeSorted( dest, (void **)src, nmemb, NRUN, sizeof(rec_t), cmp_rec, NULL ) ) ret = false;
+  for( i=1; i<n; i++ ){
+    if( dest[i-1].key > dest[i].key ) ret = false;
+    if( dest[i-1].key == dest[i].key && dest[i-1].id > dest[i].id ) ret = false; /* stability */
+  }
+  for( k=0, i=0; i<n; i++ ) k += dest[i].id;
+  if( k != n*(n-1)/2 ) ret = false;
+  for( i=0; i<NRUN; i++ ) zFree( src[i] );
+  zFree( dest );
+  return ret;
+}
+
+bool assert_nthelement(int n, int range)
+{
+  int *array, *sorted, i, k;
+  bool ret = true;
+
+  array = zAlloc( int, n );
+  sorted = zAlloc( int, n );
+  for( i=0; i<n; i++ )
+    sorted[i] = zRandI( 0, range );
+  memcpy( array, sorted, sizeof(int)*n );
+  zQuickSort( sorted, n, sizeof(int), cmp, NULL );
+  for( k=0; k<n; k+=n/10+1 ){
+    if( *(int*)zNthElement( array, n, sizeof(int), k, cmp, NULL ) != sorted[k] ) ret = false;
+    for( i=0; i<k; i++ )
+      if( array[i] > array[k] ) ret = false;
+    for( i=k+1; i<n; i++ )
+      if( array[i] < array[k] ) ret = false;
+  }
+  if( zNthElement( array, n, sizeof(int), n, cmp, NULL ) ) ret = false;
+  free( array );
+  free( sorted );
+  return ret;
+}
+
+bool assert_partialsort(int n, int k)
+{
+  int *array, *sorted, i;
+  bool ret = true;
+
+  array = zAlloc( int, n );
+  sorted = zAlloc( int, n );
+  for( i=0; i<n; i++ )
+    sorted[i] = zRandI( -1000, 1000 );
+  memcpy( array, sorted, sizeof(int)*n );
+  zQuickSort( sorted, n, sizeof(int), cmp, NULL );
+  zPartialSort( array, n, sizeof(int), k, cmp, NULL );
+  for( i=0; i<k && i<n; i++ )
+    if( array[i] != sorted[i] ) ret = false;
+  free( array );
+  free( sorted );
+  return ret;
+}
+
+bool assert_topk(int n, int k)
+{
+  zTopK topk;
+  int *array, *best, i, val;
+  bool ret = true;
+
+  array = zAlloc( int, n );
+  best = zAlloc( int, k );
+  zTopKInit( &topk, k, sizeof(int), cmp, NULL );
+  for( i=0; i<n; i++ ){
+    array[i] = val = zRandI( -1000, 1000 );
+    zTopKPush( &topk, &val );
+    if( zTopKNum(&topk) != ( i < k ? i+1 : k ) ) ret = false;
+  }
+  zQuickSort( array, n, sizeof(int), cmp, NULL );
+  if( zTopKSort( &topk, best ) != ( n < k ? n : k ) ) ret = false;
+  for( i=0; i<zTopKNum(&topk); i++ )
+    if( best[i] != array[i] ) ret = false;
+  if( zTopKNum(&topk) > 0 && *(int*)zTopKWorst(&topk) != best[zTopKNum(&topk)-1] ) ret = false;
+  zTopKDestroy( &topk );
+  free( array );
+  free( best );
+  return ret;
+}
+
 #define N 100
 
 int main(void)
 {
   zAssert( zArrayQuickSort, assert_quicksort( N ) );
   zAssert( zAssertInsertSort, assert_insertsort( N ) );
+  zAssert( zArrayAdd + zArrayReserve + zArrayInsertRange + zArrayEraseRange, assert_vector( 1000 ) );
+  zAssert( zArraySortDef (random), assert_sortdef( 100000, 0 ) && assert_sortdef( 5, 0 ) && assert_sortdef( 0, 0 ) );
+  zAssert( zArraySortDef (sorted/reversed/equal/organ pipe),
+    assert_sortdef( 10000, 1 ) && assert_sortdef( 10000, 2 ) && assert_sortdef( 10000, 3 ) && assert_sortdef( 10000, 4 ) );
+  zAssert( zArraySortDef (heap sort), assert_sortdef( 10000, 5 ) );
+  zAssert( zArraySortDef (struct), assert_sortdef_struct( 10000 ) );
+  zAssert( zParallelSort,
+    assert_parallelsort( 100000, 4, 0 ) && assert_parallelsort( 10007, 3, 100 ) &&
+    assert_parallelsort( 10, 4, 0 ) && assert_parallelsort( 0, 4, 0 ) );
+  zAssert( zParallelSort (determinism), assert_parallelsort_determinism( 5000 ) );
+  zAssert( zRadixSortInt32 + zRadixSortInt64 + zRadixSortFloat + zRadixSortDouble,
+    assert_radixsort( 10000 ) && assert_radixsort( 1 ) && assert_radixsort( 0 ) );
+  zAssert( zRadixSortKey + zRadixSortPerm, assert_radixsort_key( 10000 ) );
+  zAssert( zArrayFlatSetDef, assert_flatset( 1000 ) && assert_flatset( 1 ) );
+  zAssert( zArrayFlatMapDef, assert_flatmap() );
+  zAssert( zMergeSort,
+    assert_mergesort( 10000, false ) && assert_mergesort( 10000, true ) &&
+    assert_mergesort( 17, false ) && assert_mergesort( 1, false ) && assert_mergesort( 0, false ) );
+  zAssert( zMergeSorted, assert_mergesorted() );
+  zAssert( zNthElement,
+    assert_nthelement( 10000, 1000000 ) && assert_nthelement( 10000, 3 ) && assert_nthelement( 10, 100 ) );
+  zAssert( zPartialSort,
+    assert_partialsort( 10000, 100 ) && assert_partialsort( 10000, 5000 ) && assert_partialsort( 100, 100 ) && assert_partialsort( 10, 20 ) && assert_partialsort( 10, 0 ) );
+  zAssert( zTopK, assert_topk( 10000, 50 ) && assert_topk( 10, 50 ) );
   return EXIT_SUCCESS;
 }
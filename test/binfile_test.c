@@ -1,5 +1,6 @@
 #include <unistd.h>
 #include <zeda/zeda.h>
+#include <math.h>
 
 #define N 100
 
@@ -200,6 +201,7 @@ bool assert_binfile_IO(zBinFile *bf)
   long lval_src[N], lval_out[N];
   float fval_src[N], fval_out[N];
   double dval_src[N], dval_out[N];
+  bool result;
 
   zBinFileOpen( bf, TEST_ZBD_FILE, "wb" );
   zBinFileHeaderFWrite( bf );
@@ -208,11 +210,537 @@ bool assert_binfile_IO(zBinFile *bf)
 
   zBinFileOpen( bf, TEST_ZBD_FILE, "rb" );
   zBinFileHeaderFRead( bf );
+  result = bf->version == 1 && bf->flags == 0; /* readable by readers of version 1 */
   binfile_read_test( bf, ival_out, lval_out, fval_out, dval_out );
   zBinFileClose( bf );
 
   unlink( TEST_ZBD_FILE );
-  return binfile_check( ival_src, ival_out, lval_src, lval_out, fval_src, fval_out, dval_src, dval_out );
+  return result && binfile_check( ival_src, ival_out, lval_src, lval_out, fval_src, fval_out, dval_src, dval_out );
+}
+
+#define NA 10000
+
+bool assert_binfile_array_IO(zBinFile *bf)
+{
+  static int ival_src[NA], ival_out[NA];
+  static long lval_src[NA], lval_out[NA];
+  static float fval_src[NA], fval_out[NA];
+  static double dval_src[NA], dval_out[NA];
+  register int i;
+  bool result = true;
+
+  for( i=0; i<NA; i++ ){
+    ival_src[i] = zRandI( -32767, 32767 );
+    lval_src[i] = zRandI( -32767, 32767 );
+    fval_src[i] = zRandF( -1.0e10, 1.0e10 );
+    dval_src[i] = zRandF( -1.0e10, 1.0e10 );
+  }
+  zBinFileOpen( bf, TEST_ZBD_FILE, "wb" );
+  zBinFileHeaderFWrite( bf );
+  if( zBinFileIntNFWrite( bf, ival_src, NA ) != NA ||
+      zBinFileLongNFWrite( bf, lval_src, NA ) != NA ||
+      zBinFileFloatNFWrite( bf, fval_src, NA ) != NA ||
+      zBinFileDoubleNFWrite( bf, dval_src, NA ) != NA ) result = false;
+  zBinFileClose( bf );
+
+  /* bulk-written values are readable one by one */
+  zBinFileOpen( bf, TEST_ZBD_FILE, "rb" );
+  zBinFileHeaderFRead( bf );
+  for( i=0; i<NA; i++ ) if( zBinFileIntFRead( bf ) != ival_src[i] ) result = false;
+  for( i=0; i<NA; i++ ) if( zBinFileLongFRead( bf ) != lval_src[i] ) result = false;
+  for( i=0; i<NA; i++ ) if( zBinFileFloatFRead( bf ) != fval_src[i] ) result = false;
+  for( i=0; i<NA; i++ ) if( zBinFileDoubleFRead( bf ) != dval_src[i] ) result = false;
+  zBinFileClose( bf );
+
+  zBinFileOpen( bf, TEST_ZBD_FILE, "rb" );
+  zBinFileHeaderFRead( bf );
+  if( zBinFileIntNFRead( bf, ival_out, NA ) != NA ||
+      zBinFileLongNFRead( bf, lval_out, NA ) != NA ||
+      zBinFileFloatNFRead( bf, fval_out, NA ) != NA ||
+      zBinFileDoubleNFRead( bf, dval_out, NA ) != NA ||
+      zBinFileDoubleNFRead( bf, dval_out, 1 ) != 0 ) result = false;
+  zBinFileClose( bf );
+  for( i=0; i<NA; i++ ){
+    if( ival_src[i] != ival_out[i] ||
+        lval_src[i] != lval_out[i] ||
+        fval_src[i] != fval_out[i] ||
+        dval_src[i] != dval_out[i] ) result = false;
+  }
+  unlink( TEST_ZBD_FILE );
+  return result;
+}
+
+bool assert_binfile_map(zBinFile *bf, bool align)
+{
+  zBinFileMap map;
+  int ival[N];
+  long lval[N];
+  float fval[N];
+  double dval[N];
+  const int *ip;
+  const long *lp;
+  const float *fp;
+  const double *dp;
+  register int i;
+  bool result = true;
+
+  for( i=0; i<N; i++ ){
+    ival[i] = zRandI( -32767, 32767 );
+    lval[i] = zRandI( -32767, 32767 );
+    fval[i] = zRandF( -1.0e10, 1.0e10 );
+    dval[i] = zRandF( -1.0e10, 1.0e10 );
+  }
+  zBinFileOpen( bf, TEST_ZBD_FILE, "wb" );
+  zBinFileHeaderFWrite( bf );
+  zBinFileByteFWrite( bf, 0xff );
+  if( align ) zBinFileAlignFWrite( bf, sizeof(double) );
+  zBinFileDoubleNFWrite( bf, dval, N );
+  zBinFileIntNFWrite( bf, ival, N );
+  if( align ) zBinFileAlignFWrite( bf, sizeof(long) );
+  zBinFileLongNFWrite( bf, lval, N );
+  zBinFileFloatNFWrite( bf, fval, N );
+  zBinFileClose( bf );
+
+  if( !zBinFileMapOpen( &map, TEST_ZBD_FILE ) ) return false;
+  if( *zBinFileMapBytes( &map, 1 ) != 0xff ) result = false;
+  if( align ) zBinFileMapAlign( &map, sizeof(double) );
+  dp = zBinFileMapDoubleArray( &map, N );
+  if( align && zBinFileMapIsZeroCopy( &map ) && dp != (double *)( map._buf + zBinFileMapTell(&map) ) - N ) result = false;
+  for( i=0; i<N; i++ ) if( dp[i] != dval[i] ) result = false;
+  ip = zBinFileMapIntArray( &map, N );
+  for( i=0; i<N; i++ ) if( ip[i] != ival[i] ) result = false;
+  if( align ) zBinFileMapAlign( &map, sizeof(long) );
+  lp = zBinFileMapLongArray( &map, N );
+  for( i=0; i<N; i++ ) if( lp[i] != lval[i] ) result = false;
+  fp = zBinFileMapFloatArray( &map, N );
+  for( i=0; i<N; i++ ) if( fp[i] != fval[i] ) result = false;
+  if( !zBinFileMapIsEOF( &map ) || zBinFileMapFloatArray( &map, 1 ) ) result = false;
+  zBinFileMapClose( &map );
+  unlink( TEST_ZBD_FILE );
+  return result;
+}
+
+bool assert_binfile_compressed(zBinFile *bf)
+{
+  zBinFile cbf;
+  zBinFileMap map;
+  int ival_src[N], ival_out[N];
+  long lval_src[N], lval_out[N];
+  float fval_src[N], fval_out[N];
+  double dval_src[N], dval_out[N];
+  static double bulk_src[NA], bulk_out[NA];
+  long pos[4];
+  size_t size;
+  void *payload;
+  register int i;
+  bool result;
+
+  for( i=0; i<NA; i++ ) bulk_src[i] = i % 100;
+  cbf = *bf;
+  zBinFileSetCompress( &cbf, 1000 );
+  zBinFileOpen( &cbf, TEST_ZBD_FILE, "wb" );
+  zBinFileHeaderFWrite( &cbf );
+  binfile_write_test( &cbf, ival_src, lval_src, fval_src, dval_src );
+  pos[0] = zBinFileTell( &cbf );
+  zBinFileDoubleNFWrite( &cbf, bulk_src, NA );
+  pos[1] = zBinFileTell( &cbf );
+  zBinFileClose( &cbf );
+
+  zBinFileOpen( &cbf, TEST_ZBD_FILE, "rb" );
+  zBinFileHeaderFRead( &cbf );
+  result = zBinFileIsCompressed( &cbf ) && cbf.version == 2;
+  binfile_read_test( &cbf, ival_out, lval_out, fval_out, dval_out );
+  if( !binfile_check( ival_src, ival_out, lval_src, lval_out, fval_src, fval_out, dval_src, dval_out ) ||
+      zBinFileTell( &cbf ) != pos[0] ||
+      zBinFileDoubleNFRead( &cbf, bulk_out, NA ) != NA || memcmp( bulk_src, bulk_out, sizeof(bulk_src) ) != 0 ||
+      zBinFileDoubleNFRead( &cbf, bulk_out, 1 ) != 0 ) result = false;
+  /* random access */
+  for( i=0; i<10; i++ ){
+    pos[2] = zRandI( 0, NA-1 );
+    if( !zBinFileSeek( &cbf, pos[0] + sizeof(double)*pos[2] ) ||
+        zBinFileDoubleFRead( &cbf ) != bulk_src[pos[2]] ) result = false;
+  }
+  if( !zBinFileSeek( &cbf, pos[1] ) || zBinFileTell( &cbf ) != pos[1] ||
+      zBinFileByteFRead( &cbf ) != 0 ) result = false;
+  /* parallel decompression */
+  if( !( payload = zBinFilePayloadFRead( &cbf, &size, 3 ) ) ||
+      size != (size_t)( pos[1] - cbf._dataofs ) ) result = false;
+  else{
+    memcpy( bulk_out, (byte *)payload + ( pos[0] - cbf._dataofs ), sizeof(bulk_out) );
+    if( cbf._endian_type != endian_check() ) endian_reverse64_array( bulk_out, NA );
+    if( memcmp( bulk_out, bulk_src, sizeof(bulk_src) ) != 0 ) result = false;
+  }
+  free( payload );
+  zBinFileClose( &cbf );
+  /* mapped reader */
+  if( !zBinFileMapOpen( &map, TEST_ZBD_FILE ) ||
+      zBinFileMapSize( &map ) != (size_t)pos[1] ||
+      !zBinFileMapSeek( &map, pos[0] ) ||
+      memcmp( zBinFileMapDoubleArray( &map, NA ), bulk_src, sizeof(bulk_src) ) != 0 ) result = false;
+  zBinFileMapClose( &map );
+  unlink( TEST_ZBD_FILE );
+  return result;
+}
+
+#define NREC 500
+
+bool assert_binfile_record(zBinFile *bf, bool compress)
+{
+  zBinFile rbf;
+  zBinFileSchema schema, *sp;
+  zBinFileMap map;
+  long end;
+  FILE *fp;
+  float pos[3];
+  double t;
+  int id;
+  register int i, j;
+  bool result = true;
+
+  zBinFileSchemaInit( &schema );
+  zBinFileSchemaAddField( &schema, "time", ZBINFILE_TYPE_DOUBLE, 1 );
+  zBinFileSchemaAddField( &schema, "id", ZBINFILE_TYPE_INT, 1 );
+  zBinFileSchemaAddField( &schema, "pos", ZBINFILE_TYPE_FLOAT, 3 );
+  rbf = *bf;
+  if( compress ) zBinFileSetCompress( &rbf, 1000 );
+  zBinFileSetRecordIndex( &rbf, &schema );
+  zBinFileOpen( &rbf, TEST_ZBD_FILE, "wb" );
+  zBinFileHeaderFWrite( &rbf );
+  for( i=0; i<NREC; i++ ){
+    zBinFileRecordMark( &rbf, i*0.01 );
+    zBinFileDoubleFWrite( &rbf, i*0.01 );
+    zBinFileIntFWrite( &rbf, i );
+    for( j=0; j<3; j++ ) zBinFileFloatFWrite( &rbf, i+j );
+  }
+  end = zBinFileTell( &rbf );
+  zBinFileClose( &rbf );
+  zBinFileSchemaDestroy( &schema );
+
+  /* footer is not in the mapped payload */
+  if( !zBinFileMapOpen( &map, TEST_ZBD_FILE ) || zBinFileMapSize(&map) != (size_t)end ||
+      !zBinFileMapSeek( &map, end ) || zBinFileMapBytes( &map, 1 ) ) result = false;
+  zBinFileMapClose( &map );
+
+  zBinFileOpen( &rbf, TEST_ZBD_FILE, "rb" );
+  if( !zBinFileHeaderFRead( &rbf ) || zBinFileRecordNum( &rbf ) != NREC ) result = false;
+  if( !( sp = zBinFileRecordSchema( &rbf ) ) || zArraySize(sp) != 3 ||
+      strcmp( zArrayElemNC(sp,2)->name, "pos" ) != 0 ||
+      zArrayElemNC(sp,2)->type != ZBINFILE_TYPE_FLOAT || zArrayElemNC(sp,2)->count != 3 ) result = false;
+  for( j=0; j<20; j++ ){
+    i = zRandI( 0, NREC-1 );
+    if( !zBinFileRecordSeek( &rbf, i ) ||
+        zBinFileDoubleFRead( &rbf ) != i*0.01 || zBinFileIntFRead( &rbf ) != i ) result = false;
+  }
+  if( zBinFileRecordFind( &rbf, 2.345 ) != 235 || zBinFileRecordFind( &rbf, -1 ) != 0 ||
+      zBinFileRecordFind( &rbf, 100 ) != NREC || zBinFileRecordKey( &rbf, 10 ) != 0.1 ) result = false;
+  /* decode a record with the schema */
+  fp = tmpfile();
+  zBinFileRecordSeek( &rbf, 7 );
+  if( !zBinFileRecordFPrint( fp, &rbf ) ) result = false;
+  rewind( fp );
+  if( fscanf( fp, "%lf,%d,%f,%f,%f", &t, &id, &pos[0], &pos[1], &pos[2] ) != 5 ||
+      t != 0.07 || id != 7 || pos[0] != 7 || pos[2] != 9 ) result = false;
+  fclose( fp );
+  zBinFileRecordSeek( &rbf, NREC-1 );
+  zBinFileDoubleFRead( &rbf );
+  zBinFileIntFRead( &rbf );
+  for( j=0; j<3; j++ ) zBinFileFloatFRead( &rbf );
+  if( zBinFileByteFRead( &rbf ) != 0 ) result = false; /* footer is not in the payload */
+  zBinFileClose( &rbf );
+  unlink( TEST_ZBD_FILE );
+  return result;
+}
+
+bool assert_binfile_record_broken(zBinFile *bf)
+{
+  zBinFile rbf;
+  zBinFileSchema schema;
+  FILE *fp;
+  long size;
+  int64_t footerofs, nrec;
+  register int i;
+  bool result = true;
+
+  zBinFileSchemaInit( &schema );
+  zBinFileSchemaAddField( &schema, "identity", ZBINFILE_TYPE_INT, 1 ); /* footer size is a multiple of 16 */
+  rbf = *bf;
+  zBinFileSetRecordIndex( &rbf, &schema );
+  zBinFileOpen( &rbf, TEST_ZBD_FILE, "wb" );
+  zBinFileHeaderFWrite( &rbf );
+  for( i=0; i<NREC; i++ ){
+    zBinFileRecordMark( &rbf, i+1 );
+    zBinFileIntFWrite( &rbf, i );
+  }
+  zBinFileClose( &rbf );
+  zBinFileSchemaDestroy( &schema );
+  /* forge the number of records to fill the footer without its head */
+  fp = fopen( TEST_ZBD_FILE, "r+b" );
+  fseek( fp, 0, SEEK_END );
+  size = ftell( fp ) - ( sizeof(int64_t) + 4 );
+  fseek( fp, size, SEEK_SET );
+  if( fread( &footerofs, sizeof(int64_t), 1, fp ) != 1 ) result = false;
+  nrec = ( size - footerofs ) / ( sizeof(int64_t)*2 );
+  fseek( fp, footerofs, SEEK_SET );
+  fwrite( &nrec, sizeof(int64_t), 1, fp );
+  fclose( fp );
+
+  zBinFileOpen( &rbf, TEST_ZBD_FILE, "rb" );
+  if( zBinFileHeaderFRead( &rbf ) && zBinFileRecordNum( &rbf ) == nrec ) result = false;
+  zBinFileClose( &rbf );
+  unlink( TEST_ZBD_FILE );
+  return result;
+}
+
+bool assert_binfile_async(zBinFile *bf, bool compress)
+{
+  zBinFile abf;
+  zBinFileSchema schema;
+  zBinFileAsyncStat stat;
+  register int i;
+  bool result = true;
+
+  zBinFileSchemaInit( &schema );
+  zBinFileSchemaAddField( &schema, "id", ZBINFILE_TYPE_INT, 1 );
+  zBinFileSchemaAddField( &schema, "val", ZBINFILE_TYPE_DOUBLE, 1 );
+  abf = *bf;
+  if( compress ) zBinFileSetCompress( &abf, 1000 );
+  zBinFileSetRecordIndex( &abf, &schema );
+  zBinFileOpen( &abf, TEST_ZBD_FILE, "wb" );
+  zBinFileHeaderFWrite( &abf );
+  if( !zBinFileSetAsync( &abf, 4, 100, ZBINFILE_ASYNC_BLOCK ) ) result = false;
+  for( i=0; i<NREC; i++ ){
+    zBinFileRecordMark( &abf, i );
+    zBinFileIntFWrite( &abf, i );
+    zBinFileDoubleFWrite( &abf, i*0.1 );
+  }
+  if( zBinFileAsyncGetStat( &abf, &stat ) &&
+      ( stat.nbuf != 4 || stat.maxdepth > 4 || stat.depth > 4 || stat.noverflow != 0 || stat.dropped != 0 ) )
+    result = false;
+  if( zBinFileClose( &abf ) != 0 ) result = false;
+  zBinFileSchemaDestroy( &schema );
+
+  zBinFileOpen( &abf, TEST_ZBD_FILE, "rb" );
+  if( !zBinFileHeaderFRead( &abf ) || zBinFileRecordNum( &abf ) != NREC ) result = false;
+  for( i=0; i<NREC; i++ )
+    if( zBinFileIntFRead( &abf ) != i || zBinFileDoubleFRead( &abf ) != i*0.1 ) result = false;
+  if( !zBinFileRecordSeek( &abf, 123 ) || zBinFileIntFRead( &abf ) != 123 ) result = false;
+  zBinFileClose( &abf );
+  unlink( TEST_ZBD_FILE );
+  return result;
+}
+
+#define NDROP 3
+
+bool assert_binfile_async_drop(zBinFile *bf, int policy)
+{
+  zBinFile abf;
+  zBinFileAsyncStat stat;
+  double val[NDROP*5];
+  long size;
+  register int i, j;
+  bool result = true;
+
+  abf = *bf;
+  zBinFileOpen( &abf, TEST_ZBD_FILE, "wb" );
+  zBinFileHeaderFWrite( &abf );
+  if( !zBinFileSetAsync( &abf, 2, sizeof(double)*NDROP*2, policy ) ) result = false;
+  /* a write larger than the whole ring is always discarded */
+  for( i=0; i<NDROP*5; i++ ) val[i] = -1;
+  if( zBinFileDoubleNFWrite( &abf, val, NDROP*5 ) != ( policy == ZBINFILE_ASYNC_DROP ? NDROP*5 : 0 ) ||
+      zBinFileTell( &abf ) != abf._dataofs ) result = false;
+  /* writes larger than a buffer are stored or discarded as a whole */
+  for( i=0; i<NREC; i++ ){
+    for( j=0; j<NDROP*3; j++ ) val[j] = i;
+    zBinFileDoubleNFWrite( &abf, val, NDROP*3 );
+  }
+  size = zBinFileTell( &abf ) - abf._dataofs;
+  if( !zBinFileAsyncGetStat( &abf, &stat ) ||
+      size % ( sizeof(double)*NDROP*3 ) != 0 ||
+      stat.dropped + size != sizeof(double)*NDROP*( 5 + 3*NREC ) ) result = false;
+  zBinFileClose( &abf );
+
+  zBinFileOpen( &abf, TEST_ZBD_FILE, "rb" );
+  zBinFileHeaderFRead( &abf );
+  for( i=0; i<size/(long)( sizeof(double)*NDROP*3 ); i++ ){
+    if( zBinFileDoubleNFRead( &abf, val, NDROP*3 ) != NDROP*3 || val[0] < 0 ) result = false;
+    for( j=1; j<NDROP*3; j++ )
+      if( val[j] != val[0] ) result = false;
+  }
+  if( zBinFileByteFRead( &abf ) != 0 ) result = false;
+  zBinFileClose( &abf );
+  unlink( TEST_ZBD_FILE );
+  return result;
+}
+
+bool assert_binfile_column(zBinFile *bf)
+{
+  zBinFile cbf;
+  zBinFileSchema schema;
+  double dval[NA], dout[NA];
+  int64_t ival[NA], iout[NA];
+  FILE *fp;
+  long size;
+  double t, v;
+  long long ts;
+  register int i;
+  bool result = true;
+
+  for( i=0; i<NA; i++ ){
+    ival[i] = 1000000 + 10 * i;
+    dval[i] = floor( sin( 0.001 * i ) * 1000 ) / 1024;
+  }
+  ival[1] = -ival[1] * (int64_t)1000000 * 1000000; /* printed without long long */
+  zBinFileSchemaInit( &schema );
+  zBinFileSchemaAddField( &schema, "time", ZBINFILE_TYPE_INT64_COLUMN, NA );
+  zBinFileSchemaAddField( &schema, "angle", ZBINFILE_TYPE_DOUBLE_COLUMN, NA );
+  cbf = *bf;
+  zBinFileSetRecordIndex( &cbf, &schema );
+  zBinFileOpen( &cbf, TEST_ZBD_FILE, "wb" );
+  zBinFileHeaderFWrite( &cbf );
+  zBinFileRecordMark( &cbf, 0 );
+  if( zBinFileInt64ColumnFWrite( &cbf, ival, NA ) != NA ||
+      zBinFileDoubleColumnFWrite( &cbf, dval, NA ) != NA ) result = false;
+  size = zBinFileTell( &cbf ) - cbf._dataofs;
+  zBinFileClose( &cbf );
+  zBinFileSchemaDestroy( &schema );
+  if( size > (long)( sizeof(double) * NA * 2 / 5 ) ) result = false;
+
+  zBinFileOpen( &cbf, TEST_ZBD_FILE, "rb" );
+  if( !zBinFileHeaderFRead( &cbf ) ||
+      zBinFileInt64ColumnFRead( &cbf, iout, NA ) != NA || memcmp( ival, iout, sizeof(int64_t)*NA ) != 0 ||
+      zBinFileDoubleColumnFRead( &cbf, dout, NA ) != NA || memcmp( dval, dout, sizeof(double)*NA ) != 0 ) result = false;
+  fp = tmpfile();
+  zBinFileRecordSeek( &cbf, 0 );
+  if( !zBinFileRecordFPrint( fp, &cbf ) ) result = false;
+  rewind( fp );
+  for( i=0; i<NA; i++ )
+    if( fscanf( fp, "%lld,", &ts ) != 1 || ts != ival[i] ) result = false;
+  for( i=0; i<NA; i++ )
+    if( fscanf( fp, "%lf,", &v ) != 1 || v != dval[i] ) result = false;
+  fclose( fp );
+  zBinFileRecordSeek( &cbf, 0 );
+  if( zBinFileInt64ColumnFRead( &cbf, iout, 10 ) != 10 || iout[9] != ival[9] ||
+      zBinFileDoubleColumnFRead( &cbf, &t, 1 ) != 1 || t != dval[0] ) result = false;
+  zBinFileClose( &cbf );
+  unlink( TEST_ZBD_FILE );
+  return result;
+}
+
+bool assert_binfile_checksum(zBinFile *bf, bool compress)
+{
+  zBinFile cbf;
+  double val[NA], *payload;
+  FILE *fp;
+  size_t size;
+  long ofs;
+  int c;
+  register int i;
+  bool result = true;
+
+  for( i=0; i<NA; i++ ) val[i] = i % 100;
+  cbf = *bf;
+  if( compress ) zBinFileSetCompress( &cbf, 1000 );
+  zBinFileSetChecksum( &cbf );
+  zBinFileOpen( &cbf, TEST_ZBD_FILE, "wb" );
+  zBinFileHeaderFWrite( &cbf );
+  zBinFileDoubleNFWrite( &cbf, val, NA );
+  zBinFileClose( &cbf );
+
+  zBinFileOpen( &cbf, TEST_ZBD_FILE, "rb" );
+  if( !zBinFileHeaderFRead( &cbf ) || !zBinFileIsChecksummed( &cbf ) ||
+      zBinFileVerify( &cbf, 1 ) != 0 || zBinFileVerify( &cbf, 4 ) != 0 ) result = false;
+  for( i=0; i<NA; i++ )
+    if( zBinFileDoubleFRead( &cbf ) != val[i] ) result = false;
+  ofs = cbf._dataofs + ( zFileSize( cbf._fp ) - cbf._dataofs ) / 2;
+  zBinFileClose( &cbf );
+  /* break a byte in the middle of the payload */
+  fp = fopen( TEST_ZBD_FILE, "r+b" );
+  fseek( fp, ofs, SEEK_SET );
+  c = fgetc( fp );
+  fseek( fp, ofs, SEEK_SET );
+  fputc( c ^ 0x10, fp );
+  fclose( fp );
+  zBinFileOpen( &cbf, TEST_ZBD_FILE, "rb" );
+  zBinFileHeaderFRead( &cbf );
+  if( zBinFileVerify( &cbf, 4 ) != 1 ) result = false;
+  if( ( payload = zBinFilePayloadFRead( &cbf, &size, 4 ) ) ){
+    free( payload );
+    result = false;
+  }
+  zBinFileClose( &cbf );
+  unlink( TEST_ZBD_FILE );
+  return result;
+}
+
+typedef struct{
+  double t;
+  int id;
+  char flag;
+  float pos[3];
+  long count;
+} sample_t;
+
+static const zBinFileLayoutField sample_fields[] = {
+  ZBINFILE_LAYOUT_FIELD( sample_t, t,     ZBINFILE_TYPE_DOUBLE, 1 ),
+  ZBINFILE_LAYOUT_FIELD( sample_t, id,    ZBINFILE_TYPE_INT,    1 ),
+  ZBINFILE_LAYOUT_FIELD( sample_t, flag,  ZBINFILE_TYPE_BYTE,   1 ),
+  ZBINFILE_LAYOUT_FIELD( sample_t, pos,   ZBINFILE_TYPE_FLOAT,  3 ),
+  ZBINFILE_LAYOUT_FIELD( sample_t, count, ZBINFILE_TYPE_LONG,   1 ),
+};
+
+typedef struct{
+  double t;
+  double val[3];
+} packed_t;
+
+static const zBinFileLayoutField packed_fields[] = {
+  ZBINFILE_LAYOUT_FIELD( packed_t, t,   ZBINFILE_TYPE_DOUBLE, 1 ),
+  ZBINFILE_LAYOUT_FIELD( packed_t, val, ZBINFILE_TYPE_DOUBLE, 3 ),
+};
+
+bool assert_binfile_struct(zBinFile *bf)
+{
+  zBinFile sbf;
+  zBinFileLayout layout, playout;
+  static sample_t src[NA], dst[NA];
+  static packed_t psrc[NA], pdst[NA];
+  register int i, j;
+  bool result = true;
+
+  zBinFileLayoutSet( &layout, sample_t, sample_fields );
+  zBinFileLayoutSet( &playout, packed_t, packed_fields );
+  memset( src, 0, sizeof(src) );
+  memset( dst, 0, sizeof(dst) );
+  for( i=0; i<NA; i++ ){
+    src[i].t = i * 0.001;
+    src[i].id = i - NA/2;
+    src[i].flag = i % 100;
+    for( j=0; j<3; j++ ) src[i].pos[j] = i + j*0.5;
+    src[i].count = -i;
+    psrc[i].t = i;
+    for( j=0; j<3; j++ ) psrc[i].val[j] = zRandF(-1,1);
+  }
+  sbf = *bf;
+  zBinFileOpen( &sbf, TEST_ZBD_FILE, "wb" );
+  zBinFileHeaderFWrite( &sbf );
+  if( zBinFileStructNFWrite( &sbf, &layout, src, NA ) != NA ||
+      zBinFileStructNFWrite( &sbf, &playout, psrc, NA ) != NA ) result = false;
+  zBinFileIntFWrite( &sbf, 12345 );
+  zBinFileClose( &sbf );
+
+  zBinFileOpen( &sbf, TEST_ZBD_FILE, "rb" );
+  zBinFileHeaderFRead( &sbf );
+  if( zBinFileStructNFRead( &sbf, &layout, dst, NA ) != NA ||
+      zBinFileStructNFRead( &sbf, &playout, pdst, NA ) != NA ||
+      zBinFileIntFRead( &sbf ) != 12345 ) result = false;
+  zBinFileClose( &sbf );
+  unlink( TEST_ZBD_FILE );
+  for( i=0; i<NA; i++ ){
+    if( dst[i].t != src[i].t || dst[i].id != src[i].id || dst[i].flag != src[i].flag ||
+        dst[i].pos[2] != src[i].pos[2] || dst[i].count != src[i].count ) result = false;
+  }
+  if( memcmp( psrc, pdst, sizeof(psrc) ) != 0 ) result = false;
+  return result;
 }
 
 int main(int argc, char *argv[])
@@ -223,18 +751,51 @@ int main(int argc, char *argv[])
 
   zBinFileInfoSetThis( &bf );
   zAssert( zBinFile (default), assert_binfile_IO( &bf ) );
+  zAssert( zBinFile array (default), assert_binfile_array_IO( &bf ) );
+  zAssert( zBinFileMap (default), assert_binfile_map( &bf, true ) && assert_binfile_map( &bf, false ) );
+  zAssert( zBinFile compressed (default), assert_binfile_compressed( &bf ) );
+  zAssert( zBinFile record index (default), assert_binfile_record( &bf, false ) && assert_binfile_record( &bf, true ) );
+  zAssert( zBinFile record index (broken footer), assert_binfile_record_broken( &bf ) );
+  zAssert( zBinFile asynchronous writer (default), assert_binfile_async( &bf, false ) && assert_binfile_async( &bf, true ) );
+  zAssert( zBinFile asynchronous writer (drop and count), assert_binfile_async_drop( &bf, ZBINFILE_ASYNC_DROP ) && assert_binfile_async_drop( &bf, ZBINFILE_ASYNC_COUNT ) );
+  zAssert( zBinFile encoded column (default), assert_binfile_column( &bf ) );
+  zAssert( zBinFile checksum (default), assert_binfile_checksum( &bf, false ) && assert_binfile_checksum( &bf, true ) );
+  zAssert( zBinFile struct layout (default), assert_binfile_struct( &bf ) );
 
   zBinFileInfoSet( &bf, 1, Z_ENDIAN_BIG, 4, 8 );
   zAssert( zBinFile (big endian: 32bit int: 64bit long), assert_binfile_IO( &bf ) );
+  zAssert( zBinFile array (big endian: 32bit int: 64bit long), assert_binfile_array_IO( &bf ) );
+  zAssert( zBinFileMap (big endian: 32bit int: 64bit long), assert_binfile_map( &bf, true ) && assert_binfile_map( &bf, false ) );
+  zAssert( zBinFile compressed (big endian: 32bit int: 64bit long), assert_binfile_compressed( &bf ) );
+  zAssert( zBinFile record index (big endian: 32bit int: 64bit long), assert_binfile_record( &bf, false ) && assert_binfile_record( &bf, true ) );
+  zAssert( zBinFile asynchronous writer (big endian: 32bit int: 64bit long), assert_binfile_async( &bf, false ) && assert_binfile_async( &bf, true ) );
+  zAssert( zBinFile encoded column (big endian: 32bit int: 64bit long), assert_binfile_column( &bf ) );
+  zAssert( zBinFile checksum (big endian: 32bit int: 64bit long), assert_binfile_checksum( &bf, false ) && assert_binfile_checksum( &bf, true ) );
+  zAssert( zBinFile struct layout (big endian: 32bit int: 64bit long), assert_binfile_struct( &bf ) );
 
   zBinFileInfoSet( &bf, 1, Z_ENDIAN_BIG, 2, 4 );
   zAssert( zBinFile (big endian: 16bit int: 32bit long), assert_binfile_IO( &bf ) );
+  zAssert( zBinFile array (big endian: 16bit int: 32bit long), assert_binfile_array_IO( &bf ) );
+  zAssert( zBinFile struct layout (big endian: 16bit int: 32bit long), assert_binfile_struct( &bf ) );
+  zAssert( zBinFileMap (big endian: 16bit int: 32bit long), assert_binfile_map( &bf, true ) && assert_binfile_map( &bf, false ) );
+  zAssert( zBinFile compressed (big endian: 16bit int: 32bit long), assert_binfile_compressed( &bf ) );
+  zAssert( zBinFile record index (big endian: 16bit int: 32bit long), assert_binfile_record( &bf, false ) && assert_binfile_record( &bf, true ) );
 
   zBinFileInfoSet( &bf, 1, Z_ENDIAN_LITTLE, 4, 8 );
   zAssert( zBinFile (little endian: 32bit int: 64bit long), assert_binfile_IO( &bf ) );
+  zAssert( zBinFile array (little endian: 32bit int: 64bit long), assert_binfile_array_IO( &bf ) );
+  zAssert( zBinFile struct layout (little endian: 32bit int: 64bit long), assert_binfile_struct( &bf ) );
+  zAssert( zBinFileMap (little endian: 32bit int: 64bit long), assert_binfile_map( &bf, true ) && assert_binfile_map( &bf, false ) );
+  zAssert( zBinFile compressed (little endian: 32bit int: 64bit long), assert_binfile_compressed( &bf ) );
+  zAssert( zBinFile record index (little endian: 32bit int: 64bit long), assert_binfile_record( &bf, false ) && assert_binfile_record( &bf, true ) );
 
   zBinFileInfoSet( &bf, 1, Z_ENDIAN_LITTLE, 2, 4 );
   zAssert( zBinFile (little endian: 16bit int: 32bit long), assert_binfile_IO( &bf ) );
+  zAssert( zBinFile array (little endian: 16bit int: 32bit long), assert_binfile_array_IO( &bf ) );
+  zAssert( zBinFile struct layout (little endian: 16bit int: 32bit long), assert_binfile_struct( &bf ) );
+  zAssert( zBinFileMap (little endian: 16bit int: 32bit long), assert_binfile_map( &bf, true ) && assert_binfile_map( &bf, false ) );
+  zAssert( zBinFile compressed (little endian: 16bit int: 32bit long), assert_binfile_compressed( &bf ) );
+  zAssert( zBinFile record index (little endian: 16bit int: 32bit long), assert_binfile_record( &bf, false ) && assert_binfile_record( &bf, true ) );
 
   return 0;
 }
@@ -22,11 +22,23 @@ ulong compose_bit(ubyte b[], int i0, int i1, int i2, int i3, int i4, int i5, int
   return b[0] << i0 | b[1] << i1 | b[2] << i2 | b[3] << i3 | b[4] << i4 | b[5] << i5 | b[6] << i6 | b[7] << i7;
 }
 
+bool check_crc32c(void)
+{
+  ubyte buf[1000];
+  uint32_t crc;
+  int i;
+
+  for( i=0; i<1000; i++ ) buf[i] = rand();
+  for( crc=0, i=0; i<1000; i+=37 )
+    crc = crc32c( crc, buf + i, i + 37 > 1000 ? 1000 - i : 37 );
+  return crc == crc32c( 0, buf, 1000 ) && crc32c( 0, buf + 1, 999 ) != crc32c( 0, buf, 999 );
+}
+
 #define width 8
 
 int main(void)
 {
-  ubyte b[width];
+  ubyte b[width], zero[32];
   ulong val;
 
   zRandInit();
@@ -54,5 +66,10 @@ int main(void)
   zAssert( endian_reverse64, endian_reverse64(0x12345678abcdefab) == 0xabefcdab78563412 );
 
   zAssert( endian_check, endian_check() == __BYTE_ORDER );
+
+  memset( zero, 0, sizeof(zero) );
+  zAssert( crc32c,
+    crc32c( 0, "123456789", 9 ) == 0xe3069283 &&
+    crc32c( 0, zero, 32 ) == 0x8a9136aa && check_crc32c() );
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,344 @@
+#include <unistd.h>
+#include <utime.h>
+#include <zeda/zeda.h>
+
+#define N 5000
+
+#define TEST_CSV_FILE "test.csv"
+#define TEST_IDX_FILE "test.csv.idx"
+
+void create_test_csv_file(void)
+{
+  FILE *fp;
+  int i;
+
+  if( !( fp = fopen( TEST_CSV_FILE, "wt" ) ) ){
+    ZOPENERROR( TEST_CSV_FILE );
+    exit( EXIT_FAILURE );
+  }
+  fprintf( fp, "%% time stamp,x-value,y-value\n" );
+  for( i=0; i<N; i++ ){
+    if( i % 7 == 3 ) fprintf( fp, "%% comment at %d\n", i );
+    fprintf( fp, "%d,%f,%f\n", i, (double)i/N, (double)i/N-0.5 );
+  }
+  fclose( fp );
+}
+
+bool check_line(zCSV *csv, int i)
+{
+  int t;
+  double x;
+
+  if( !zCSVGoToLine( csv, i ) ) return false;
+  zCSVGetInt( csv, &t );
+  zCSVGetDouble( csv, &x );
+  memset( csv->buf, 0, BUFSIZ );
+  return t == i && x - (double)i/N < 1.0e-6 && (double)i/N - x < 1.0e-6;
+}
+
+bool check_random_access(zCSV *csv)
+{
+  int i;
+
+  if( zCSVLineNum(csv) != N || csv->nf != 3 ) return false;
+  for( i=0; i<N; i+=97 )
+    if( !check_line( csv, i ) ) return false;
+  for( i=0; i<100; i++ )
+    if( !check_line( csv, zRandI(0,N-1) ) ) return false;
+  return check_line( csv, 0 ) && check_line( csv, N-1 );
+}
+
+void assert_sparse_index(void)
+{
+  zCSV csv;
+  struct utimbuf t;
+  FILE *fp;
+  int i;
+  bool result;
+
+  zCSVOpen( &csv, TEST_CSV_FILE );
+  zAssert( zCSVGoToLine (full index), check_random_access( &csv ) );
+  zCSVClose( &csv );
+
+  zCSVOpenSparse( &csv, TEST_CSV_FILE, 16 );
+  result = check_random_access( &csv );
+  zAssert( zCSVGoToLine (sparse index), result );
+  zAssert( zCSVIndexSave, zCSVIndexSave( &csv, TEST_IDX_FILE ) );
+  zCSVClose( &csv );
+
+  zCSVOpenIndex( &csv, TEST_CSV_FILE, TEST_IDX_FILE );
+  result = csv.stride == 16 && check_random_access( &csv );
+  zCSVClose( &csv );
+  zAssert( zCSVOpenIndex, result );
+
+  /* the same size but modified */
+  t.actime = t.modtime = 1000000000;
+  utime( TEST_CSV_FILE, &t );
+  zCSVOpenIndex( &csv, TEST_CSV_FILE, TEST_IDX_FILE );
+  result = csv.stride == ZCSV_DEFAULT_STRIDE && check_random_access( &csv );
+  zCSVClose( &csv );
+  zAssert( zCSVOpenIndex (modified CSV file), result );
+
+  /* broken deltas with valid stamps */
+  zCSVOpenSparse( &csv, TEST_CSV_FILE, 16 );
+  zCSVIndexSave( &csv, TEST_IDX_FILE );
+  zCSVClose( &csv );
+  fp = fopen( TEST_IDX_FILE, "r+b" );
+  fseek( fp, -16, SEEK_END );
+  for( i=0; i<16; i++ ) fputc( 0xff, fp );
+  fclose( fp );
+  zCSVOpenIndex( &csv, TEST_CSV_FILE, TEST_IDX_FILE );
+  result = csv.stride == ZCSV_DEFAULT_STRIDE && check_random_access( &csv );
+  zCSVClose( &csv );
+  zAssert( zCSVOpenIndex (broken index), result );
+  unlink( TEST_IDX_FILE );
+}
+
+void assert_projection(void)
+{
+  zCSV csv;
+  zCSVProjection proj;
+  double val[2];
+  int n = 0;
+  bool result = true;
+
+  zCSVOpen( &csv, TEST_CSV_FILE );
+  zCSVProjectionInit( &proj );
+  zCSVProjectionAddColumn( &proj, 2 );
+  zCSVProjectionAddColumn( &proj, 0 );
+  zCSVProjectionAddFilter( &proj, 0, 100, 199 );
+  zCSVProjectionAddFilter( &proj, 1, 0, 1 );
+  while( zCSVGetProjectedRow( &csv, &proj, val ) ){
+    if( (int)val[1] != 100 + n++ || val[0] - ( val[1]/N-0.5 ) > 1.0e-6 || ( val[1]/N-0.5 ) - val[0] > 1.0e-6 )
+      result = false;
+  }
+  zCSVProjectionDestroy( &proj );
+  zCSVClose( &csv );
+  zAssert( zCSVGetProjectedRow, result && n == 100 );
+}
+
+#define NROW 1000
+#define NCOL 4
+
+bool check_writer(zCSVWriter *(* open)(zCSVWriter*,char*,size_t), size_t size)
+{
+  zCSVWriter w;
+  zCSV csv;
+  zCSVColumn col[2];
+  double dval[NROW][NCOL], dcol[NROW], dout[NCOL];
+  int ival[NROW][NCOL], icol[NROW], iout[NCOL];
+  int i, j;
+  bool result = true;
+
+  for( i=0; i<NROW; i++ ){
+    for( j=0; j<NCOL; j++ ){
+      dval[i][j] = zRandF(-1.0e6,1.0e6) * ( j == 0 ? 1.0e-10 : 1.0 );
+      ival[i][j] = zRandI(-100000,100000);
+    }
+    dval[i][NCOL-1] = (double)ival[i][0];
+    dcol[i] = zRandF(-1.0,1.0);
+    icol[i] = i;
+  }
+  dcol[0] = 0.1; dcol[1] = 1.0e20; dcol[2] = -1.0e300; dcol[3] = 4.0e9; /* edge cases */
+  col[0].type = ZCSV_TYPE_INT;    col[0].data = icol;
+  col[1].type = ZCSV_TYPE_DOUBLE; col[1].data = dcol;
+  open( &w, TEST_CSV_FILE, size );
+  for( i=0; i<NROW; i++ ){
+    zCSVWriterPutDoubleRow( &w, dval[i], NCOL );
+    zCSVWriterPutIntRow( &w, ival[i], NCOL );
+  }
+  zCSVWriterPutColumns( &w, NROW, 2, col );
+  zCSVWriterClose( &w );
+
+  zCSVOpen( &csv, TEST_CSV_FILE );
+  if( zCSVLineNum(&csv) != NROW*3 ) result = false;
+  for( i=0; i<NROW; i++ ){
+    zCSVGetDoubleN( &csv, dout, NCOL );
+    zCSVGetIntN( &csv, iout, NCOL );
+    for( j=0; j<NCOL; j++ )
+      if( dout[j] != dval[i][j] || iout[j] != ival[i][j] ) result = false;
+  }
+  for( i=0; i<NROW; i++ ){
+    zCSVGetInt( &csv, &iout[0] );
+    zCSVGetDouble( &csv, &dout[0] );
+    if( iout[0] != icol[i] || dout[0] != dcol[i] ) result = false;
+  }
+  zCSVClose( &csv );
+  unlink( TEST_CSV_FILE );
+  return result;
+}
+
+bool check_writer_format(void)
+{
+  zCSVWriter w;
+  FILE *fp;
+  char buf[BUFSIZ];
+  bool result;
+
+  zCSVWriterOpen( &w, TEST_CSV_FILE, 0 );
+  zCSVWriterPutDouble( &w, 0.1 );
+  zCSVWriterPutDouble( &w, -1.5 );
+  zCSVWriterPutDouble( &w, 0.1 + 0.2 );
+  zCSVWriterPutDouble( &w, 1.0e20 );
+  zCSVWriterPutDouble( &w, 100 );
+  zCSVWriterEndLine( &w );
+  zCSVWriterClose( &w );
+  fp = fopen( TEST_CSV_FILE, "r" );
+  result = fgets( buf, BUFSIZ, fp ) && strcmp( buf, "0.1,-1.5,0.30000000000000004,1e+20,100\n" ) == 0;
+  fclose( fp );
+  unlink( TEST_CSV_FILE );
+  return result;
+}
+
+void assert_writer(void)
+{
+  zAssert( zCSVWriterPutDouble (shortest format), check_writer_format() );
+  zAssert( zCSVWriter, check_writer( zCSVWriterOpen, 0 ) );
+  zAssert( zCSVWriter (small buffer), check_writer( zCSVWriterOpen, 100 ) );
+  zAssert( zCSVWriter (asynchronous), check_writer( zCSVWriterOpenAsync, 100 ) );
+}
+
+#define TEST_CACHE_FILE "test.csvc"
+
+void create_cache_test_csv_file(const char *label[])
+{
+  FILE *fp;
+  int i;
+
+  if( !( fp = fopen( TEST_CSV_FILE, "wt" ) ) ){
+    ZOPENERROR( TEST_CSV_FILE );
+    exit( EXIT_FAILURE );
+  }
+  fprintf( fp, "%% label,count,(void),value,name\n" );
+  for( i=0; i<N; i++ )
+    fprintf( fp, "%s,%d,,%.2f,#%d\n", label[i%3], i, (double)i/4, i );
+  fclose( fp );
+}
+
+bool check_cache(zCSVCache *cache, const char *label[])
+{
+  int i;
+  double *x;
+  int64_t *t, *e;
+
+  if( zCSVCacheRowNum(cache) != N || zCSVCacheColNum(cache) != 5 ) return false;
+  if( zCSVCacheColType(cache,0) != ZCSV_TYPE_STRING ||
+      zCSVCacheColType(cache,1) != ZCSV_TYPE_INT64 ||
+      zCSVCacheColType(cache,2) != ZCSV_TYPE_INT64 ||
+      zCSVCacheColType(cache,3) != ZCSV_TYPE_DOUBLE ||
+      zCSVCacheColType(cache,4) != ZCSV_TYPE_STRING ) return false;
+  if( cache->col[0].ndict != 3 || cache->col[4].ndict != N ) return false;
+  t = zCSVCacheInt64Col( cache, 1 );
+  e = zCSVCacheInt64Col( cache, 2 );
+  x = zCSVCacheDoubleCol( cache, 3 );
+  if( zCSVCacheDoubleCol( cache, 1 ) || zCSVCacheCodeCol( cache, 3 ) ) return false;
+  for( i=0; i<N; i++ ){
+    if( t[i] != i || e[i] != 0 || x[i] != (double)i/4 ) return false;
+    if( strcmp( zCSVCacheStr(cache,i,0), label[i%3] ) != 0 ) return false;
+    if( atoi( zCSVCacheStr(cache,i,4)+1 ) != i ) return false;
+  }
+  return true;
+}
+
+/* overwrite a 64-bit integer in a file. */
+void overwrite_int64(char filename[], long pos, int64_t val)
+{
+  FILE *fp;
+
+  fp = fopen( filename, "r+b" );
+  fseek( fp, pos, SEEK_SET );
+  fwrite( &val, sizeof(int64_t), 1, fp );
+  fclose( fp );
+}
+
+void assert_cache(void)
+{
+  zCSVCache cache;
+  const char *label[] = { "foo", "bar", "baz" }, *label2[] = { "qux", "quu", "quz" };
+  struct utimbuf t;
+  long pos[2];
+  int64_t footer;
+  FILE *fp;
+  bool result;
+
+  create_cache_test_csv_file( label );
+  unlink( TEST_CACHE_FILE );
+
+  result = zCSVCacheOpen( &cache, TEST_CSV_FILE, TEST_CACHE_FILE ) && check_cache( &cache, label );
+  zCSVCacheClose( &cache );
+  zAssert( zCSVCacheCreate, result );
+  result = zCSVCacheLoad( &cache, TEST_CACHE_FILE ) && check_cache( &cache, label );
+  pos[0] = (byte *)cache.col[0].dictofs - cache._buf;
+  pos[1] = (byte *)cache.col[0].data - cache._buf;
+  zCSVCacheClose( &cache );
+  zAssert( zCSVCacheLoad, result );
+
+  /* the same size but modified */
+  create_cache_test_csv_file( label2 );
+  t.actime = t.modtime = 1000000000;
+  utime( TEST_CSV_FILE, &t );
+  result = zCSVCacheOpen( &cache, TEST_CSV_FILE, TEST_CACHE_FILE ) && check_cache( &cache, label2 );
+  zCSVCacheClose( &cache );
+  zAssert( zCSVCacheOpen (modified CSV file), result );
+
+  /* broken dictionary */
+  overwrite_int64( TEST_CACHE_FILE, pos[0], 0x10000000 );
+  result = zCSVCacheLoad( &cache, TEST_CACHE_FILE ) == NULL;
+  zCSVCacheOpen( &cache, TEST_CSV_FILE, TEST_CACHE_FILE );
+  zCSVCacheClose( &cache );
+  overwrite_int64( TEST_CACHE_FILE, pos[1], 0x7fffffff7fffffff );
+  if( zCSVCacheLoad( &cache, TEST_CACHE_FILE ) ) result = false;
+  /* number of rows out of the range of int */
+  zCSVCacheOpen( &cache, TEST_CSV_FILE, TEST_CACHE_FILE );
+  zCSVCacheClose( &cache );
+  fp = fopen( TEST_CACHE_FILE, "rb" );
+  fseek( fp, -(long)sizeof(int64_t), SEEK_END );
+  if( fread( &footer, sizeof(int64_t), 1, fp ) != 1 ) result = false;
+  fclose( fp );
+  overwrite_int64( TEST_CACHE_FILE, footer + sizeof(int64_t)*2, ( (int64_t)1 << 32 ) + N );
+  if( zCSVCacheLoad( &cache, TEST_CACHE_FILE ) ) result = false;
+  zAssert( zCSVCacheLoad (broken file), result );
+  unlink( TEST_CACHE_FILE );
+}
+
+#define TEST_EMPTY_FILE "empty.csv"
+
+void assert_empty(void)
+{
+  zCSV csv;
+  zCSVCache cache;
+  FILE *fp;
+  bool result = true;
+
+  if( !( fp = fopen( TEST_EMPTY_FILE, "wt" ) ) ){
+    ZOPENERROR( TEST_EMPTY_FILE );
+    exit( EXIT_FAILURE );
+  }
+  fclose( fp );
+  if( !zCSVOpenSparse( &csv, TEST_EMPTY_FILE, 16 ) ) result = false;
+  else{
+    if( zCSVLineNum(&csv) != 0 || csv.nf != 0 || zCSVGoToLine( &csv, 0 ) ) result = false;
+    zCSVRewind( &csv );
+    zCSVClose( &csv );
+  }
+  zAssert( zCSVOpenSparse (empty file), result );
+  unlink( TEST_CACHE_FILE );
+  result = zCSVCacheOpen( &cache, TEST_EMPTY_FILE, TEST_CACHE_FILE ) && cache.nrow == 0 && cache.ncol == 0;
+  zCSVCacheClose( &cache );
+  zAssert( zCSVCacheCreate (empty file), result );
+  unlink( TEST_CACHE_FILE );
+  unlink( TEST_EMPTY_FILE );
+}
+
+int main(void)
+{
+  zRandInit();
+  create_test_csv_file();
+  assert_sparse_index();
+  assert_projection();
+  assert_writer();
+  assert_cache();
+  assert_empty();
+  unlink( TEST_CSV_FILE );
+  return EXIT_SUCCESS;
+}
@@ -70,6 +70,31 @@ void assert_index_remove(void)
   zAssert( zIndexRemove, res );
 }
 
+int cmp_int(void *v1, void *v2, void *dummy)
+{
+  if( *(int*)v1 > *(int*)v2 ) return 1;
+  if( *(int*)v1 < *(int*)v2 ) return -1;
+  return 0;
+}
+
+void assert_index_radixsort(void)
+{
+  zIndex index, index_cmp;
+  int i;
+  bool res;
+
+  index = zIndexAlloc( 1000 );
+  index_cmp = zIndexAlloc( 1000 );
+  for( i=0; i<zArraySize(index); i++ )
+    zIndexSetElemNC( index, i, zIndexSetElemNC( index_cmp, i, zRandI( -100000, 100000 ) ) );
+  zIndexRadixSort( index );
+  zArrayQuickSort( index_cmp, cmp_int, NULL );
+  res = zIndexIsEqual( index, index_cmp );
+  zIndexFree( index_cmp );
+  zIndexFree( index );
+  zAssert( zIndexRadixSort, res );
+}
+
 int main(void)
 {
   zRandInit();
@@ -77,5 +102,6 @@ int main(void)
   assert_index_swap();
   assert_index_move();
   assert_index_remove();
+  assert_index_radixsort();
   return EXIT_SUCCESS;
 }
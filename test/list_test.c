@@ -0,0 +1,84 @@
+#include <zeda/zeda.h>
+
+typedef struct{
+  int key;
+  int id;
+} rec_t;
+zListClass( rec_list_t, rec_list_cell_t, rec_t );
+zListQuickSortDef( rec_list_t, rec_list_cell_t )
+zListMergeSortDef( rec_list_t, rec_list_cell_t )
+
+int cmp(void *v1, void *v2, void *dummy)
+{
+  if( ((rec_list_cell_t*)v1)->data.key > ((rec_list_cell_t*)v2)->data.key ) return 1;
+  if( ((rec_list_cell_t*)v1)->data.key < ((rec_list_cell_t*)v2)->data.key ) return -1;
+  return 0;
+}
+
+void create_list(rec_list_t *list, int n, int range)
+{
+  rec_list_cell_t *cp;
+  int i;
+
+  zListInit( list );
+  for( i=0; i<n; i++ ){
+    cp = zAlloc( rec_list_cell_t, 1 );
+    cp->data.key = zRandI( 0, range );
+    cp->data.id = i;
+    zListInsertHead( list, cp );
+  }
+}
+
+bool check_list(rec_list_t *list, int n)
+{
+  rec_list_cell_t *cp;
+  int i = 0;
+
+  if( zListSize(list) != n ) return false;
+  zListForEach( list, cp ){
+    if( zListCellPrev(zListCellNext(cp)) != cp ) return false;
+    i++;
+  }
+  if( i != n || zListCellNext(zListHead(list)) != zListRoot(list) ) return false;
+  return true;
+}
+
+bool assert_list_mergesort(int n)
+{
+  rec_list_t list, list2;
+  rec_list_cell_t *cp, *cp2;
+  bool ret = true;
+
+  /* same order with quick sort */
+  zRandInit();
+  create_list( &list, n, n*10 );
+  zRandInit();
+  create_list( &list2, n, n*10 );
+  rec_list_tMergeSort( &list, cmp, NULL );
+  rec_list_tQuickSort( &list2, cmp, NULL );
+  if( !check_list( &list, n ) ) ret = false;
+  for( cp=zListTail(&list), cp2=zListTail(&list2); cp!=zListRoot(&list); cp=zListCellNext(cp), cp2=zListCellNext(cp2) )
+    if( cp->data.key != cp2->data.key ) ret = false;
+  zListDestroy( rec_list_cell_t, &list );
+  zListDestroy( rec_list_cell_t, &list2 );
+  /* stability */
+  create_list( &list, n, 5 );
+  rec_list_tMergeSort( &list, cmp, NULL );
+  if( !check_list( &list, n ) ) ret = false;
+  zListForEach( &list, cp ){
+    if( zListCellNext(cp) == zListRoot(&list) ) break;
+    cp2 = zListCellNext(cp);
+    if( cp->data.key > cp2->data.key ) ret = false;
+    if( cp->data.key == cp2->data.key && cp->data.id > cp2->data.id ) ret = false;
+  }
+  zListDestroy( rec_list_cell_t, &list );
+  return ret;
+}
+
+int main(void)
+{
+  zAssert( zListMergeSortDef,
+    assert_list_mergesort( 1000 ) && assert_list_mergesort( 1025 ) &&
+    assert_list_mergesort( 1 ) && assert_list_mergesort( 0 ) );
+  return EXIT_SUCCESS;
+}
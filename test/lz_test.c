@@ -0,0 +1,40 @@
+#include <zeda/zeda.h>
+
+#define N 100000
+
+bool check_lz(ubyte src[], size_t size)
+{
+  static ubyte comp[zLZCompressBound(N)], dst[N];
+  size_t compsize;
+
+  if( ( compsize = zLZCompress( src, size, comp, zLZCompressBound(size) ) ) == 0 ) return false;
+  return zLZDecompress( comp, compsize, dst, size ) == size && memcmp( src, dst, size ) == 0;
+}
+
+int main(void)
+{
+  static ubyte src[N], comp[zLZCompressBound(N)], dst[N];
+  size_t i, compsize;
+  bool result;
+
+  zRandInit();
+  for( i=0; i<N; i++ ) src[i] = zRandI( 0, 255 );
+  zAssert( zLZCompress + zLZDecompress (random), check_lz( src, N ) );
+  for( i=0; i<N; i++ ) src[i] = "the quick brown fox jumps over the lazy dog. "[zRandI(0,9)+i%35];
+  zAssert( zLZCompress + zLZDecompress (text), check_lz( src, N ) );
+  memset( src, 'a', N );
+  compsize = zLZCompress( src, N, comp, zLZCompressBound(N) );
+  zAssert( zLZCompress (repetition), compsize > 0 && compsize < N / 100 );
+  zAssert( zLZDecompress (repetition), zLZDecompress( comp, compsize, dst, N ) == N && memcmp( src, dst, N ) == 0 );
+  result = true;
+  for( i=0; i<300; i++ )
+    if( !check_lz( src, i ) ) result = false;
+  zAssert( zLZCompress + zLZDecompress (short data), result );
+
+  for( i=0; i<N; i++ ) src[i] = i % 1000 < 500 ? zRandI( 0, 255 ) : src[i%500];
+  compsize = zLZCompress( src, N, comp, zLZCompressBound(N) );
+  zAssert( zLZCompress (insufficient buffer), zLZCompress( src, N, comp, compsize - 1 ) == 0 );
+  zAssert( zLZDecompress (insufficient buffer), zLZDecompress( comp, compsize, dst, N - 1 ) == 0 );
+  zAssert( zLZDecompress (truncated data), zLZDecompress( comp, compsize / 2, dst, N ) < N );
+  return EXIT_SUCCESS;
+}
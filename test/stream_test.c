@@ -0,0 +1,362 @@
+#include <zeda/zeda.h>
+
+#define N 200000
+
+bool check_getc(zStream *str, byte *data, size_t size)
+{
+  size_t i;
+
+  zStreamRewind( str );
+  for( i=0; i<size; i++ )
+    if( zStreamGetc( str ) != (ubyte)data[i] ) return false;
+  return zStreamGetc( str ) == EOF && zStreamPeek( str ) == EOF;
+}
+
+bool check_mixed(zStream *str, byte *data, size_t size)
+{
+  static byte buf[N];
+  size_t i, n;
+  int c;
+
+  zStreamRewind( str );
+  for( i=0; i<size; ){
+    if( ( c = zStreamPeek( str ) ) != (ubyte)data[i] ) return false;
+    if( zStreamGetc( str ) != c ) return false;
+    if( zStreamUngetc( str, c ) != c || zStreamGetc( str ) != c ) return false;
+    if( zStreamTell( str ) != (long)++i ) return false;
+    n = zMin( zRandI( 0, ZSTREAM_BUFSIZ ), size - i );
+    if( zStreamRead( str, buf, 1, n ) != n || memcmp( buf, data+i, n ) != 0 ) return false;
+    i += n;
+    if( zStreamTell( str ) != (long)i ) return false;
+  }
+  n = zRandI( 0, size-1 );
+  zStreamSeek( str, n );
+  return zStreamGetc( str ) == (ubyte)data[n];
+}
+
+bool check_mmap(byte *data, size_t size)
+{
+  zStream str;
+  static byte buf[N];
+  const byte *view;
+  bool ret = true;
+
+  /* read-write mapping of a pre-sized file */
+  if( !zStreamOpenMmap( &str, "stream_test.map", "w", size ) ) return false;
+  if( !zStreamIsMapped( &str ) ) ret = false;
+  if( zStreamWrite( &str, data, 1, size ) != size ) ret = false;
+  if( zStreamWrite( &str, data, 1, 1 ) != 0 ) ret = false; /* no room */
+  zStreamClose( &str );
+  /* read-only mapping */
+  if( !zStreamOpenMmap( &str, "stream_test.map", "r", 0 ) ) return false;
+  zStreamAdvise( &str, ZSTREAM_ADVICE_SEQUENTIAL );
+  if( zStreamRead( &str, buf, 1, size ) != size || memcmp( buf, data, size ) ) ret = false;
+  zStreamSeek( &str, 10 );
+  if( zStreamGetc( &str ) != (ubyte)data[10] ) ret = false;
+  if( !( view = zStreamView( &str, 100 ) ) || memcmp( view, data+11, 100 ) ) ret = false;
+  if( zStreamTell( &str ) != 111 ) ret = false;
+  if( zStreamView( &str, size ) ) ret = false;
+  if( zStreamWrite( &str, data, 1, 1 ) != 0 ) ret = false;
+  zStreamClose( &str );
+  remove( "stream_test.map" );
+  return ret;
+}
+
+bool check_growmem(byte *data, size_t size)
+{
+  zStream str;
+  static byte buf[N];
+  byte *mem;
+  size_t i, n, memsize;
+  bool ret = true;
+
+  if( !zStreamOpenGrowMem( &str, 0 ) ) return false;
+  for( i=0; i<size; i+=n ){
+    n = zMin( zRandI( 1, 1000 ), size - i );
+    if( zStreamWrite( &str, data+i, 1, n ) != n || zStreamTell( &str ) != (long)(i+n) ) ret = false;
+  }
+  if( zStreamSeek( &str, size + 1 ) == 0 || zStreamSeek( &str, 100 ) != 0 ) ret = false;
+  if( zStreamTell( &str ) != 100 || zStreamRead( &str, buf, 1, size ) != size - 100 ) ret = false;
+  if( memcmp( buf, data+100, size-100 ) ) ret = false;
+  zStreamRewind( &str );
+  if( zStreamWrite( &str, data+1, 1, 1 ) != 1 || zStreamGetc( &str ) != (ubyte)data[1] ) ret = false;
+  if( !zStreamReserve( &str, 2*size ) || zStreamTell( &str ) != 2 ) ret = false;
+  mem = zStreamDetachBuf( &str, &memsize );
+  if( !mem || memsize != size || mem[0] != data[1] || memcmp( mem+1, data+1, size-1 ) ) ret = false;
+  if( zStreamRead( &str, buf, 1, 1 ) != 0 ) ret = false;
+  free( mem );
+  zStreamClose( &str );
+
+  if( !zStreamOpenMem( &str, 10 ) ) return false;
+  if( zStreamWrite( &str, data, 4, 2 ) != 2 || zStreamWrite( &str, data, 4, 2 ) != 0 ) ret = false;
+  if( zStreamTell( &str ) != 8 ) ret = false;
+  zStreamClose( &str );
+  return ret;
+}
+
+#define NFILE 50
+
+bool check_aio(byte *data, size_t size)
+{
+  zStreamAIO aio;
+  zStreamAIOReq req[NFILE+2], *rp;
+  char filename[NFILE][BUFSIZ];
+  static byte range[1000];
+  zStream str;
+  FILE *fp;
+  int i, n = 0;
+  bool ret = true;
+
+  for( i=0; i<NFILE; i++ ){
+    sprintf( filename[i], "stream_test_aio%d.dat", i );
+    fp = fopen( filename[i], "wb" );
+    fwrite( data + i, 1, 1000 + i, fp );
+    fclose( fp );
+    req[i].filename = filename[i];
+    req[i].offset = 0;
+    req[i].size = 0;
+    req[i].buf = NULL;
+    req[i].data = data + i;
+  }
+  req[NFILE].filename = filename[1]; /* range read */
+  req[NFILE].offset = 100;
+  req[NFILE].size = 1000;
+  req[NFILE].buf = range;
+  req[NFILE].data = data + 101;
+  req[NFILE+1].filename = (char *)"stream_test_aio_nonexistent.dat";
+  req[NFILE+1].offset = 0;
+  req[NFILE+1].size = 0;
+  req[NFILE+1].buf = NULL;
+  req[NFILE+1].data = NULL;
+  if( !zStreamAIOInit( &aio, 4, 8 ) ) return false;
+  for( i=0; ; ){
+    if( i < NFILE+2 && zStreamAIOSubmit( &aio, &req[i] ) ){
+      i++;
+      continue;
+    }
+    if( !( rp = zStreamAIOWait( &aio ) ) ) break;
+    n++;
+    if( !rp->data ){
+      if( rp->error == 0 || rp->buf ) ret = false;
+      continue;
+    }
+    if( rp->error != 0 || rp->len != ( rp->buf == range ? 901 : 1000 + ( (byte *)rp->data - data ) ) ) ret = false;
+    if( memcmp( rp->buf, rp->data, rp->len ) ) ret = false;
+    if( rp->buf != range ){
+      zStreamAIOAttach( &str, rp );
+      if( zStreamGetc( &str ) != *(ubyte *)rp->data ) ret = false;
+      zStreamClose( &str );
+    }
+  }
+  if( n != NFILE+2 || zStreamAIOPending( &aio ) != 0 || zStreamAIOPoll( &aio ) ) ret = false;
+  zStreamAIODestroy( &aio );
+  for( i=0; i<NFILE; i++ ) remove( filename[i] );
+  return ret;
+}
+
+bool check_filter(void)
+{
+  zStream mem[2], *sink[2], tee, count, crc, lz, endian;
+  zStreamFilterStat stat;
+  static int32_t val[N], val_in[N];
+  byte *buf[2];
+  size_t i, size[2];
+  uint32_t checksum;
+  bool ret = true;
+
+  for( i=0; i<N; i++ ) val[i] = i % 1000 + ( i % 5000 < 1000 ? 0 : zRandI( 0, 3 ) );
+  zStreamOpenGrowMem( &mem[0], 0 ); sink[0] = &mem[0];
+  zStreamOpenGrowMem( &mem[1], 0 ); sink[1] = &mem[1];
+  /* endian -> lz -> crc -> count -> tee -> two memory streams */
+  zStreamOpenTeeFilter( &tee, sink, 2 );
+  zStreamOpenCountFilter( &count, &tee );
+  zStreamOpenCRCFilter( &crc, &count );
+  zStreamOpenLZFilter( &lz, &crc, 4096 );
+  zStreamOpenEndianFilter( &endian, &lz, Z_ENDIAN_BIG );
+  for( i=0; i<N; i+=1000 )
+    if( zStreamWrite( &endian, (byte *)(val+i), sizeof(int32_t), 1000 ) != 1000 ) ret = false;
+  if( zStreamTell( &lz ) != N * sizeof(int32_t) ) ret = false;
+  zStreamClose( &endian );
+  zStreamClose( &lz );
+  checksum = zStreamFilterCRC( &crc );
+  zStreamClose( &crc );
+  if( !zStreamFilterGetStat( &count, &stat ) || stat.nwrite == 0 || stat.nwrite >= N * sizeof(int32_t) ) ret = false;
+  zStreamClose( &count );
+  zStreamClose( &tee );
+  buf[0] = zStreamDetachBuf( &mem[0], &size[0] );
+  buf[1] = zStreamDetachBuf( &mem[1], &size[1] );
+  if( size[0] != stat.nwrite || size[1] != size[0] || memcmp( buf[0], buf[1], size[0] ) ) ret = false;
+  if( checksum != crc32c( 0, buf[0], size[0] ) ) ret = false;
+  /* big endian at the raw level */
+  zStreamAttachMem( &mem[0], buf[0], size[0] );
+  zStreamOpenLZFilter( &lz, &mem[0], 0 );
+  if( zStreamRead( &lz, (byte *)val_in, sizeof(int32_t), 1 ) != 1 || val_in[0] != ( endian_check() == Z_ENDIAN_BIG ? val[0] : (int32_t)endian_reverse32( val[0] ) ) ) ret = false;
+  zStreamClose( &lz );
+  /* reading back */
+  zStreamRewind( &mem[0] );
+  zStreamOpenCRCFilter( &crc, &mem[0] );
+  zStreamOpenLZFilter( &lz, &crc, 0 );
+  zStreamOpenEndianFilter( &endian, &lz, Z_ENDIAN_BIG );
+  if( zStreamRead( &endian, (byte *)val_in, sizeof(int32_t), N ) != N || memcmp( val, val_in, sizeof(val) ) ) ret = false;
+  if( zStreamRead( &endian, (byte *)val_in, sizeof(int32_t), 1 ) != 0 ) ret = false;
+  if( zStreamFilterCRC( &crc ) != checksum ) ret = false;
+  zStreamClose( &endian );
+  zStreamClose( &lz );
+  zStreamClose( &crc );
+  zStreamClose( &mem[0] );
+  free( buf[1] );
+  return ret;
+}
+
+bool check_filter_nogain(void)
+{
+  zStream mem, lz;
+  static byte val[N], val_in[N];
+  byte *buf;
+  size_t i, blksize, size;
+  bool ret = true;
+
+  /* short blocks of random bytes followed by a few repeated bytes, on which compression gains almost nothing */
+  for( i=0; i<N; i++ ) val[i] = i % 64 < 40 ? zRandI( 0, 255 ) : val[i-1];
+  for( blksize=8; blksize<=128; blksize++ ){
+    zStreamOpenGrowMem( &mem, 0 );
+    zStreamOpenLZFilter( &lz, &mem, blksize );
+    if( zStreamWrite( &lz, val, 1, N ) != N ) ret = false;
+    zStreamClose( &lz );
+    buf = zStreamDetachBuf( &mem, &size );
+    zStreamAttachMem( &mem, buf, size );
+    zStreamOpenLZFilter( &lz, &mem, 0 );
+    if( zStreamRead( &lz, val_in, 1, N ) != N || memcmp( val, val_in, N ) ) ret = false;
+    zStreamClose( &lz );
+    zStreamClose( &mem );
+  }
+  return ret;
+}
+
+bool check_filter_buffered(void)
+{
+  zStream mem, crc, count, lz;
+  zStreamFilterStat stat;
+  static byte data[] = "0123456789";
+  static byte broken[] = { 0xff, 0xff, 0xff, 0xff, 4, 0, 0, 0, 1, 2, 3, 4 };
+  byte c;
+  bool ret = true;
+
+  /* a read buffer is put on the filter by zStreamGetc() */
+  zStreamAttachMem( &mem, data, sizeof(data)-1 );
+  zStreamOpenCRCFilter( &crc, &mem );
+  if( zStreamGetc( &crc ) != '0' || zStreamGetc( &crc ) != '1' ) ret = false;
+  if( zStreamFilterCRC( &crc ) != crc32c( 0, data, sizeof(data)-1 ) ) ret = false; /* including read-ahead */
+  zStreamClose( &crc );
+  zStreamRewind( &mem );
+  zStreamOpenCountFilter( &count, &mem );
+  if( zStreamGetc( &count ) != '0' || zStreamGetc( &count ) != '1' || zStreamGetc( &count ) != '2' ) ret = false;
+  if( !zStreamFilterGetStat( &count, &stat ) || stat.nread != 3 ) ret = false;
+  zStreamClose( &count );
+  /* a block larger than the limit */
+  zStreamAttachMem( &mem, broken, sizeof(broken) );
+  zStreamOpenLZFilter( &lz, &mem, 0 );
+  if( zStreamRead( &lz, &c, 1, 1 ) != 0 ) ret = false;
+  zStreamClose( &lz );
+  return ret;
+}
+
+#define TEXT "% comment line\n  abc 123 -4.5e+3 \"quoted string\"  key: val\n+7e 1.5E-2"
+
+bool check_token(zStream *str)
+{
+  char buf[BUFSIZ];
+  int i;
+  double d;
+
+  if( !zStreamToken( str, buf, BUFSIZ ) || strcmp( buf, "abc" ) ) return false;
+  if( !zStreamInt( str, &i ) || i != 123 ) return false;
+  zStreamSkipWS( str );
+  if( strcmp( zStreamNumToken( str, buf, BUFSIZ ), "-4.5e+3" ) ) return false;
+  if( !zStreamToken( str, buf, BUFSIZ ) || strcmp( buf, "quoted string" ) ) return false;
+  if( !zStreamToken( str, buf, BUFSIZ ) || strcmp( buf, "key" ) || !zStreamPostCheckKey( str ) ) return false;
+  if( !zStreamToken( str, buf, BUFSIZ ) || strcmp( buf, "val" ) || zStreamPostCheckKey( str ) ) return false;
+  zStreamSkipWS( str );
+  if( strcmp( zStreamNumToken( str, buf, BUFSIZ ), "+7" ) || zStreamGetc( str ) != 'e' ) return false;
+  if( !zStreamDouble( str, &d ) || d != 1.5e-2 ) return false;
+  return zStreamToken( str, buf, BUFSIZ ) == NULL;
+}
+
+#define ZTKTEXT "[tag1]\nkey1: 1 2\nkey2: a\n[tag2]\nkey1: 3\n"
+
+bool check_ztk(zStream *str)
+{
+  ZTK ztk;
+  bool ret = false;
+
+  ZTKInit( &ztk );
+  if( !ZTKParseStream( &ztk, str ) ) goto TERMINATE;
+  if( ZTKCountTag( &ztk, "tag1" ) != 1 || ZTKCountTag( &ztk, "tag2" ) != 1 ) goto TERMINATE;
+  if( !ZTKTagRewind( &ztk ) ) goto TERMINATE;
+  do{
+    if( ZTKTagCmp( &ztk, "tag1" ) ){
+      if( ZTKCountKey( &ztk, "key1" ) != 1 || ZTKCountKey( &ztk, "key2" ) != 1 ) goto TERMINATE;
+      if( !ZTKKeyRewind( &ztk ) || !ZTKKeyCmp( &ztk, "key1" ) ) goto TERMINATE;
+      if( ZTKInt( &ztk ) != 1 || ZTKInt( &ztk ) != 2 ) goto TERMINATE;
+    }
+  } while( ZTKTagNext( &ztk ) );
+  ret = true;
+ TERMINATE:
+  ZTKDestroy( &ztk );
+  return ret;
+}
+
+int main(void)
+{
+  static byte data[N];
+  zStream str;
+  FILE *fp;
+  size_t i;
+
+  zRandInit();
+  for( i=0; i<N; i++ ) data[i] = zRandI( 0, 255 );
+  zStreamAttachMem( &str, data, N );
+  zAssert( zStreamGetc (memory), check_getc( &str, data, N ) );
+  zAssert( zStreamPeek + zStreamUngetc + zStreamRead (memory), check_mixed( &str, data, N ) );
+  zStreamUnsetBuffer( &str );
+
+  fp = fopen( "stream_test.dat", "w+b" );
+  fwrite( data, 1, N, fp );
+  zStreamAttachFile( &str, fp );
+  zAssert( zStreamGetc (file), check_getc( &str, data, N ) );
+  zAssert( zStreamPeek + zStreamUngetc + zStreamRead (file), check_mixed( &str, data, N ) );
+  zStreamSeek( &str, 100 );
+  zStreamGetc( &str );
+  zStreamUnsetBuffer( &str );
+  zAssert( zStreamUnsetBuffer, ftell( fp ) == 101 );
+  fclose( fp );
+
+  zStreamOpenFile( &str, "stream_test.dat", "rb" );
+  zStreamSetPrefetch( &str, 3, 4096 );
+  zAssert( zStreamSetPrefetch, check_getc( &str, data, N ) && check_mixed( &str, data, N ) );
+  zStreamClose( &str );
+  remove( "stream_test.dat" );
+
+  zAssert( zStreamOpenMmap + zStreamView, check_mmap( data, N ) );
+  zAssert( zStreamOpenGrowMem + zStreamDetachBuf, check_growmem( data, N ) );
+  zAssert( zStreamAIOSubmit + zStreamAIOWait, check_aio( data, N ) );
+  zAssert( filter streams, check_filter() );
+  zAssert( zStreamOpenLZFilter (incompressible blocks), check_filter_nogain() );
+  zAssert( filter streams (buffered and broken), check_filter_buffered() );
+
+  zStreamAttachMem( &str, (byte *)TEXT, strlen(TEXT) );
+  zAssert( zStreamToken + zStreamNumToken + zStreamPostCheckKey, check_token( &str ) );
+  zStreamUnsetBuffer( &str );
+  zStreamAttachMem( &str, (byte *)ZTKTEXT, strlen(ZTKTEXT) );
+  zAssert( ZTKParseStream, check_ztk( &str ) );
+  zStreamUnsetBuffer( &str );
+  fp = fopen( "stream_test.ztk", "w" );
+  for( i=0; i<1000; i++ ) fprintf( fp, "%s", i == 0 ? ZTKTEXT : "[tag3]\nkey3: 1 2 3 4\n" );
+  fclose( fp );
+  zStreamOpenFile( &str, "stream_test.ztk", "r" );
+  zStreamSetPrefetch( &str, 0, 1000 );
+  zAssert( ZTKParseStream (prefetched), check_ztk( &str ) );
+  zStreamClose( &str );
+  remove( "stream_test.ztk" );
+  return EXIT_SUCCESS;
+}
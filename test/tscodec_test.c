@@ -0,0 +1,58 @@
+#include <zeda/zeda.h>
+#include <math.h>
+
+#define N 10000
+
+bool check_double(double src[], size_t n, size_t *size)
+{
+  static ubyte buf[zTSCompressBound(N)];
+  static double dst[N];
+
+  if( ( *size = zTSDoubleCompress( src, n, buf, zTSCompressBound(n) ) ) == 0 ) return false;
+  return zTSDoubleDecompress( buf, *size, dst, n ) == n && memcmp( src, dst, sizeof(double)*n ) == 0;
+}
+
+bool check_int64(int64_t src[], size_t n, size_t *size)
+{
+  static ubyte buf[zTSCompressBound(N)];
+  static int64_t dst[N];
+
+  if( ( *size = zTSInt64Compress( src, n, buf, zTSCompressBound(n) ) ) == 0 ) return false;
+  return zTSInt64Decompress( buf, *size, dst, n ) == n && memcmp( src, dst, sizeof(int64_t)*n ) == 0;
+}
+
+int main(void)
+{
+  static double dval[N], dout[N];
+  static int64_t ival[N];
+  static ubyte buf[zTSCompressBound(N)];
+  size_t i, size;
+  bool result;
+
+  zRandInit();
+  for( i=0; i<N; i++ ) dval[i] = zRandF( -1.0e10, 1.0e10 );
+  zAssert( zTSDoubleCompress + zTSDoubleDecompress (random), check_double( dval, N, &size ) );
+  for( i=0; i<N; i++ ) dval[i] = i % 10 < 5 ? 1.0 : 0.5 * ( i / 10 );
+  zAssert( zTSDoubleCompress + zTSDoubleDecompress (slowly changing), check_double( dval, N, &size ) && size < N*8/5 );
+  for( i=0; i<N; i++ ) dval[i] = 3.14;
+  zAssert( zTSDoubleCompress (constant), check_double( dval, N, &size ) && size < N/8 + 16 );
+  dval[0] = 0; dval[1] = -0.0; dval[2] = HUGE_VAL; dval[3] = -HUGE_VAL; dval[4] = 1.0e-300; dval[5] = 0;
+  zAssert( zTSDoubleCompress + zTSDoubleDecompress (special values), check_double( dval, 6, &size ) );
+  result = true;
+  for( i=1; i<50; i++ )
+    if( !check_double( dval, i, &size ) ) result = false;
+  zAssert( zTSDoubleCompress + zTSDoubleDecompress (short series), result );
+
+  for( i=0; i<N; i++ ) ival[i] = 1600000000000LL + 10 * i + ( i % 100 == 0 ? zRandI( -3, 3 ) : 0 );
+  zAssert( zTSInt64Compress + zTSInt64Decompress (timestamps), check_int64( ival, N, &size ) && size < N/4 );
+  for( i=0; i<N; i++ ) ival[i] = (int64_t)zRandI( -100000, 100000 ) * zRandI( -100000, 100000 );
+  zAssert( zTSInt64Compress + zTSInt64Decompress (random), check_int64( ival, N, &size ) );
+  ival[0] = 0x7fffffffffffffffLL; ival[1] = -ival[0] - 1; ival[2] = 0; ival[3] = ival[1]; ival[4] = ival[0];
+  zAssert( zTSInt64Compress + zTSInt64Decompress (extreme values), check_int64( ival, 5, &size ) && check_int64( ival, 1, &size ) );
+
+  for( i=0; i<N; i++ ) dval[i] = sin( 0.001 * i );
+  size = zTSDoubleCompress( dval, N, buf, zTSCompressBound(N) );
+  zAssert( zTSDoubleCompress (insufficient buffer), zTSDoubleCompress( dval, N, buf, size - 1 ) == 0 );
+  zAssert( zTSDoubleDecompress (truncated data), zTSDoubleDecompress( buf, size / 2, dout, N ) < N );
+  return EXIT_SUCCESS;
+}